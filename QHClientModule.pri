@@ -14,14 +14,24 @@ SOURCES += \
     $$PWD/src/Core/StandaloneDevice.cpp \
     $$PWD/src/Helpers/QHSettings.cpp \
     $$PWD/src/Helpers/RoleFilter.cpp \
+    $$PWD/src/Helpers/Metrics.cpp \
+    $$PWD/src/Helpers/ResourceCache.cpp \
+    $$PWD/src/Helpers/ChangeCoalescer.cpp \
     $$PWD/src/Models/DeviceLogic.cpp \
     $$PWD/src/Models/DeviceLogicProperty.cpp \
     $$PWD/src/Models/SynchronizedListModel.cpp \
     $$PWD/src/Models/SynchronizedObjectModel.cpp \
     $$PWD/src/Shared/Connection.cpp \
     $$PWD/src/Shared/VirtualConnection.cpp \
+    $$PWD/src/Shared/MessageCodec.cpp \
+    $$PWD/src/Shared/FrameDecoder.cpp \
+    $$PWD/src/Shared/FrameRecorder.cpp \
+    $$PWD/src/Shared/FrameReplayer.cpp \
+    $$PWD/src/Shared/SendQueue.cpp \
     $$PWD/src/Core/ResourceCommunicationHandler.cpp \
     $$PWD/src/Core/BaseCommunicationHandler.cpp \
+    $$PWD/src/Core/SubscriptionRegistry.cpp \
+    $$PWD/src/Core/AttachQueue.cpp \
     $$PWD/src/Models/AbstractListModel.cpp \
     $$PWD/src/Models/DeviceListModel.cpp \
     $$PWD/src/Models/UserListModel.cpp \
@@ -29,6 +39,9 @@ SOURCES += \
     $$PWD/src/Models/DeviceHandleListModel.cpp \
     $$PWD/src/Models/SynchronizedListLogic.cpp \
     $$PWD/src/Models/SynchronizedListModel2.cpp \
+    $$PWD/src/Models/SynchronizedListStore.cpp \
+    $$PWD/src/Models/ColumnStore.cpp \
+    $$PWD/src/Models/UuidIndex.cpp \
     $$PWD/src/Models/Device.cpp \
     $$PWD/src/Models/DevicePropertyModel.cpp \
  #   $$PWD/src/Helpers/AutomationRule.cpp \
@@ -49,6 +62,9 @@ HEADERS += \
     $$PWD/src/Core/StandaloneDevice.h \
     $$PWD/src/Helpers/QHSettings.h \
     $$PWD/src/Helpers/RoleFilter.h \
+    $$PWD/src/Helpers/Metrics.h \
+    $$PWD/src/Helpers/ResourceCache.h \
+    $$PWD/src/Helpers/ChangeCoalescer.h \
     $$PWD/src/InitQuickHub.h \
     $$PWD/src/Models/DeviceLogic.h \
     $$PWD/src/Models/DeviceLogicProperty.h \
@@ -56,8 +72,15 @@ HEADERS += \
     $$PWD/src/Models/SynchronizedObjectModel.h \
     $$PWD/src/Shared/Connection.h \
     $$PWD/src/Shared/VirtualConnection.h \
+    $$PWD/src/Shared/MessageCodec.h \
+    $$PWD/src/Shared/FrameDecoder.h \
+    $$PWD/src/Shared/FrameRecorder.h \
+    $$PWD/src/Shared/FrameReplayer.h \
+    $$PWD/src/Shared/SendQueue.h \
     $$PWD/src/Core/ResourceCommunicationHandler.h \
     $$PWD/src/Core/BaseCommunicationHandler.h \
+    $$PWD/src/Core/SubscriptionRegistry.h \
+    $$PWD/src/Core/AttachQueue.h \
     $$PWD/src/Models/AbstractListModel.h \
     $$PWD/src/Models/DeviceListModel.h \
     $$PWD/src/Models/UserListModel.h \
@@ -65,6 +88,9 @@ HEADERS += \
     $$PWD/src/Models/DeviceHandleListModel.h \
     $$PWD/src/Models/SynchronizedListLogic.h \
     $$PWD/src/Models/SynchronizedListModel2.h \
+    $$PWD/src/Models/SynchronizedListStore.h \
+    $$PWD/src/Models/ColumnStore.h \
+    $$PWD/src/Models/UuidIndex.h \
     $$PWD/src/Models/Device.h \
     $$PWD/src/Models/DevicePropertyModel.h \
   #  $$PWD/src/Helpers/AutomationRule.h \
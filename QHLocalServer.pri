@@ -0,0 +1,18 @@
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at https://mozilla.org/MPL/2.0/.
+# It is part of the QuickHub framework - www.quickhub.org
+# Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de
+
+# In-process server stand-in for load and latency tests. It uses the
+# Connection classes of QHClientModule.pri, which has to be included as well.
+
+QT += websockets
+
+SOURCES += \
+    $$PWD/src/Testing/LocalServer.cpp
+
+HEADERS += \
+    $$PWD/src/Testing/LocalServer.h
+
+INCLUDEPATH += $$PWD/src/Testing
@@ -0,0 +1,90 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * It is part of the QuickHub framework - www.quickhub.org
+ * Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de */
+
+
+#include "SyntheticData.h"
+#include <QUuid>
+
+QVariantMap SyntheticData::row(int index, int fieldCount)
+{
+    QVariantMap row;
+    row["id"] = index;
+    row["name"] = QStringLiteral("Item %1").arg(index);
+    row["value"] = double((index * 7919) % 10000) / 100;
+    row["flag"] = index % 3 == 0;
+    row["text"] = QStringLiteral("text-%1-%2").arg(index % 97).arg(index);
+    for(int i = 0; i < fieldCount; i++)
+    {
+        row[QStringLiteral("field%1").arg(i)] = (index + i) % 1000;
+    }
+    return row;
+}
+
+QVariantList SyntheticData::rows(int count, int fieldCount)
+{
+    QVariantList rows;
+    rows.reserve(count);
+    for(int i = 0; i < count; i++)
+    {
+        rows << row(i, fieldCount);
+    }
+    return rows;
+}
+
+QString SyntheticData::uuid(int index)
+{
+    return QUuid::createUuidV5(QUuid(), QString::number(index)).toString();
+}
+
+QVariantList SyntheticData::syncListItems(int count, int fieldCount)
+{
+    QVariantList items;
+    items.reserve(count);
+    for(int i = 0; i < count; i++)
+    {
+        QVariantMap item;
+        item["uuid"] = uuid(i);
+        item["userid"] = "benchmark";
+        item["lastupdate"] = qint64(1600000000000) + i;
+        item["data"] = row(i, fieldCount);
+        items << item;
+    }
+    return items;
+}
+
+QVariantMap SyntheticData::deviceDump(int index, int propertyCount)
+{
+    QVariantList properties;
+    for(int i = 0; i < propertyCount; i++)
+    {
+        QVariantMap property;
+        property["name"] = QStringLiteral("property%1").arg(i);
+        property["val"] = (index + i) % 100;
+        property["setVal"] = (index + i) % 100;
+        property["dirty"] = false;
+        property["timestamp"] = qint64(1600000000000) + i;
+        properties << property;
+    }
+
+    QVariantMap parameters;
+    parameters["props"] = properties;
+    parameters["funcs"] = QVariantList();
+    parameters["on"] = true;
+    parameters["desc"] = QStringLiteral("Device %1").arg(index);
+    parameters["uuid"] = uuid(index);
+    parameters["suid"] = uuid(index).mid(1, 8);
+    parameters["type"] = "BenchmarkDevice";
+    parameters["tmp"] = false;
+    return message("device:dump", parameters);
+}
+
+QVariantMap SyntheticData::message(const QString &command, const QVariantMap &parameters)
+{
+    QVariantMap msg;
+    msg["command"] = command;
+    msg["parameters"] = parameters;
+    return msg;
+}
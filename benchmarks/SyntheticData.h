@@ -0,0 +1,38 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * It is part of the QuickHub framework - www.quickhub.org
+ * Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de */
+
+
+#ifndef SYNTHETICDATA_H
+#define SYNTHETICDATA_H
+
+#include <QVariant>
+#include <QString>
+
+/*!
+    \class SyntheticData
+    \brief Generates the rows and messages the benchmarks feed into the models.
+
+    All values are derived from the row index, so every run works on the same data.
+    A row has the fields id, name, value, flag and text plus fieldCount integer fields.
+*/
+
+class SyntheticData
+{
+public:
+    static QVariantMap  row(int index, int fieldCount = 4);
+    static QVariantList rows(int count, int fieldCount = 4);
+    static QString      uuid(int index);
+
+    /*!
+        \fn QVariantList SyntheticData::syncListItems(int count)
+        Returns rows wrapped like the items of a synclist resource (uuid, userid, lastupdate, data).
+    */
+    static QVariantList syncListItems(int count, int fieldCount = 4);
+    static QVariantMap  deviceDump(int index, int propertyCount);
+    static QVariantMap  message(const QString& command, const QVariantMap& parameters);
+};
+
+#endif // SYNTHETICDATA_H
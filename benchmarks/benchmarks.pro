@@ -0,0 +1,24 @@
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at https://mozilla.org/MPL/2.0/.
+# It is part of the QuickHub framework - www.quickhub.org
+# Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de
+
+# QBENCHMARK suite for the model hot paths. Run it with "make check" or
+# directly, e.g. ./tst_modelbenchmarks -median 5 syncListDump
+# QH_BENCHMARK_MAX_ROWS limits the list sizes, which go up to 1M rows.
+
+TEMPLATE = app
+TARGET = tst_modelbenchmarks
+QT += testlib qml quick websockets
+CONFIG += console testcase c++11
+CONFIG -= app_bundle
+
+include(../QHClientModule.pri)
+
+SOURCES += \
+    SyntheticData.cpp \
+    tst_modelbenchmarks.cpp
+
+HEADERS += \
+    SyntheticData.h
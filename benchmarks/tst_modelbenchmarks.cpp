@@ -0,0 +1,908 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * It is part of the QuickHub framework - www.quickhub.org
+ * Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de */
+
+
+#include <QtTest>
+#include <QLoggingCategory>
+
+#include "SyntheticData.h"
+#include "SynchronizedListLogic.h"
+#include "SynchronizedListModel2.h"
+#include "AbstractListModel.h"
+#include "DeviceModel.h"
+#include "DeviceAdapterModel.h"
+#include "SynchronizedObjectModel.h"
+#include "SubscriptionRegistry.h"
+#include "RoleFilter.h"
+#include "ChangeCoalescer.h"
+#include "Shared/Connection.h"
+#include "Shared/FrameDecoder.h"
+#include "Shared/SendQueue.h"
+#include "Shared/VirtualConnection.h"
+#include "Metrics.h"
+
+namespace
+{
+    int maxRows()
+    {
+        if(qEnvironmentVariableIsSet("QH_BENCHMARK_MAX_ROWS"))
+            return qEnvironmentVariableIntValue("QH_BENCHMARK_MAX_ROWS");
+
+        return 1000000;
+    }
+
+    // the message handlers of the models are private slots
+    void deliver(QObject* receiver, const char* slot, const QVariantMap& message)
+    {
+        QMetaObject::invokeMethod(receiver, slot, Qt::DirectConnection, Q_ARG(QVariant, message));
+    }
+
+    void fillSyncList(SynchronizedListLogic* logic, int rows)
+    {
+        QVariantMap parameters;
+        parameters["data"] = SyntheticData::syncListItems(rows);
+        deliver(logic, "messageReceived", SyntheticData::message("synclist:dump", parameters));
+    }
+
+    // at most 1000 rows spread over the whole list are read per iteration
+    QVector<int> sampleRows(int rows)
+    {
+        QVector<int> sample;
+        int step = qMax(1, rows / 1000);
+        for(int i = 0; i < rows; i += step)
+        {
+            sample << i;
+        }
+        return sample;
+    }
+
+    // lets the connection believe the other side has answered its negotiation
+    void negotiated(Connection& connection, MessageCodec::Format codec, bool batch, const QVariantMap& session = QVariantMap())
+    {
+        QVariantMap parameters = session;
+        parameters["codec"] = MessageCodec::formatName(codec);
+        parameters["batch"] = batch;
+        parameters["fragments"] = false;
+
+        QVariantMap msg;
+        msg["command"] = "connection:negotiated";
+        msg["parameters"] = parameters;
+        connection.injectFrame(MessageCodec::encode(msg, MessageCodec::FORMAT_JSON));
+    }
+
+    QVariantMap sendMessage(int index)
+    {
+        QVariantMap msg;
+        msg["command"] = "send";
+        msg["uuid"] = SyntheticData::uuid(index);
+        msg["payload"] = SyntheticData::message("object:set", SyntheticData::row(index));
+        return msg;
+    }
+
+    // the uuids (or channels) of all send messages in the written frames, in the order the other side reads them
+    QStringList sentUuids(const QList<QByteArray>& frames, bool* ok)
+    {
+        *ok = true;
+        QStringList uuids;
+        for(const QByteArray& frame : frames)
+        {
+            const FrameDecoder::Result result = FrameDecoder::decodeFrame(frame, true);
+            if(!result.ok)
+                *ok = false;
+
+            for(const MessageEnvelope& envelope : result.envelopes)
+            {
+                if(envelope.command() != QStringLiteral("send"))
+                    continue;
+
+                uuids << (envelope.channel() >= 0 ? QString::number(envelope.channel()) : envelope.uuid());
+            }
+        }
+        return uuids;
+    }
+
+    class BenchmarkListModel : public AbstractListModel
+    {
+    public:
+        explicit BenchmarkListModel(QObject* parent = nullptr) : AbstractListModel(parent) {}
+    };
+}
+
+class ModelBenchmarks : public QObject
+{
+    Q_OBJECT
+
+private:
+    void addRowCounts();
+
+private slots:
+    void initTestCase();
+
+    void syncListDump_data();
+    void syncListDump();
+    void syncListAppend_data();
+    void syncListAppend();
+    void syncListPropertySet_data();
+    void syncListPropertySet();
+    void syncListPropertySetStaleIndex_data();
+    void syncListPropertySetStaleIndex();
+
+    void syncListModelData_data();
+    void syncListModelData();
+    void syncListModelRoleNames_data();
+    void syncListModelRoleNames();
+    void syncListModelPropertyBurst_data();
+    void syncListModelPropertyBurst();
+
+    void abstractListDump_data();
+    void abstractListDump();
+    void abstractListPropertySet_data();
+    void abstractListPropertySet();
+
+    void deviceAdapterData_data();
+    void deviceAdapterData();
+
+    void roleFilterAcceptsRow_data();
+    void roleFilterAcceptsRow();
+    void roleFilterLessThan_data();
+    void roleFilterLessThan();
+
+    void connectionDecode_data();
+    void connectionDecode();
+    void frameDecodeMaterialized_data();
+    void frameDecodeMaterialized();
+    void envelopeBackendsAgree();
+
+    void connectionRenegotiateBatch();
+    void connectionRenegotiateCodec();
+    void sendQueueRestartFragments();
+    void connectionEndSuspension();
+    void connectionResumeDropsStaleFrames();
+    void subchannelClose();
+    void metricsRefuseSecondType();
+    void sharedObjectModels();
+    void sharedListModels();
+    void subscriptionRegistryReplay();
+};
+
+void ModelBenchmarks::addRowCounts()
+{
+    QTest::addColumn<int>("rows");
+
+    const QList<QPair<const char*, int>> counts = {{"1k", 1000}, {"10k", 10000}, {"100k", 100000}, {"1M", 1000000}};
+    for(const auto& count : counts)
+    {
+        if(count.second <= maxRows())
+            QTest::newRow(count.first) << count.second;
+    }
+}
+
+void ModelBenchmarks::initTestCase()
+{
+    // RoleFilter::lessThan and the attach handling log every call
+    QLoggingCategory::setFilterRules(QStringLiteral("default.debug=false"));
+}
+
+void ModelBenchmarks::syncListDump_data()
+{
+    addRowCounts();
+}
+
+void ModelBenchmarks::syncListDump()
+{
+    QFETCH(int, rows);
+    SynchronizedListLogic logic;
+    QVariantMap parameters;
+    parameters["data"] = SyntheticData::syncListItems(rows);
+    const QVariantMap message = SyntheticData::message("synclist:dump", parameters);
+
+    QBENCHMARK {
+        deliver(&logic, "messageReceived", message);
+    }
+}
+
+void ModelBenchmarks::syncListAppend_data()
+{
+    addRowCounts();
+}
+
+void ModelBenchmarks::syncListAppend()
+{
+    QFETCH(int, rows);
+    SynchronizedListLogic logic;
+    fillSyncList(&logic, rows);
+
+    QVariantMap item = SyntheticData::syncListItems(1).first().toMap();
+    QVariantMap parameters;
+    parameters["data"] = item;
+    const QVariantMap message = SyntheticData::message("synclist:append", parameters);
+
+    QBENCHMARK {
+        deliver(&logic, "messageReceived", message);
+    }
+}
+
+void ModelBenchmarks::syncListPropertySet_data()
+{
+    addRowCounts();
+}
+
+void ModelBenchmarks::syncListPropertySet()
+{
+    QFETCH(int, rows);
+    SynchronizedListLogic logic;
+    fillSyncList(&logic, rows);
+
+    QVariantMap parameters;
+    parameters["index"] = rows / 2;
+    parameters["uuid"] = SyntheticData::uuid(rows / 2);
+    parameters["property"] = "value";
+    parameters["data"] = 42.0;
+    parameters["lastupdate"] = qint64(1600000000000);
+    const QVariantMap message = SyntheticData::message("synclist:property:set", parameters);
+
+    QBENCHMARK {
+        deliver(&logic, "messageReceived", message);
+    }
+}
+
+void ModelBenchmarks::syncListPropertySetStaleIndex_data()
+{
+    addRowCounts();
+}
+
+void ModelBenchmarks::syncListPropertySetStaleIndex()
+{
+    QFETCH(int, rows);
+    SynchronizedListLogic logic;
+    fillSyncList(&logic, rows);
+
+    // the index is off, so the row has to be searched by its uuid
+    QVariantMap parameters;
+    parameters["index"] = 0;
+    parameters["uuid"] = SyntheticData::uuid(rows - 1);
+    parameters["property"] = "value";
+    parameters["data"] = 42.0;
+    parameters["lastupdate"] = qint64(1600000000000);
+    const QVariantMap message = SyntheticData::message("synclist:property:set", parameters);
+
+    QBENCHMARK {
+        deliver(&logic, "messageReceived", message);
+    }
+}
+
+void ModelBenchmarks::syncListModelData_data()
+{
+    addRowCounts();
+}
+
+void ModelBenchmarks::syncListModelData()
+{
+    QFETCH(int, rows);
+    SynchronizedListModel2 model;
+    fillSyncList(model.findChild<SynchronizedListLogic*>(), rows);
+    QCOMPARE(model.rowCount(), rows);
+
+    const QList<int> roles = model.roleNames().keys();
+    const QVector<int> sample = sampleRows(rows);
+    QBENCHMARK {
+        for(int row : sample)
+        {
+            QModelIndex index = model.index(row);
+            for(int role : roles)
+            {
+                model.data(index, role);
+            }
+        }
+    }
+}
+
+void ModelBenchmarks::syncListModelRoleNames_data()
+{
+    addRowCounts();
+}
+
+void ModelBenchmarks::syncListModelRoleNames()
+{
+    QFETCH(int, rows);
+    SynchronizedListModel2 model;
+    fillSyncList(model.findChild<SynchronizedListLogic*>(), rows);
+
+    QBENCHMARK {
+        model.roleNames();
+    }
+}
+
+void ModelBenchmarks::syncListModelPropertyBurst_data()
+{
+    QTest::addColumn<bool>("coalesced");
+    QTest::newRow("direct") << false;
+    QTest::newRow("coalesced") << true;
+}
+
+void ModelBenchmarks::syncListModelPropertyBurst()
+{
+    // 5000 updates of 100 adjacent rows, e.g. a device list which reports its values
+    QFETCH(bool, coalesced);
+    const int rows = 1000;
+    SynchronizedListModel2 model;
+    model.setCoalesceChanges(coalesced);
+    SynchronizedListLogic* logic = model.findChild<SynchronizedListLogic*>();
+    fillSyncList(logic, rows);
+
+    QList<QVariantMap> messages;
+    for(int i = 0; i < 5000; i++)
+    {
+        QVariantMap parameters;
+        parameters["index"] = 400 + i % 100;
+        parameters["uuid"] = SyntheticData::uuid(400 + i % 100);
+        parameters["property"] = "value";
+        parameters["data"] = double(i);
+        parameters["lastupdate"] = qint64(1600000000000) + i;
+        messages << SyntheticData::message("synclist:property:set", parameters);
+    }
+
+    int emitted = 0;
+    connect(&model, &QAbstractItemModel::dataChanged, [&emitted]() { emitted++; });
+    ChangeCoalescer* coalescer = model.findChild<ChangeCoalescer*>();
+    QBENCHMARK {
+        emitted = 0;
+        for(const QVariantMap& message : qAsConst(messages))
+        {
+            deliver(logic, "messageReceived", message);
+        }
+        coalescer->flush();
+    }
+
+    QCOMPARE(emitted, coalesced ? 1 : messages.count());
+}
+
+void ModelBenchmarks::abstractListDump_data()
+{
+    addRowCounts();
+}
+
+void ModelBenchmarks::abstractListDump()
+{
+    QFETCH(int, rows);
+    BenchmarkListModel model;
+    QVariantMap parameters;
+    parameters["data"] = SyntheticData::rows(rows);
+    const QVariantMap message = SyntheticData::message("list:dump", parameters);
+
+    QBENCHMARK {
+        deliver(&model, "messageHandler", message);
+    }
+}
+
+void ModelBenchmarks::abstractListPropertySet_data()
+{
+    addRowCounts();
+}
+
+void ModelBenchmarks::abstractListPropertySet()
+{
+    QFETCH(int, rows);
+    BenchmarkListModel model;
+    QVariantMap dump;
+    dump["data"] = SyntheticData::rows(rows);
+    deliver(&model, "messageHandler", SyntheticData::message("list:dump", dump));
+
+    QVariantMap parameters;
+    parameters["index"] = rows / 2;
+    parameters["property"] = "value";
+    parameters["data"] = 42.0;
+    const QVariantMap message = SyntheticData::message("list:property:set", parameters);
+
+    QBENCHMARK {
+        deliver(&model, "messageHandler", message);
+    }
+}
+
+void ModelBenchmarks::deviceAdapterData_data()
+{
+    QTest::addColumn<int>("devices");
+    QTest::newRow("100") << 100;
+    QTest::newRow("1k") << 1000;
+    QTest::newRow("10k") << 10000;
+}
+
+void ModelBenchmarks::deviceAdapterData()
+{
+    QFETCH(int, devices);
+    DeviceAdapterModel adapter;
+    QList<DeviceModel*> models;
+    for(int i = 0; i < devices; i++)
+    {
+        DeviceModel* model = new DeviceModel(&adapter);
+        deliver(model, "messageReceived", SyntheticData::deviceDump(i, 20));
+        adapter.addDeviceModel(model);
+    }
+
+    const QList<int> roles = adapter.roleNames().keys();
+    const QVector<int> sample = sampleRows(devices);
+    QBENCHMARK {
+        for(int row : sample)
+        {
+            QModelIndex index = adapter.index(row);
+            for(int role : roles)
+            {
+                adapter.data(index, role);
+            }
+        }
+    }
+}
+
+void ModelBenchmarks::roleFilterAcceptsRow_data()
+{
+    addRowCounts();
+}
+
+void ModelBenchmarks::roleFilterAcceptsRow()
+{
+    QFETCH(int, rows);
+    SynchronizedListModel2 model;
+    fillSyncList(model.findChild<SynchronizedListLogic*>(), rows);
+
+    RoleFilter filter;
+    filter.setSourceModel(&model);
+    filter.setStringFilterSearchRole("name, text");
+    filter.setSearchString("text-42-");
+
+    QBENCHMARK {
+        for(int row = 0; row < rows; row++)
+        {
+            filter.filterAcceptsRow(row, QModelIndex());
+        }
+    }
+}
+
+void ModelBenchmarks::roleFilterLessThan_data()
+{
+    addRowCounts();
+}
+
+void ModelBenchmarks::roleFilterLessThan()
+{
+    QFETCH(int, rows);
+    SynchronizedListModel2 model;
+    fillSyncList(model.findChild<SynchronizedListLogic*>(), rows);
+
+    RoleFilter filter;
+    filter.setSourceModel(&model);
+    filter.setSortRoleString("value");
+
+    const QVector<int> sample = sampleRows(rows);
+    QBENCHMARK {
+        for(int i = 1; i < sample.count(); i++)
+        {
+            filter.lessThan(model.index(sample.at(i - 1)), model.index(sample.at(i)));
+        }
+    }
+}
+
+void ModelBenchmarks::connectionDecode_data()
+{
+    QTest::addColumn<int>("rows");
+    QTest::addColumn<int>("codec");
+
+    const QList<QPair<QByteArray, int>> counts = {{"1k", 1000}, {"10k", 10000}, {"100k", 100000}, {"1M", 1000000}};
+    for(const auto& count : counts)
+    {
+        if(count.second > maxRows())
+            continue;
+
+        QTest::newRow((count.first + " json").constData()) << count.second << int(MessageCodec::FORMAT_JSON);
+        QTest::newRow((count.first + " cbor").constData()) << count.second << int(MessageCodec::FORMAT_CBOR);
+    }
+}
+
+void ModelBenchmarks::connectionDecode()
+{
+    QFETCH(int, rows);
+    QFETCH(int, codec);
+
+    QVariantMap parameters;
+    parameters["data"] = SyntheticData::syncListItems(rows);
+    QVariantMap msg;
+    msg["command"] = "send";
+    msg["uuid"] = SyntheticData::uuid(0);
+    msg["payload"] = SyntheticData::message("synclist:dump", parameters);
+    const QByteArray frame = MessageCodec::encode(msg, MessageCodec::Format(codec));
+
+    // no virtual connection is registered, so this measures decoding and routing
+    Connection connection;
+    QBENCHMARK {
+        connection.injectFrame(frame);
+    }
+}
+
+void ModelBenchmarks::frameDecodeMaterialized_data()
+{
+    connectionDecode_data();
+}
+
+void ModelBenchmarks::frameDecodeMaterialized()
+{
+    QFETCH(int, rows);
+    QFETCH(int, codec);
+
+    QVariantMap parameters;
+    parameters["data"] = SyntheticData::syncListItems(rows);
+    QVariantMap msg;
+    msg["command"] = "send";
+    msg["uuid"] = SyntheticData::uuid(0);
+    msg["payload"] = SyntheticData::message("synclist:dump", parameters);
+    const QByteArray frame = MessageCodec::encode(msg, MessageCodec::Format(codec));
+
+    QBENCHMARK {
+        FrameDecoder::decodeFrame(frame, true);
+    }
+}
+
+void ModelBenchmarks::envelopeBackendsAgree()
+{
+    QVariantMap payload;
+    payload["value"] = 1;
+    QVariantMap msg;
+    msg["command"] = "send";
+    msg["uuid"] = SyntheticData::uuid(0);
+    msg["msguid"] = SyntheticData::uuid(1);
+    msg["ch"] = 3;
+    msg["seq"] = 5;
+    msg["payload"] = payload;
+
+    const QByteArray json = MessageCodec::encode(msg, MessageCodec::FORMAT_JSON);
+    const QByteArray cbor = MessageCodec::encode(msg, MessageCodec::FORMAT_CBOR);
+
+    QList<MessageEnvelope> envelopes;
+    envelopes.append(MessageEnvelope(MessageCodec::decode(json)));
+    envelopes.append(MessageCodec::decodeEnvelope(json));
+    envelopes.append(MessageCodec::decodeEnvelope(cbor));
+
+    const QVariantMap expected = envelopes.first().toMap();
+    QCOMPARE(expected.count(), msg.count());
+
+    for(const MessageEnvelope& envelope : envelopes)
+    {
+        QCOMPARE(envelope.toMap(), expected);
+        for(const QString& key : msg.keys())
+        {
+            QCOMPARE(envelope.value(key), expected.value(key));
+        }
+        QVERIFY(!envelope.value("missing").isValid());
+    }
+}
+
+void ModelBenchmarks::connectionRenegotiateBatch()
+{
+    Connection connection;
+    connection.setReplayMode(true);
+    connection.setBatching(true, 64 * 1024, 60000);
+    negotiated(connection, MessageCodec::FORMAT_JSON, true);
+
+    QList<QByteArray> written;
+    QObject::connect(&connection, &Connection::frameWritten, [&written](const QByteArray& frame) { written << frame; });
+
+    QStringList expected;
+    for(int i = 0; i < 3; i++)
+    {
+        connection.sendVariant(sendMessage(i));
+        expected << SyntheticData::uuid(i);
+    }
+    QVERIFY(written.isEmpty());
+
+    // the other side does not unpack batches anymore, so the batch goes out first
+    negotiated(connection, MessageCodec::FORMAT_JSON, false);
+    QCOMPARE(written.count(), 1);
+    for(int i = 3; i < 6; i++)
+    {
+        connection.sendVariant(sendMessage(i));
+        expected << SyntheticData::uuid(i);
+    }
+    QMetaObject::invokeMethod(&connection, "flushBatch", Qt::DirectConnection);
+
+    bool ok;
+    QCOMPARE(sentUuids(written, &ok), expected);
+    QVERIFY(ok);
+}
+
+void ModelBenchmarks::connectionRenegotiateCodec()
+{
+    Connection connection;
+    connection.setReplayMode(true);
+    connection.setBatching(true, 64 * 1024, 60000);
+    negotiated(connection, MessageCodec::FORMAT_JSON, true);
+
+    QList<QByteArray> written;
+    QObject::connect(&connection, &Connection::frameWritten, [&written](const QByteArray& frame) { written << frame; });
+
+    QStringList expected;
+    for(int i = 0; i < 3; i++)
+    {
+        connection.sendVariant(sendMessage(i));
+        expected << SyntheticData::uuid(i);
+    }
+
+    // the JSON frames in the batch must not end up in a CBOR batch
+    negotiated(connection, MessageCodec::FORMAT_CBOR, true);
+    QCOMPARE(connection.getCodec(), MessageCodec::FORMAT_CBOR);
+    for(int i = 3; i < 6; i++)
+    {
+        connection.sendVariant(sendMessage(i));
+        expected << SyntheticData::uuid(i);
+    }
+    QMetaObject::invokeMethod(&connection, "flushBatch", Qt::DirectConnection);
+
+    bool ok;
+    QCOMPARE(sentUuids(written, &ok), expected);
+    QVERIFY(ok);
+    QCOMPARE(written.count(), 2);
+}
+
+void ModelBenchmarks::sendQueueRestartFragments()
+{
+    QByteArray frame;
+    for(int i = 0; i < 10000; i++)
+    {
+        frame.append(char(i % 251));
+    }
+
+    SendQueue queue;
+    queue.enqueue(frame, SendQueue::LANE_BULK, QStringList(QStringLiteral("1")));
+
+    quint32 firstId;
+    bool last;
+    QByteArray data;
+    QVERIFY(MessageCodec::readFragment(queue.take(SendQueue::LANE_BULK, 4096), &firstId, &last, &data));
+    QVERIFY(!last);
+
+    // the connection has been lost, the other side has dropped the first fragment
+    queue.restartFragments();
+    QCOMPARE(queue.bytes(), qint64(frame.size()));
+
+    QByteArray joined;
+    quint32 id;
+    last = false;
+    while(!last)
+    {
+        QVERIFY(MessageCodec::readFragment(queue.take(SendQueue::LANE_BULK, 4096), &id, &last, &data));
+        QVERIFY(id != firstId);
+        joined.append(data);
+    }
+
+    QCOMPARE(joined, frame);
+    QVERIFY(queue.isEmpty());
+}
+
+void ModelBenchmarks::connectionEndSuspension()
+{
+    Connection connection;
+    connection.setReplayMode(true);
+    connection.setSessionResumption(true);
+    connection.setBatching(true, 64 * 1024, 60000);
+    QVariantMap session;
+    session["session"] = QStringLiteral("session");
+    negotiated(connection, MessageCodec::FORMAT_JSON, true, session);
+
+    // waits in the batch while the socket is lost
+    connection.sendVariant(sendMessage(0));
+    QMetaObject::invokeMethod(&connection, "socketDisconnected", Qt::DirectConnection);
+    QVERIFY(connection.isSuspended());
+
+    // connecting somewhere else ends the session
+    connection.connect(QStringLiteral("ws://localhost:1"));
+    QVERIFY(!connection.isSuspended());
+
+    QList<QByteArray> written;
+    QObject::connect(&connection, &Connection::frameWritten, [&written](const QByteArray& frame) { written << frame; });
+    QMetaObject::invokeMethod(&connection, "socketConnected", Qt::DirectConnection);
+    negotiated(connection, MessageCodec::FORMAT_JSON, true);
+    QMetaObject::invokeMethod(&connection, "flushBatch", Qt::DirectConnection);
+
+    bool ok;
+    QVERIFY(sentUuids(written, &ok).isEmpty());
+    QVERIFY(ok);
+    QCOMPARE(connection.getStatistics().value("bytesQueued").toLongLong(), Q_INT64_C(0));
+}
+
+void ModelBenchmarks::connectionResumeDropsStaleFrames()
+{
+    Connection connection;
+    connection.setReplayMode(true);
+    connection.setSessionResumption(true);
+    QVariantMap session;
+    session["session"] = QStringLiteral("session");
+    negotiated(connection, MessageCodec::FORMAT_JSON, false, session);
+
+    VirtualConnection resumed(&connection);
+    VirtualConnection forgotten(&connection);
+    int remoteChannel = 7;
+    for(VirtualConnection* handle : {&resumed, &forgotten})
+    {
+        QVariantMap msg;
+        msg["command"] = "connection:registered";
+        msg["uuid"] = handle->getUUID();
+        msg["channel"] = remoteChannel++;
+        connection.injectFrame(MessageCodec::encode(msg, MessageCodec::FORMAT_JSON));
+    }
+
+    // sent while suspended, so the frames stay in the send queue
+    QMetaObject::invokeMethod(&connection, "socketDisconnected", Qt::DirectConnection);
+    resumed.sendVariant(SyntheticData::row(0));
+    forgotten.sendVariant(SyntheticData::row(1));
+
+    QList<QByteArray> written;
+    QObject::connect(&connection, &Connection::frameWritten, [&written](const QByteArray& frame) { written << frame; });
+    QMetaObject::invokeMethod(&connection, "socketConnected", Qt::DirectConnection);
+
+    session["resumed"] = QVariantList() << resumed.getUUID();
+    negotiated(connection, MessageCodec::FORMAT_JSON, false, session);
+    QVERIFY(!connection.isSuspended());
+
+    // channel 8 is unknown to the server now
+    bool ok;
+    QCOMPARE(sentUuids(written, &ok), QStringList(QStringLiteral("7")));
+    QVERIFY(ok);
+}
+
+void ModelBenchmarks::subchannelClose()
+{
+    Connection connection;
+    connection.setReplayMode(true);
+    negotiated(connection, MessageCodec::FORMAT_JSON, false);
+
+    VirtualConnection parent(&connection);
+    parent.setAcceptSubchannels(true);
+    QVariantMap registered;
+    registered["command"] = "connection:registered";
+    registered["uuid"] = parent.getUUID();
+    parent.deployMessage(registered);
+
+    QList<VirtualConnection*> accepted;
+    QObject::connect(&parent, &VirtualConnection::newSubchannel, [&accepted](VirtualConnection* subchannel) { accepted << subchannel; });
+
+    QVariantMap send;
+    send["command"] = "send";
+    send["uuid"] = parent.getUUID();
+    send["tag"] = 5;
+    send["payload"] = SyntheticData::row(0);
+    parent.deployMessage(send);
+    QCOMPARE(accepted.count(), 1);
+
+    QVariantMap close;
+    close["command"] = "connection:close";
+    close["uuid"] = parent.getUUID();
+    close["tag"] = 5;
+    parent.deployMessage(close);
+    QVERIFY(!parent.getSubchannel(5));
+
+    VirtualConnection* own = parent.openSubchannel();
+    QCOMPARE(own->getConnectionState(), VirtualConnection::CONNECTED);
+    own->close();
+
+    // neither the subchannel closed by the peer nor the one closed here come back
+    QVariantMap closed;
+    closed["command"] = "connection:closed";
+    closed["uuid"] = parent.getUUID();
+    parent.deployMessage(closed);
+    parent.deployMessage(registered);
+    QCOMPARE(accepted.first()->getConnectionState(), VirtualConnection::DISCONNECTED);
+    QCOMPARE(own->getConnectionState(), VirtualConnection::DISCONNECTED);
+
+    // a frame with the old tag opens a new subchannel
+    parent.deployMessage(send);
+    QCOMPARE(accepted.count(), 2);
+    QVERIFY(accepted.last() != accepted.first());
+    QCOMPARE(parent.getSubchannel(5), accepted.last());
+    QCOMPARE(accepted.last()->getConnectionState(), VirtualConnection::CONNECTED);
+}
+
+void ModelBenchmarks::metricsRefuseSecondType()
+{
+    Metrics metrics;
+    metrics.setEnabled(true);
+    metrics.observe("quickhub_test_milliseconds", 5);
+
+    // the exposition would declare the histogram as a gauge
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("quickhub_test_milliseconds"));
+    metrics.gauge("quickhub_test_milliseconds", 5);
+    metrics.gauge("quickhub_test_milliseconds", 6);
+
+    const QVariantMap snapshot = metrics.snapshot();
+    QVERIFY(snapshot.value("gauges").toMap().isEmpty());
+    QCOMPARE(snapshot.value("histograms").toMap().count(), 1);
+    QVERIFY(!metrics.toPrometheus().contains(" gauge"));
+}
+
+void ModelBenchmarks::sharedObjectModels()
+{
+    SubscriptionRegistry* registry = SubscriptionRegistry::instance();
+    const QString resource = QStringLiteral("benchmark/sharedObject");
+    SynchronizedObjectModel first;
+    SynchronizedObjectModel second;
+    first.setResource(resource);
+    second.setResource(resource);
+    QCOMPARE(registry->subscriberCount(QStringLiteral("object"), resource), 2);
+
+    // a change of one model reaches the other one without a round trip
+    first.setProperty(QStringLiteral("value"), 42);
+    QCOMPARE(second.value(QStringLiteral("value")).toInt(), 42);
+    second.updateValue(QStringLiteral("name"), QStringLiteral("second"));
+    QCOMPARE(first.value(QStringLiteral("name")).toString(), QStringLiteral("second"));
+
+    // only the disconnected model lets go of the attachment
+    first.disconnectObject();
+    QCOMPARE(registry->subscriberCount(QStringLiteral("object"), resource), 1);
+    second.setProperty(QStringLiteral("value"), 43);
+    QCOMPARE(first.value(QStringLiteral("value")).toInt(), 42);
+
+    first.connectObject();
+    QCOMPARE(registry->subscriberCount(QStringLiteral("object"), resource), 2);
+}
+
+void ModelBenchmarks::sharedListModels()
+{
+    SubscriptionRegistry* registry = SubscriptionRegistry::instance();
+    const QString resource = QStringLiteral("benchmark/sharedList");
+    SynchronizedListModel2 first;
+    SynchronizedListModel2 second;
+    first.setResource(resource);
+    second.setResource(resource);
+    first.componentComplete();
+    second.componentComplete();
+    QCOMPARE(registry->subscriberCount(QStringLiteral("synclist"), resource), 2);
+
+    // the setting belongs to the shared list
+    first.setPreloadCount(20);
+    QCOMPARE(first.preloadCount(), 20);
+    QCOMPARE(second.preloadCount(), 20);
+
+    first.disconnectList();
+    QCOMPARE(registry->subscriberCount(QStringLiteral("synclist"), resource), 1);
+    QCOMPARE(second.preloadCount(), 20);
+
+    first.connectList();
+    QCOMPARE(registry->subscriberCount(QStringLiteral("synclist"), resource), 2);
+}
+
+void ModelBenchmarks::subscriptionRegistryReplay()
+{
+    SubscriptionRegistry* registry = SubscriptionRegistry::instance();
+    const QString resource = QStringLiteral("benchmark/replay");
+
+    QVariantMap property;
+    property["data"] = 1;
+    QVariantMap data;
+    data["value"] = property;
+    QVariantMap parameters;
+    parameters["data"] = data;
+
+    registry->setLingerTime(60000);
+    {
+        // the resource is dumped once, the second model takes the content of the first one
+        SynchronizedObjectModel first;
+        first.setResource(resource);
+        deliver(&first, "messageReceived", SyntheticData::message("object:dump", parameters));
+        SynchronizedObjectModel second;
+        second.setResource(resource);
+        QVERIFY(second.initialized());
+        QCOMPARE(second.value(QStringLiteral("value")).toInt(), 1);
+    }
+
+    // a lingering handler brings back the content of its last model
+    QCOMPARE(registry->subscriberCount(QStringLiteral("object"), resource), 0);
+
+    SynchronizedObjectModel third;
+    third.setResource(resource);
+    QVERIFY(third.initialized());
+    QCOMPARE(third.value(QStringLiteral("value")).toInt(), 1);
+    registry->setLingerTime(0);
+}
+
+QTEST_MAIN(ModelBenchmarks)
+
+#include "tst_modelbenchmarks.moc"
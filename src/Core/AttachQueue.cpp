@@ -0,0 +1,144 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * It is part of the QuickHub framework - www.quickhub.org
+ * Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de */
+
+
+#include "AttachQueue.h"
+#include "ConnectionManager.h"
+#include "../Shared/VirtualConnection.h"
+#include "Helpers/Metrics.h"
+
+Q_GLOBAL_STATIC(AttachQueue, attachQueue);
+
+AttachQueue::AttachQueue(QObject *parent) : QObject(parent)
+{
+}
+
+AttachQueue *AttachQueue::instance()
+{
+    return attachQueue;
+}
+
+bool AttachQueue::enqueue(VirtualConnection *channel, const QVariantMap &request, std::function<void()> fallback)
+{
+    VirtualConnection* connection = channel ? channel->getParentConnection() : nullptr;
+    if(!connection || !ConnectionManager::instance()->bulkAttach())
+        return false;
+
+    Request queued;
+    queued.connection = connection;
+    queued.channel = channel;
+    queued.message = request;
+    queued.fallback = fallback;
+    _pending << queued;
+    scheduleFlush();
+    return true;
+}
+
+void AttachQueue::beginBatch()
+{
+    _batchDepth++;
+}
+
+void AttachQueue::endBatch()
+{
+    if(_batchDepth <= 0)
+        return;
+
+    _batchDepth--;
+    scheduleFlush();
+}
+
+void AttachQueue::scheduleFlush()
+{
+    if(_batchDepth > 0 || _flushScheduled || _pending.isEmpty())
+        return;
+
+    _flushScheduled = true;
+    QMetaObject::invokeMethod(this, "flush", Qt::QueuedConnection);
+}
+
+void AttachQueue::flush()
+{
+    _flushScheduled = false;
+    if(_batchDepth > 0)
+        return;
+
+    const QList<Request> pending = _pending;
+    _pending.clear();
+
+    // only connections which still exist are used as keys
+    QHash<VirtualConnection*, QVariantList> bundles;
+    QList<VirtualConnection*> connections;
+    for(const Request& request : pending)
+    {
+        // the model may be gone already
+        if(!request.connection || !request.channel || request.channel->getParentConnection() != request.connection)
+            continue;
+
+        // a bundle sent now would be dropped, the handler attaches on its own
+        if(request.connection->getConnectionState() != VirtualConnection::CONNECTED)
+        {
+            if(request.fallback)
+                request.fallback();
+            continue;
+        }
+
+        QVariantMap resource = request.message;
+        resource["tag"] = request.channel->getTag();
+        if(!bundles.contains(request.connection))
+            connections << request.connection;
+        bundles[request.connection] << resource;
+    }
+
+    for(VirtualConnection* connection : connections)
+    {
+        const QVariantList resources = bundles.value(connection);
+
+        connect(connection, &VirtualConnection::messageReceived, this, &AttachQueue::responseReceived, Qt::UniqueConnection);
+
+        Metrics* metrics = Metrics::instance();
+        if(metrics->isEnabled())
+            metrics->count("quickhub_messages_sent_total", 1, Metrics::label("command", QStringLiteral("attach:many")));
+
+        QVariantMap payload;
+        payload["resources"] = resources;
+
+        QVariantMap msg;
+        msg["command"] = "attach:many";
+        msg["payload"] = payload;
+        msg["token"] = ConnectionManager::instance()->getToken();
+        connection->sendVariant(msg);
+    }
+}
+
+void AttachQueue::responseReceived(const QVariant &message)
+{
+    const QVariantMap msg = message.toMap();
+    if(msg.value(QStringLiteral("command")).toString() != QStringLiteral("attach:many:done"))
+        return;
+
+    VirtualConnection* connection = qobject_cast<VirtualConnection*>(sender());
+    if(!connection)
+        return;
+
+    const QVariantList results = msg.value(QStringLiteral("payload")).toMap().value(QStringLiteral("results")).toList();
+    for(const QVariant& entry : results)
+    {
+        const QVariantMap result = entry.toMap();
+        VirtualConnection* channel = connection->getSubchannel(result.value(QStringLiteral("tag"), -1).toInt());
+        if(!channel)
+            continue;
+
+        // the attach reply and the dump reach the handler like any other message
+        for(const QVariant& reply : result.value(QStringLiteral("messages")).toList())
+        {
+            QVariantMap frame;
+            frame["command"] = "send";
+            frame["payload"] = reply;
+            channel->deployMessage(frame);
+        }
+    }
+}
@@ -0,0 +1,74 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * It is part of the QuickHub framework - www.quickhub.org
+ * Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de */
+
+
+#ifndef ATTACHQUEUE_H
+#define ATTACHQUEUE_H
+
+#include <QObject>
+#include <QHash>
+#include <QPointer>
+#include <QVariant>
+#include <functional>
+
+class VirtualConnection;
+
+/*!
+    \class AttachQueue
+    \brief Sends the attach requests of many resources as one attach:many request.
+
+    Communication handlers on subchannels of a multiplexed virtual connection queue their
+    attach requests here while ConnectionManager::bulkAttach is enabled. All requests of one
+    event loop turn, or of an explicit batch, are sent over the shared virtual connection in
+    one attach:many request. The server answers with one attach:many:done message which
+    contains the replies for every subchannel, they are handed to the subchannels as if they
+    had been received one by one.
+*/
+
+class AttachQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AttachQueue(QObject *parent = nullptr);
+    static AttachQueue* instance();
+
+    /*!
+        \fn bool AttachQueue::enqueue(VirtualConnection* channel, const QVariantMap& request, std::function<void()> fallback)
+        Queues the attach request of channel. Returns false if the request can not be bundled
+        and has to be sent as usual. fallback sends the request as usual if the shared virtual
+        connection is not connected when the bundle is due.
+    */
+    bool    enqueue(VirtualConnection* channel, const QVariantMap& request, std::function<void()> fallback);
+
+    /*!
+        \fn void AttachQueue::beginBatch()
+        Holds back the queued requests until the matching endBatch(). Batches can be nested.
+    */
+    void    beginBatch();
+    void    endBatch();
+
+private:
+    struct Request
+    {
+        QPointer<VirtualConnection> connection;
+        QPointer<VirtualConnection> channel;
+        QVariantMap                 message;
+        std::function<void()>       fallback;
+    };
+
+    void    scheduleFlush();
+
+    QList<Request>                              _pending;
+    int                                         _batchDepth = 0;
+    bool                                        _flushScheduled = false;
+
+private slots:
+    void    flush();
+    void    responseReceived(const QVariant& message);
+};
+
+#endif // ATTACHQUEUE_H
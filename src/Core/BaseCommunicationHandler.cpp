@@ -6,17 +6,23 @@
 
 
 #include "BaseCommunicationHandler.h"
+#include "Helpers/Metrics.h"
 
 
 BaseCommunicationHandler::BaseCommunicationHandler(QObject *parent) : QObject(parent),
     _modelState(MODEL_DISCONNECTED),
     _connected(false)
 {
-    _handle = new VirtualConnection(ConnectionManager::instance()->getConnection());
+    _handle = ConnectionManager::instance()->openChannel();
     connect(_handle, SIGNAL(disconnected()), this, SLOT(socketDisconnected()));
     connect(_handle,SIGNAL(messageReceived(QVariant)), this,SLOT(messageReceived(QVariant)));
     connect(_handle, SIGNAL(connected()), this, SLOT(socketConnected()));
+    connect(_handle, SIGNAL(resumeFailed()), this, SLOT(resumeFailed()));
     connect(ConnectionManager::instance(), SIGNAL(onStateChanged()), this, SLOT(handleServerState()));
+
+    // a subchannel of a connected virtual connection does not report connected() again
+    if(_handle->getConnectionState() == VirtualConnection::CONNECTED)
+        _modelState = MODEL_READY;
 }
 
 BaseCommunicationHandler::~BaseCommunicationHandler()
@@ -48,6 +54,16 @@ void BaseCommunicationHandler::setModelState(ModelState state)
     Q_EMIT stateChanged();
 }
 
+int BaseCommunicationHandler::lastFrameSize() const
+{
+    return _handle ? _handle->getLastFrameSize() : 0;
+}
+
+VirtualConnection *BaseCommunicationHandler::channel() const
+{
+    return _handle;
+}
+
 void BaseCommunicationHandler::attachModel()
 {
     Q_EMIT ready();
@@ -80,6 +96,10 @@ bool BaseCommunicationHandler::sendMessage(const QVariantMap &msg)
 {
     if(ConnectionManager::instance()->getState() >= ConnectionManager::STATE_Connected)
     {
+        Metrics* metrics = Metrics::instance();
+        if(metrics->isEnabled())
+            metrics->count("quickhub_messages_sent_total", 1, Metrics::label("command", msg.value("command").toString()));
+
         QVariantMap map = msg;
         map.insert("token",ConnectionManager::instance()->getToken());
        _handle->sendVariant(map);
@@ -105,6 +125,18 @@ void BaseCommunicationHandler::socketDisconnected()
 void BaseCommunicationHandler::socketConnected()
 {
     setModelState(MODEL_READY);
+
+    // the session survived, but the server has lost this resource
+    if(_reattach)
+    {
+        _reattach = false;
+        attachModel();
+    }
+}
+
+void BaseCommunicationHandler::resumeFailed()
+{
+    _reattach = isAttached();
 }
 
 void BaseCommunicationHandler::messageReceived(QVariant message)
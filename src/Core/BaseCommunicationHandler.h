@@ -35,11 +35,14 @@ public:
 
 protected:
     void setModelState(BaseCommunicationHandler::ModelState state);
+    int lastFrameSize() const;
+    VirtualConnection* channel() const;
 
 private:
     ModelState          _modelState;
     VirtualConnection*  _handle;
     bool                _connected;
+    bool                _reattach = false;
     ConnectionManager::State _lastState = ConnectionManager::STATE_Disconnected;
 
 public slots:
@@ -58,6 +61,7 @@ private slots:
     void socketError(QAbstractSocket::SocketError error);
     void socketDisconnected();
     void socketConnected();
+    void resumeFailed();
 
 protected slots:
     virtual void messageReceived(QVariant message);
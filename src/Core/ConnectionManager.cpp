@@ -1,6 +1,7 @@
 #include <QApplication>
 #include "ConnectionManager.h"
 #include "Helpers/QHSettings.h"
+#include "Helpers/Metrics.h"
 
 ConnectionManager* ConnectionManager::_instance = nullptr;
 
@@ -16,6 +17,15 @@ ConnectionManager::ConnectionManager(QObject *parent) : QObject(parent)
 {
     _connection = new Connection(this);
     connect(_connection, &Connection::socketError, this, &ConnectionManager::socketError);
+    connect(_connection, &Connection::codecChanged, this, &ConnectionManager::protocolChanged);
+    connect(_connection, &Connection::congestionChanged, this, &ConnectionManager::congestedChanged);
+    connect(_connection, &Connection::suspendedChanged, this, &ConnectionManager::suspendedChanged);
+    connect(_connection, &Connection::latencyChanged, this, &ConnectionManager::latencyChanged);
+    connect(_connection, &Connection::frameDecoded, this, [](int size, qint64 decodeTime){
+        Q_UNUSED(size)
+        Metrics::instance()->observe("quickhub_frame_decode_milliseconds", decodeTime / 1000000.0);
+    });
+    connect(Metrics::instance(), &Metrics::collect, this, &ConnectionManager::collectMetrics);
 
     _vconnection = new VirtualConnection(_connection);
     connect(_vconnection, &VirtualConnection::connected, this, [=](){
@@ -169,3 +179,166 @@ VirtualConnection *ConnectionManager::getVConnection()
 {
     return _vconnection;
 }
+
+bool ConnectionManager::binaryProtocol() const
+{
+    return _connection->getPreferredCodec() == MessageCodec::FORMAT_CBOR;
+}
+
+void ConnectionManager::setBinaryProtocol(bool binaryProtocol)
+{
+    if(this->binaryProtocol() == binaryProtocol)
+        return;
+
+    _connection->setPreferredCodec(binaryProtocol ? MessageCodec::FORMAT_CBOR : MessageCodec::FORMAT_JSON);
+    Q_EMIT binaryProtocolChanged();
+}
+
+QString ConnectionManager::protocol() const
+{
+    return MessageCodec::formatName(_connection->getCodec());
+}
+
+bool ConnectionManager::batching() const
+{
+    return _connection->getBatching();
+}
+
+void ConnectionManager::setBatching(bool batching)
+{
+    if(this->batching() == batching)
+        return;
+
+    _connection->setBatching(batching);
+    Q_EMIT batchingChanged();
+}
+
+bool ConnectionManager::compression() const
+{
+    return _connection->getCompression();
+}
+
+void ConnectionManager::setCompression(bool compression)
+{
+    if(this->compression() == compression)
+        return;
+
+    _connection->setCompression(compression);
+    Q_EMIT compressionChanged();
+}
+
+int ConnectionManager::decoderThreads() const
+{
+    return _connection->getDecoderThreads();
+}
+
+void ConnectionManager::setDecoderThreads(int threads)
+{
+    if(decoderThreads() == qMax(threads, 0))
+        return;
+
+    _connection->setDecoderThreads(threads);
+    Q_EMIT decoderThreadsChanged();
+}
+
+bool ConnectionManager::congested() const
+{
+    return _connection->isCongested();
+}
+
+bool ConnectionManager::sessionResumption() const
+{
+    return _connection->getSessionResumption();
+}
+
+void ConnectionManager::setSessionResumption(bool sessionResumption)
+{
+    if(this->sessionResumption() == sessionResumption)
+        return;
+
+    _connection->setSessionResumption(sessionResumption);
+    Q_EMIT sessionResumptionChanged();
+}
+
+bool ConnectionManager::multiplexing() const
+{
+    return _multiplexing;
+}
+
+void ConnectionManager::setMultiplexing(bool multiplexing)
+{
+    if(_multiplexing == multiplexing)
+        return;
+
+    _multiplexing = multiplexing;
+    Q_EMIT multiplexingChanged();
+}
+
+bool ConnectionManager::bulkAttach() const
+{
+    return _bulkAttach;
+}
+
+void ConnectionManager::setBulkAttach(bool bulkAttach)
+{
+    if(_bulkAttach == bulkAttach)
+        return;
+
+    _bulkAttach = bulkAttach;
+    Q_EMIT bulkAttachChanged();
+}
+
+VirtualConnection *ConnectionManager::openChannel()
+{
+    if(!_multiplexing)
+        return new VirtualConnection(_connection);
+
+    // registered once, its subchannels are opened and resumed together with it
+    if(!_multiplexedConnection)
+        _multiplexedConnection = new VirtualConnection(_connection);
+
+    return _multiplexedConnection->openSubchannel();
+}
+
+bool ConnectionManager::suspended() const
+{
+    return _connection->isSuspended();
+}
+
+double ConnectionManager::roundTripTime() const
+{
+    return _connection->getRoundTripTime();
+}
+
+double ConnectionManager::jitter() const
+{
+    return _connection->getJitter();
+}
+
+double ConnectionManager::packetLoss() const
+{
+    return _connection->getPacketLoss();
+}
+
+void ConnectionManager::collectMetrics()
+{
+    Metrics* metrics = Metrics::instance();
+    QVariantMap statistics = _connection->getStatistics();
+    metrics->setCount("quickhub_connection_bytes_sent_total", statistics["bytesSent"].toLongLong());
+    metrics->setCount("quickhub_connection_bytes_received_total", statistics["bytesReceived"].toLongLong());
+    metrics->setCount("quickhub_connection_frames_sent_total", statistics["framesSent"].toLongLong());
+    metrics->setCount("quickhub_connection_frames_received_total", statistics["framesReceived"].toLongLong());
+    metrics->setCount("quickhub_connection_messages_sent_total", statistics["messagesSent"].toLongLong());
+    metrics->setCount("quickhub_connection_messages_received_total", statistics["messagesReceived"].toLongLong());
+    metrics->gauge("quickhub_connection_send_queue_bytes", statistics["bytesQueued"].toDouble());
+    metrics->gauge("quickhub_connection_in_flight_bytes", statistics["bytesInFlight"].toDouble());
+    metrics->gauge("quickhub_connection_decode_queue_frames", statistics["framesDecoding"].toDouble());
+    metrics->gauge("quickhub_connection_rtt_milliseconds", _connection->getRoundTripTime());
+    metrics->gauge("quickhub_connection_jitter_milliseconds", _connection->getJitter());
+    metrics->gauge("quickhub_connection_packet_loss_ratio", _connection->getPacketLoss());
+}
+
+QVariantMap ConnectionManager::statistics() const
+{
+    return _connection->getStatistics();
+}
@@ -38,6 +38,104 @@ class ConnectionManager : public QObject
     */
     Q_PROPERTY(int keepaliveInterval READ getKeepaliveInterval WRITE setKeepaliveInterval NOTIFY keepaliveIntervalChanged)
 
+    /*!
+        \qmlproperty bool ConnectionState::binaryProtocol
+        If true, the client asks the server to exchange CBOR instead of JSON frames when the
+        connection is established. Servers without CBOR support keep talking JSON.
+        \default false
+    */
+    Q_PROPERTY(bool binaryProtocol READ binaryProtocol WRITE setBinaryProtocol NOTIFY binaryProtocolChanged)
+
+    /*!
+        \qmlproperty QString ConnectionState::protocol
+        Holds the wire format which is currently in use ("json" or "cbor").
+    */
+    Q_PROPERTY(QString protocol READ protocol NOTIFY protocolChanged)
+
+    /*!
+        \qmlproperty bool ConnectionState::batching
+        If true, messages which are sent within the same event loop turn are packed into
+        one frame. Only used if the server announces that it is able to unpack them.
+        \default false
+    */
+    Q_PROPERTY(bool batching READ batching WRITE setBatching NOTIFY batchingChanged)
+
+    /*!
+        \qmlproperty bool ConnectionState::compression
+        If true, large frames like resource dumps are deflated before they are sent
+        over the wire, provided that the server agrees on it.
+        \default false
+    */
+    Q_PROPERTY(bool compression READ compression WRITE setCompression NOTIFY compressionChanged)
+
+    /*!
+        \qmlproperty int ConnectionState::decoderThreads
+        Number of worker threads which decode incoming frames. With 0, frames are decoded
+        on the GUI thread. Large resource dumps should not block the UI if set to 1 or more.
+        \default 0
+    */
+    Q_PROPERTY(int decoderThreads READ decoderThreads WRITE setDecoderThreads NOTIFY decoderThreadsChanged)
+
+    /*!
+        \qmlproperty bool ConnectionState::congested
+        True while more data is waiting to be sent than the connection is able to
+        write. Applications should postpone large uploads until it turns false again.
+    */
+    Q_PROPERTY(bool congested READ congested NOTIFY congestedChanged)
+
+    /*!
+        \qmlproperty bool ConnectionState::sessionResumption
+        If true, the client asks the server for a resumable session. After a short network
+        outage, the session is resumed and only the missed messages are transferred
+        instead of all resources being attached again.
+        \default false
+    */
+    Q_PROPERTY(bool sessionResumption READ sessionResumption WRITE setSessionResumption NOTIFY sessionResumptionChanged)
+
+    /*!
+        \qmlproperty bool ConnectionState::multiplexing
+        If true, models which are created afterwards share one virtual connection. Each of
+        them sends and receives over a tagged subchannel instead of registering a virtual
+        connection of its own. The server has to support subchannels.
+        \default false
+    */
+    Q_PROPERTY(bool multiplexing READ multiplexing WRITE setMultiplexing NOTIFY multiplexingChanged)
+
+    /*!
+        \qmlproperty bool ConnectionState::bulkAttach
+        If true, the attach requests of multiplexed models which are issued within one event loop
+        turn are sent as one attach:many request, and the server answers them at once. Has no
+        effect without multiplexing. The server has to support attach:many.
+        \default false
+    */
+    Q_PROPERTY(bool bulkAttach READ bulkAttach WRITE setBulkAttach NOTIFY bulkAttachChanged)
+
+    /*!
+        \qmlproperty bool ConnectionState::suspended
+        True while the connection is lost but the session may still be resumed. The state
+        property keeps its value meanwhile.
+    */
+    Q_PROPERTY(bool suspended READ suspended NOTIFY suspendedChanged)
+
+    /*!
+        \qmlproperty double ConnectionState::roundTripTime
+        Holds the smoothed round trip time to the server in milliseconds, measured by the
+        keepalive pings. -1 as long as no ping has been answered.
+    */
+    Q_PROPERTY(double roundTripTime READ roundTripTime NOTIFY latencyChanged)
+
+    /*!
+        \qmlproperty double ConnectionState::jitter
+        Holds the mean deviation of the round trip time in milliseconds.
+    */
+    Q_PROPERTY(double jitter READ jitter NOTIFY latencyChanged)
+
+    /*!
+        \qmlproperty double ConnectionState::packetLoss
+        Holds the share of keepalive pings which have not been answered in time (0 to 1).
+    */
+    Q_PROPERTY(double packetLoss READ packetLoss NOTIFY latencyChanged)
+
 
 public:
     /*!
@@ -81,6 +179,12 @@ public:
     */
     Q_INVOKABLE void reconnectServer();
 
+    /*!
+        \fn QVariantMap ConnectionState::statistics()
+        Returns the message and frame counters of the current connection.
+    */
+    Q_INVOKABLE QVariantMap statistics() const;
+
     State getState() const;
     void setConnectionState(const State &onStateChanged);
     QString getToken() const;
@@ -91,6 +195,34 @@ public:
     int getKeepaliveInterval();
     void setKeepaliveInterval(int interval, int timeout = 2500);
     VirtualConnection* getVConnection();
+    bool binaryProtocol() const;
+    void setBinaryProtocol(bool binaryProtocol);
+    QString protocol() const;
+    bool batching() const;
+    void setBatching(bool batching);
+    bool compression() const;
+    void setCompression(bool compression);
+    int decoderThreads() const;
+    void setDecoderThreads(int threads);
+    bool congested() const;
+    bool sessionResumption() const;
+    void setSessionResumption(bool sessionResumption);
+    bool multiplexing() const;
+    void setMultiplexing(bool multiplexing);
+    bool bulkAttach() const;
+    void setBulkAttach(bool bulkAttach);
+
+    /*!
+        \fn VirtualConnection* ConnectionManager::openChannel()
+        Returns a new channel for a communication handler: a subchannel of the shared virtual
+        connection if multiplexing is enabled, a virtual connection of its own otherwise.
+        The caller owns the channel.
+    */
+    VirtualConnection* openChannel();
+    bool suspended() const;
+    double roundTripTime() const;
+    double jitter() const;
+    double packetLoss() const;
 
     static QObject* instanceAsQObject(QQmlEngine *engine = nullptr, QJSEngine *scriptEngine = nullptr);
     static ConnectionManager* instance();
@@ -109,6 +241,9 @@ private:
     QString                 _token;
     QJSValue                _connectCb;
     VirtualConnection*      _vconnection;
+    VirtualConnection*      _multiplexedConnection = nullptr;
+    bool                    _multiplexing = false;
+    bool                    _bulkAttach = false;
     bool                    _autoConnect = false;
 
     Q_PROPERTY(bool autoConnect READ autoConnect WRITE setAutoConnect NOTIFY autoConnectChanged)
@@ -116,12 +251,24 @@ private:
 private slots:
     void                    socketError(QAbstractSocket::SocketError error);
     void                    loadSettings();
+    void                    collectMetrics();
 signals:
     void onStateChanged();
     void onServerUrlChanged();
     void tokenChanged();
     void keepaliveIntervalChanged();
     void autoConnectChanged();
+    void binaryProtocolChanged();
+    void protocolChanged();
+    void batchingChanged();
+    void compressionChanged();
+    void decoderThreadsChanged();
+    void congestedChanged();
+    void sessionResumptionChanged();
+    void multiplexingChanged();
+    void bulkAttachChanged();
+    void suspendedChanged();
+    void latencyChanged();
 };
 
 #endif // AUTHENTICATIONSTATE_H
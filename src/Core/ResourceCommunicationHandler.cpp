@@ -6,6 +6,8 @@
 
 
 #include "ResourceCommunicationHandler.h"
+#include "AttachQueue.h"
+#include "Helpers/Metrics.h"
 
 
 ResourceCommunicationHandler::ResourceCommunicationHandler(QString resourceType, QObject *parent) : BaseCommunicationHandler(parent),
@@ -65,11 +67,15 @@ void ResourceCommunicationHandler::p_attachModel()
         return;
 
     setModelState(MODEL_CONNECTING);
+    _attachTimer.start();
     QVariantMap msg;
     msg["command"] = _resourceType+":attach";
     QVariantMap payload;
     payload["descriptor"] = _descriptor;
     msg["payload"] = payload;
+    if(AttachQueue::instance()->enqueue(channel(), msg, [this, msg]() { sendMessage(msg); }))
+        return;
+
     sendMessage(msg);
 }
 
@@ -92,19 +98,38 @@ void ResourceCommunicationHandler::stateChangedSlot()
 
 void ResourceCommunicationHandler::messageReceived(QVariant message)
 {
-    QVariantMap msg = message.toMap();
-    QString cmd = msg["command"].toString();
-    QString msgID = msg["msguid"].toString();
-    QVariantMap parameters = msg["parameters"].toMap();
-    QVariant data = parameters["data"];
+    // read only what is needed for routing, the payload itself
+    // is handed on untouched and parsed by the model.
+    const QVariantMap msg = message.toMap();
+    const QString cmd = msg.value(QStringLiteral("command")).toString();
+    const QString msgID = msg.value(QStringLiteral("msguid")).toString();
+
+    Metrics* metrics = Metrics::instance();
+    if(metrics->isEnabled())
+    {
+        metrics->count("quickhub_messages_received_total", 1, Metrics::label("command", cmd));
+
+        // the first dump after an attach marks the resource as initialized
+        if(cmd.endsWith(QStringLiteral(":dump")))
+        {
+            QString resource = Metrics::label("resource", _resourceType + ":" + _descriptor);
+            metrics->gauge("quickhub_resource_dump_bytes", lastFrameSize(), resource);
+            if(_attachTimer.isValid())
+            {
+                metrics->gauge("quickhub_resource_initialization_last_milliseconds", _attachTimer.elapsed(), resource);
+                metrics->observe("quickhub_resource_initialization_milliseconds", _attachTimer.elapsed());
+                _attachTimer.invalidate();
+            }
+        }
+    }
 
     // check wether the message contains a message ID. If so, send an ACK
     if(!msgID.isEmpty())
     {
-        QVariantMap msg;
-        msg["command"] = "ACK";
-        msg["msguid"] = msgID;
-        sendMessage(msg);
+        QVariantMap ack;
+        ack["command"] = "ACK";
+        ack["msguid"] = msgID;
+        sendMessage(ack);
     }
 
     if(cmd == _resourceType+":attach:success")
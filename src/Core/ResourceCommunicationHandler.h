@@ -9,6 +9,7 @@
 #define ISYNCHRONIZEDBASEMODEL_H
 
 #include <QObject>
+#include <QElapsedTimer>
 #include "BaseCommunicationHandler.h"
 
 class ResourceCommunicationHandler : public BaseCommunicationHandler
@@ -32,6 +33,7 @@ private:
     QString             _resourceType;
     bool                _shared = false;
     bool                _attachWhenReady = false;
+    QElapsedTimer       _attachTimer;
 
 public slots:
     void                attachModel() override;
@@ -0,0 +1,241 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * It is part of the QuickHub framework - www.quickhub.org
+ * Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de */
+
+
+#include "SubscriptionRegistry.h"
+#include "ResourceCommunicationHandler.h"
+#include <QQmlEngine>
+#include <QTimer>
+
+Q_GLOBAL_STATIC(SubscriptionRegistry, subscriptionRegistry);
+
+namespace {
+    // a handler which receives more while lingering is cheaper to dump again
+    const int maxLingerMessages = 256;
+}
+
+SubscriptionRegistry::SubscriptionRegistry(QObject *parent) : QObject(parent)
+{
+}
+
+SubscriptionRegistry *SubscriptionRegistry::instance()
+{
+    return subscriptionRegistry;
+}
+
+QObject *SubscriptionRegistry::instanceAsQObject(QQmlEngine *engine, QJSEngine *scriptEngine)
+{
+    Q_UNUSED(scriptEngine)
+    Q_UNUSED(engine)
+
+    QQmlEngine::setObjectOwnership(instance(), QQmlEngine::CppOwnership);
+    return instance();
+}
+
+int SubscriptionRegistry::lingerTime() const
+{
+    return _lingerTime;
+}
+
+void SubscriptionRegistry::setLingerTime(int lingerTime)
+{
+    if(_lingerTime == lingerTime)
+        return;
+
+    _lingerTime = lingerTime;
+    if(_lingerTime <= 0)
+    {
+        QStringList lingering;
+        for(auto it = _subscriptions.cbegin(); it != _subscriptions.cend(); ++it)
+        {
+            if(it->linger)
+                lingering << it.key();
+        }
+
+        for(const QString& key : lingering)
+            remove(key);
+    }
+
+    Q_EMIT lingerTimeChanged();
+}
+
+QObject *SubscriptionRegistry::acquire(const QString &type, const QString &descriptor, QObject *subscriber, std::function<QObject *()> create)
+{
+    const QString subscriptionKey = key(type, descriptor);
+    auto it = _subscriptions.find(subscriptionKey);
+    if(it == _subscriptions.end())
+    {
+        Subscription subscription;
+        subscription.object = create();
+        it = _subscriptions.insert(subscriptionKey, subscription);
+        _keys.insert(subscription.object, subscriptionKey);
+    }
+
+    if(it->linger)
+        stopLinger(*it);
+
+    if(!it->subscribers.contains(subscriber))
+        it->subscribers << subscriber;
+
+    return it->object;
+}
+
+ResourceCommunicationHandler *SubscriptionRegistry::acquireHandler(const QString &type, const QString &descriptor, QObject *subscriber)
+{
+    QObject* subscription = acquire(type, descriptor, subscriber, [type, descriptor]() {
+        ResourceCommunicationHandler* handler = new ResourceCommunicationHandler(type);
+        handler->setDescriptor(descriptor);
+        handler->attachModel();
+        return handler;
+    });
+
+    return qobject_cast<ResourceCommunicationHandler*>(subscription);
+}
+
+void SubscriptionRegistry::connectSubscriber(ResourceCommunicationHandler *handler, QObject *subscriber, std::function<QVariant(QObject*)> replay)
+{
+    connect(handler, SIGNAL(newMessage(QVariant)), subscriber, SLOT(messageReceived(QVariant)));
+    connect(handler, SIGNAL(attachedChanged()), subscriber, SIGNAL(connectedChanged()));
+    connect(handler, SIGNAL(stateChanged()), subscriber, SIGNAL(modelStateChanged()));
+    QMetaObject::invokeMethod(subscriber, "connectedChanged");
+    QMetaObject::invokeMethod(subscriber, "modelStateChanged");
+
+    // a lingering resource comes back with the content of the last model
+    QVariantList messages = takeState(handler);
+    if(messages.isEmpty() && replay)
+    {
+        // otherwise a model which is added later takes the content of another one
+        for(QObject* other : subscribers(handler))
+        {
+            if(other == subscriber)
+                continue;
+
+            QVariant dump = replay(other);
+            if(dump.isValid())
+            {
+                messages << dump;
+                break;
+            }
+        }
+    }
+
+    for(const QVariant& message : messages)
+    {
+        QMetaObject::invokeMethod(subscriber, "messageReceived", Q_ARG(QVariant, message));
+    }
+}
+
+void SubscriptionRegistry::release(QObject *subscription, QObject *subscriber, std::function<QVariant()> state)
+{
+    auto keyIt = _keys.find(subscription);
+    if(keyIt == _keys.end())
+        return;
+
+    const QString subscriptionKey = keyIt.value();
+    auto it = _subscriptions.find(subscriptionKey);
+    it->subscribers.removeAll(subscriber);
+    if(!it->subscribers.isEmpty() || it->linger)
+        return;
+
+    if(_lingerTime > 0)
+    {
+        ResourceCommunicationHandler* handler = qobject_cast<ResourceCommunicationHandler*>(subscription);
+        QVariant lastState = state ? state() : QVariant();
+
+        // a handler without state would leave the next model empty
+        if(!handler || lastState.isValid())
+        {
+            startLinger(subscriptionKey, lastState);
+            return;
+        }
+    }
+
+    remove(subscriptionKey);
+}
+
+QVariantList SubscriptionRegistry::takeState(QObject *subscription)
+{
+    auto it = _subscriptions.find(_keys.value(subscription));
+    if(it == _subscriptions.end() || !it->state.isValid())
+        return QVariantList();
+
+    QVariantList state;
+    state << it->state;
+    state << it->messages;
+    it->state = QVariant();
+    it->messages.clear();
+    return state;
+}
+
+QList<QObject *> SubscriptionRegistry::subscribers(QObject *subscription) const
+{
+    return _subscriptions.value(_keys.value(subscription)).subscribers;
+}
+
+int SubscriptionRegistry::subscriberCount(const QString &type, const QString &descriptor) const
+{
+    return _subscriptions.value(key(type, descriptor)).subscribers.count();
+}
+
+QString SubscriptionRegistry::key(const QString &type, const QString &descriptor)
+{
+    return type + "|" + descriptor;
+}
+
+void SubscriptionRegistry::startLinger(const QString &key, QVariant state)
+{
+    Subscription& subscription = _subscriptions[key];
+    subscription.state = state;
+    subscription.messages.clear();
+    subscription.linger = new QTimer(this);
+    subscription.linger->setSingleShot(true);
+    connect(subscription.linger, &QTimer::timeout, this, [this, key]() {
+        remove(key);
+    });
+    subscription.linger->start(_lingerTime);
+
+    ResourceCommunicationHandler* handler = qobject_cast<ResourceCommunicationHandler*>(subscription.object);
+    if(!handler)
+        return;
+
+    connect(handler, &ResourceCommunicationHandler::newMessage, this, [this, key](QVariant message) {
+        auto it = _subscriptions.find(key);
+        if(it == _subscriptions.end())
+            return;
+
+        it->messages << message;
+        if(it->messages.count() > maxLingerMessages)
+            remove(key);
+    });
+}
+
+void SubscriptionRegistry::stopLinger(Subscription &subscription)
+{
+    disconnect(subscription.object, nullptr, this, nullptr);
+    subscription.linger->deleteLater();
+    subscription.linger = nullptr;
+}
+
+void SubscriptionRegistry::remove(const QString &key)
+{
+    auto it = _subscriptions.find(key);
+    if(it == _subscriptions.end())
+        return;
+
+    QObject* subscription = it->object;
+    if(it->linger)
+        stopLinger(*it);
+
+    _subscriptions.erase(it);
+    _keys.remove(subscription);
+
+    ResourceCommunicationHandler* handler = qobject_cast<ResourceCommunicationHandler*>(subscription);
+    if(handler && handler->isAttached())
+        handler->detachModel();
+
+    // the subscription may be emitting the signal which led to the release
+    subscription->deleteLater();
+}
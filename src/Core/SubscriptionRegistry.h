@@ -0,0 +1,128 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * It is part of the QuickHub framework - www.quickhub.org
+ * Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de */
+
+
+#ifndef SUBSCRIPTIONREGISTRY_H
+#define SUBSCRIPTIONREGISTRY_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QVariant>
+#include <functional>
+
+class ResourceCommunicationHandler;
+class QTimer;
+class QQmlEngine;
+class QJSEngine;
+
+/*!
+    \class SubscriptionRegistry
+    \brief Shares the attachment of a resource between all models which show it.
+
+    A subscription is the object which is attached to a resource, e.g. a ResourceCommunicationHandler
+    or a SynchronizedListStore. Models acquire the subscription of their resource type and descriptor
+    instead of creating their own, so a resource is attached and dumped once no matter how many
+    models show it. The subscription is detached and deleted when its last subscriber releases it.
+
+    With a lingerTime, the subscription stays attached for that long after its last subscriber
+    released it. Models which are destroyed and created again in the meantime, e.g. in the
+    delegates of a ListView, get it back without any traffic. A ResourceCommunicationHandler only
+    lingers together with the state of its last model; the messages it receives while lingering
+    are kept and replayed on top of that state.
+*/
+
+class SubscriptionRegistry : public QObject
+{
+    Q_OBJECT
+
+    /*!
+        \qmlproperty int Subscriptions::lingerTime
+        Time in milliseconds a resource stays attached after its last model is gone.
+        \default 0
+    */
+    Q_PROPERTY(int lingerTime READ lingerTime WRITE setLingerTime NOTIFY lingerTimeChanged)
+
+public:
+    explicit SubscriptionRegistry(QObject *parent = nullptr);
+    static SubscriptionRegistry* instance();
+    static QObject* instanceAsQObject(QQmlEngine *engine = nullptr, QJSEngine *scriptEngine = nullptr);
+
+    int             lingerTime() const;
+    void            setLingerTime(int lingerTime);
+
+    /*!
+        \fn QObject* SubscriptionRegistry::acquire(const QString& type, const QString& descriptor, QObject* subscriber, std::function<QObject*()> create)
+        Returns the subscription of the resource and adds subscriber to it. If there is none yet,
+        it is created by create. Acquiring a subscription twice with the same subscriber does not
+        add another reference.
+    */
+    QObject*        acquire(const QString& type, const QString& descriptor, QObject* subscriber, std::function<QObject*()> create);
+
+    /*!
+        \fn ResourceCommunicationHandler* SubscriptionRegistry::acquireHandler(const QString& type, const QString& descriptor, QObject* subscriber)
+        Returns a ResourceCommunicationHandler which is attached to the resource.
+    */
+    ResourceCommunicationHandler* acquireHandler(const QString& type, const QString& descriptor, QObject* subscriber);
+
+    /*!
+        \fn void SubscriptionRegistry::connectSubscriber(ResourceCommunicationHandler* handler, QObject* subscriber, std::function<QVariant(QObject*)> replay)
+        Called by a model right after acquireHandler(). The messages of handler are delivered to the
+        messageReceived(QVariant) slot of subscriber, attachedChanged() and stateChanged() to its
+        connectedChanged() and modelStateChanged() signals.
+
+        The resource is dumped once, so subscriber is brought up to date by the state of a
+        lingering handler or else by another subscriber: replay is called with the other
+        subscribers until it returns the content of one of them as a dump message.
+    */
+    void            connectSubscriber(ResourceCommunicationHandler* handler, QObject* subscriber, std::function<QVariant(QObject*)> replay);
+
+    /*!
+        \fn void SubscriptionRegistry::release(QObject* subscription, QObject* subscriber, std::function<QVariant()> state)
+        Removes subscriber from the subscription. A ResourceCommunicationHandler is detached when its
+        last subscriber is released, every subscription is deleted then. If the subscription lingers,
+        state is called once to keep the content of the last subscriber.
+    */
+    void            release(QObject* subscription, QObject* subscriber, std::function<QVariant()> state = nullptr);
+
+    /*!
+        \fn QVariantList SubscriptionRegistry::takeState(QObject* subscription)
+        Returns the state kept while the subscription lingered, followed by the messages received
+        since, and forgets them. The list is empty if the subscription did not linger.
+    */
+    QVariantList    takeState(QObject* subscription);
+
+    /*!
+        \fn QList<QObject*> SubscriptionRegistry::subscribers(QObject* subscription) const
+        Returns the subscribers of the subscription in the order they were added.
+    */
+    QList<QObject*> subscribers(QObject* subscription) const;
+    int             subscriberCount(const QString& type, const QString& descriptor) const;
+
+private:
+    struct Subscription
+    {
+        QObject*        object = nullptr;
+        QList<QObject*> subscribers;
+        QTimer*         linger = nullptr;
+        QVariant        state;
+        QVariantList    messages;
+    };
+
+    static QString  key(const QString& type, const QString& descriptor);
+    void            startLinger(const QString& key, QVariant state);
+    void            stopLinger(Subscription& subscription);
+    void            remove(const QString& key);
+
+    QHash<QString, Subscription>    _subscriptions;
+    QHash<QObject*, QString>        _keys;
+    int                             _lingerTime = 0;
+
+signals:
+    void lingerTimeChanged();
+};
+
+#endif // SUBSCRIPTIONREGISTRY_H
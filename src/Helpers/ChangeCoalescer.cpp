@@ -0,0 +1,196 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * It is part of the QuickHub framework - www.quickhub.org
+ * Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de */
+
+
+#include "ChangeCoalescer.h"
+#include <QAbstractItemModel>
+#include <QGuiApplication>
+#include <QPointer>
+#include <QQuickWindow>
+#include <algorithm>
+
+namespace {
+
+// flushes all coalescers which wait for the next frame together
+class FrameClock : public QObject
+{
+public:
+    FrameClock()
+    {
+        _timer.setSingleShot(true);
+        connect(&_timer, &QTimer::timeout, this, &FrameClock::tick);
+    }
+
+    void schedule(ChangeCoalescer* coalescer)
+    {
+        _waiting << coalescer;
+        if(_waiting.count() > 1)
+            return;
+
+        QQuickWindow* window = visibleWindow();
+        if(!window)
+        {
+            _timer.start(FRAME_INTERVAL);
+            return;
+        }
+
+        connect(window, &QQuickWindow::afterAnimating, this, &FrameClock::tick, Qt::UniqueConnection);
+        window->update();
+
+        // in case the window does not render the next frame
+        _timer.start(FALLBACK_INTERVAL);
+    }
+
+private:
+    static const int FRAME_INTERVAL = 16;
+    static const int FALLBACK_INTERVAL = 100;
+
+    QQuickWindow* visibleWindow() const
+    {
+        if(!qobject_cast<QGuiApplication*>(QCoreApplication::instance()))
+            return nullptr;
+
+        for(QWindow* window : QGuiApplication::topLevelWindows())
+        {
+            QQuickWindow* quickWindow = qobject_cast<QQuickWindow*>(window);
+            if(quickWindow && quickWindow->isExposed())
+                return quickWindow;
+        }
+
+        return nullptr;
+    }
+
+    void tick()
+    {
+        _timer.stop();
+        QList<QPointer<ChangeCoalescer>> waiting;
+        waiting.swap(_waiting);
+        for(const QPointer<ChangeCoalescer>& coalescer : qAsConst(waiting))
+        {
+            if(coalescer)
+                coalescer->flush();
+        }
+    }
+
+    QTimer                              _timer;
+    QList<QPointer<ChangeCoalescer>>    _waiting;
+};
+
+Q_GLOBAL_STATIC(FrameClock, frameClock)
+
+}
+
+ChangeCoalescer::ChangeCoalescer(QAbstractItemModel *model) : QObject(model),
+    _model(model)
+{
+    _timer.setSingleShot(true);
+    connect(&_timer, &QTimer::timeout, this, &ChangeCoalescer::flush);
+}
+
+bool ChangeCoalescer::isEnabled() const
+{
+    return _enabled;
+}
+
+void ChangeCoalescer::setEnabled(bool enabled)
+{
+    if(_enabled == enabled)
+        return;
+
+    _enabled = enabled;
+    if(!_enabled)
+        flush();
+}
+
+void ChangeCoalescer::setInterval(int interval)
+{
+    _interval = qMax(0, interval);
+}
+
+int ChangeCoalescer::interval() const
+{
+    return _interval;
+}
+
+void ChangeCoalescer::rowChanged(int row, const QVector<int> &roles)
+{
+    if(!_enabled)
+    {
+        Q_EMIT _model->dataChanged(_model->index(row, 0), _model->index(row, 0), roles);
+        return;
+    }
+
+    auto it = _rows.find(row);
+    if(it == _rows.end())
+    {
+        QVector<int> sorted = roles;
+        std::sort(sorted.begin(), sorted.end());
+        _rows.insert(row, sorted);
+        schedule();
+        return;
+    }
+
+    // an empty role list already covers all roles
+    if(it->isEmpty())
+        return;
+
+    if(roles.isEmpty())
+    {
+        it->clear();
+        return;
+    }
+
+    for(int role : roles)
+    {
+        auto position = std::lower_bound(it->begin(), it->end(), role);
+        if(position == it->end() || *position != role)
+            it->insert(position, role);
+    }
+}
+
+void ChangeCoalescer::flush()
+{
+    _timer.stop();
+    _scheduled = false;
+    if(_rows.isEmpty())
+        return;
+
+    QMap<int, QVector<int>> rows;
+    rows.swap(_rows);
+
+    // adjacent rows with the same roles are reported as one range
+    auto it = rows.constBegin();
+    int first = it.key();
+    int last = first;
+    QVector<int> roles = it.value();
+    for(++it; it != rows.constEnd(); ++it)
+    {
+        if(it.key() == last + 1 && it.value() == roles)
+        {
+            last = it.key();
+            continue;
+        }
+
+        Q_EMIT _model->dataChanged(_model->index(first, 0), _model->index(last, 0), roles);
+        first = it.key();
+        last = first;
+        roles = it.value();
+    }
+
+    Q_EMIT _model->dataChanged(_model->index(first, 0), _model->index(last, 0), roles);
+}
+
+void ChangeCoalescer::schedule()
+{
+    if(_scheduled)
+        return;
+
+    _scheduled = true;
+    if(_interval > 0)
+        _timer.start(_interval);
+    else
+        frameClock->schedule(this);
+}
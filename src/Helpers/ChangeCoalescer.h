@@ -0,0 +1,72 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * It is part of the QuickHub framework - www.quickhub.org
+ * Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de */
+
+
+#ifndef CHANGECOALESCER_H
+#define CHANGECOALESCER_H
+
+#include <QObject>
+#include <QMap>
+#include <QVector>
+#include <QTimer>
+
+class QAbstractItemModel;
+
+/*!
+    \class ChangeCoalescer
+    \brief Collects changed rows and roles of a list model and reports them at once.
+
+    While enabled, rowChanged() only marks the row and roles as dirty. The dirty rows are
+    reported as dataChanged() of the model once per frame, or after interval ms if an
+    interval is set. Adjacent rows with the same roles are merged into one range.
+
+    Changed rows keep their index until they are reported, so the model has to call flush()
+    before it inserts, removes, moves or resets rows. While disabled, rowChanged() emits
+    dataChanged() right away.
+*/
+
+class ChangeCoalescer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ChangeCoalescer(QAbstractItemModel* model);
+
+    bool        isEnabled() const;
+    void        setEnabled(bool enabled);
+
+    /*!
+        \fn void ChangeCoalescer::setInterval(int interval)
+        Reports the changes every interval ms. 0 reports them once per frame of the visible
+        QQuickWindow, or every 16 ms if there is none.
+    */
+    void        setInterval(int interval);
+    int         interval() const;
+
+    /*!
+        \fn void ChangeCoalescer::rowChanged(int row, const QVector<int>& roles)
+        Marks the roles of the row as changed. An empty role list stands for all roles.
+    */
+    void        rowChanged(int row, const QVector<int>& roles = QVector<int>());
+
+    /*!
+        \fn void ChangeCoalescer::flush()
+        Reports all pending changes right away.
+    */
+    void        flush();
+
+private:
+    void        schedule();
+
+    QAbstractItemModel*     _model;
+    bool                    _enabled = false;
+    bool                    _scheduled = false;
+    int                     _interval = 0;
+    QTimer                  _timer;
+    QMap<int, QVector<int>> _rows;  // sorted roles
+};
+
+#endif // CHANGECOALESCER_H
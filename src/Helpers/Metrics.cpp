@@ -0,0 +1,373 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * It is part of the QuickHub framework - www.quickhub.org
+ * Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de */
+
+
+#include "Metrics.h"
+#include <QMutexLocker>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QSet>
+#include <algorithm>
+#include <QQmlEngine>
+#include <QDebug>
+
+namespace
+{
+    const double BUCKETS[] = {0.1, 0.25, 0.5, 1, 2.5, 5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000};
+    const int BUCKET_COUNT = sizeof(BUCKETS) / sizeof(BUCKETS[0]);
+
+    QString withLabel(const QString& key, const QString& extraLabel)
+    {
+        int brace = key.indexOf('{');
+        if(brace < 0)
+            return key + "{" + extraLabel + "}";
+
+        return key.left(key.length() - 1) + "," + extraLabel + "}";
+    }
+
+    QString baseName(const QString& key)
+    {
+        int brace = key.indexOf('{');
+        return brace < 0 ? key : key.left(brace);
+    }
+
+    // keeps the series of one metric family together
+    template<typename T>
+    QStringList sortedKeys(const QHash<QString, T>& hash)
+    {
+        QStringList keys = hash.keys();
+        std::sort(keys.begin(), keys.end(), [](const QString& a, const QString& b)
+        {
+            const QString nameA = baseName(a);
+            const QString nameB = baseName(b);
+            return nameA == nameB ? a < b : nameA < nameB;
+        });
+        return keys;
+    }
+}
+
+Q_GLOBAL_STATIC(Metrics, metrics);
+
+Metrics::Metrics(QObject *parent) : QObject(parent)
+{
+    _timer.setInterval(5000);
+    connect(&_timer, &QTimer::timeout, this, &Metrics::tick);
+}
+
+Metrics *Metrics::instance()
+{
+    return metrics;
+}
+
+QObject *Metrics::instanceAsQObject(QQmlEngine *engine, QJSEngine *scriptEngine)
+{
+    Q_UNUSED(scriptEngine)
+    Q_UNUSED(engine)
+
+    // the registry lives in a global static and must not be deleted by the engine
+    QQmlEngine::setObjectOwnership(instance(), QQmlEngine::CppOwnership);
+    return instance();
+}
+
+QString Metrics::label(const QString &key, const QString &value)
+{
+    QString escaped = value;
+    escaped.replace("\\", "\\\\").replace("\"", "\\\"");
+    return key + "=\"" + escaped + "\"";
+}
+
+bool Metrics::isEnabled() const
+{
+    return _enabled.loadAcquire() != 0;
+}
+
+void Metrics::setEnabled(bool enabled)
+{
+    if(isEnabled() == enabled)
+        return;
+
+    _enabled.storeRelease(enabled ? 1 : 0);
+    if(enabled)
+        _timer.start();
+    else
+        _timer.stop();
+
+    Q_EMIT enabledChanged();
+}
+
+int Metrics::interval() const
+{
+    return _timer.interval();
+}
+
+void Metrics::setInterval(int interval)
+{
+    if(_timer.interval() == interval)
+        return;
+
+    _timer.setInterval(interval);
+    Q_EMIT intervalChanged();
+}
+
+QString Metrics::dumpFile() const
+{
+    return _dumpFile;
+}
+
+void Metrics::setDumpFile(const QString &dumpFile)
+{
+    if(_dumpFile == dumpFile)
+        return;
+
+    _dumpFile = dumpFile;
+    Q_EMIT dumpFileChanged();
+}
+
+QString Metrics::key(const QString &name, const QString &label)
+{
+    if(label.isEmpty())
+        return name;
+
+    return name + "{" + label + "}";
+}
+
+bool Metrics::checkType(const QString &name, Type type)
+{
+    // a Prometheus metric family has exactly one type
+    auto it = _types.constFind(name);
+    if(it == _types.constEnd())
+    {
+        _types.insert(name, type);
+        return true;
+    }
+
+    if(it.value() == type)
+        return true;
+
+    if(_conflicts.contains(name))
+        return false;
+
+    _conflicts.insert(name);
+    const char* names[] = {"counter", "gauge", "histogram"};
+    qWarning()<<Q_FUNC_INFO<<": "<<name<<" is a "<<names[it.value()]<<", not a "<<names[type];
+    return false;
+}
+
+void Metrics::count(const QString &name, qint64 value, const QString &label)
+{
+    if(!isEnabled())
+        return;
+
+    QMutexLocker locker(&_mutex);
+    if(!checkType(name, TYPE_COUNTER))
+        return;
+
+    _counters[key(name, label)] += value;
+}
+
+void Metrics::setCount(const QString &name, qint64 value, const QString &label)
+{
+    if(!isEnabled())
+        return;
+
+    QMutexLocker locker(&_mutex);
+    if(!checkType(name, TYPE_COUNTER))
+        return;
+
+    _counters[key(name, label)] = value;
+}
+
+void Metrics::gauge(const QString &name, double value, const QString &label)
+{
+    if(!isEnabled())
+        return;
+
+    QMutexLocker locker(&_mutex);
+    if(!checkType(name, TYPE_GAUGE))
+        return;
+
+    _gauges[key(name, label)] = value;
+}
+
+void Metrics::observe(const QString &name, double value, const QString &label)
+{
+    if(!isEnabled())
+        return;
+
+    QMutexLocker locker(&_mutex);
+    if(!checkType(name, TYPE_HISTOGRAM))
+        return;
+
+    Histogram& histogram = _histograms[key(name, label)];
+    if(histogram.buckets.isEmpty())
+        histogram.buckets.fill(0, BUCKET_COUNT);
+
+    for(int i = 0; i < BUCKET_COUNT; i++)
+    {
+        if(value <= BUCKETS[i])
+        {
+            histogram.buckets[i]++;
+            break;
+        }
+    }
+
+    histogram.count++;
+    histogram.sum += value;
+}
+
+QVariantMap Metrics::snapshot()
+{
+    QMutexLocker locker(&_mutex);
+
+    QVariantMap counters;
+    for(auto it = _counters.constBegin(); it != _counters.constEnd(); ++it)
+    {
+        counters[it.key()] = it.value();
+    }
+
+    QVariantMap rates;
+    for(auto it = _rates.constBegin(); it != _rates.constEnd(); ++it)
+    {
+        rates[it.key()] = it.value();
+    }
+
+    QVariantMap gauges;
+    for(auto it = _gauges.constBegin(); it != _gauges.constEnd(); ++it)
+    {
+        gauges[it.key()] = it.value();
+    }
+
+    QVariantMap histograms;
+    for(auto it = _histograms.constBegin(); it != _histograms.constEnd(); ++it)
+    {
+        QVariantMap histogram;
+        QVariantList buckets;
+        qint64 cumulative = 0;
+        for(int i = 0; i < BUCKET_COUNT; i++)
+        {
+            cumulative += it.value().buckets.at(i);
+            QVariantMap bucket;
+            bucket["le"] = BUCKETS[i];
+            bucket["count"] = cumulative;
+            buckets << bucket;
+        }
+        histogram["buckets"] = buckets;
+        histogram["count"] = it.value().count;
+        histogram["sum"] = it.value().sum;
+        histograms[it.key()] = histogram;
+    }
+
+    QVariantMap result;
+    result["counters"] = counters;
+    result["rates"] = rates;
+    result["gauges"] = gauges;
+    result["histograms"] = histograms;
+    return result;
+}
+
+QString Metrics::toJson()
+{
+    return QString::fromUtf8(QJsonDocument::fromVariant(snapshot()).toJson(QJsonDocument::Indented));
+}
+
+QString Metrics::toPrometheus()
+{
+    QMutexLocker locker(&_mutex);
+    QString text;
+
+    // the type of a metric family must be declared only once
+    QSet<QString> declared;
+    auto declare = [&](const QString& name, const char* type)
+    {
+        if(declared.contains(name))
+            return;
+
+        declared.insert(name);
+        text += "# TYPE " + name + " " + type + "\n";
+    };
+
+    for(const QString& key : sortedKeys(_counters))
+    {
+        declare(baseName(key), "counter");
+        text += key + " " + QString::number(_counters.value(key)) + "\n";
+    }
+
+    for(const QString& key : sortedKeys(_gauges))
+    {
+        declare(baseName(key), "gauge");
+        text += key + " " + QString::number(_gauges.value(key)) + "\n";
+    }
+
+    for(const QString& key : sortedKeys(_histograms))
+    {
+        const Histogram& histogram = _histograms[key];
+        const QString name = baseName(key);
+        const QString labels = key.mid(name.length());
+        declare(name, "histogram");
+
+        qint64 cumulative = 0;
+        for(int i = 0; i < BUCKET_COUNT; i++)
+        {
+            cumulative += histogram.buckets.at(i);
+            QString bucket = withLabel(name + "_bucket" + labels, label("le", QString::number(BUCKETS[i])));
+            text += bucket + " " + QString::number(cumulative) + "\n";
+        }
+        text += withLabel(name + "_bucket" + labels, label("le", "+Inf")) + " " + QString::number(histogram.count) + "\n";
+        text += name + "_sum" + labels + " " + QString::number(histogram.sum) + "\n";
+        text += name + "_count" + labels + " " + QString::number(histogram.count) + "\n";
+    }
+
+    return text;
+}
+
+void Metrics::reset()
+{
+    QMutexLocker locker(&_mutex);
+    _counters.clear();
+    _lastCounters.clear();
+    _rates.clear();
+    _gauges.clear();
+    _histograms.clear();
+    _types.clear();
+    _conflicts.clear();
+}
+
+void Metrics::tick()
+{
+    Q_EMIT collect();
+
+    {
+        QMutexLocker locker(&_mutex);
+        double seconds = _timer.interval() / 1000.0;
+        for(auto it = _counters.constBegin(); it != _counters.constEnd(); ++it)
+        {
+            _rates[it.key()] = (it.value() - _lastCounters.value(it.key(), 0)) / seconds;
+        }
+        _lastCounters = _counters;
+    }
+
+    if(!_dumpFile.isEmpty())
+        writeDump();
+
+    Q_EMIT updated();
+}
+
+void Metrics::writeDump()
+{
+    QSaveFile file(_dumpFile);
+    if(!file.open(QIODevice::WriteOnly))
+    {
+        qWarning()<<Q_FUNC_INFO<<": Unable to write "<<_dumpFile;
+        return;
+    }
+
+    if(_dumpFile.endsWith(".json"))
+        file.write(toJson().toUtf8());
+    else
+        file.write(toPrometheus().toUtf8());
+
+    file.commit();
+}
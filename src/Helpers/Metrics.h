@@ -0,0 +1,145 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * It is part of the QuickHub framework - www.quickhub.org
+ * Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de */
+
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QObject>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QVariant>
+#include <QTimer>
+#include <QVector>
+#include <QSet>
+
+class QQmlEngine;
+class QJSEngine;
+
+/*!
+    \class Metrics
+    \brief Collects counters, gauges and histograms about the client under load.
+
+    Recording is thread safe and does nothing as long as the registry is disabled.
+    Metric names follow the Prometheus conventions. A metric may carry one label,
+    which is passed preformatted, e.g. Metrics::label("command", "synclist:dump").
+    A name belongs to the type it has been recorded with first, recording it with
+    another type is refused with a warning.
+    If a dump file is set, the registry is written to it periodically: as JSON if
+    the file name ends with .json, in the Prometheus text format otherwise.
+*/
+
+class Metrics : public QObject
+{
+    Q_OBJECT
+
+    /*!
+        \qmlproperty bool Metrics::enabled
+        Metrics are only recorded while enabled.
+        \default false
+    */
+    Q_PROPERTY(bool enabled READ isEnabled WRITE setEnabled NOTIFY enabledChanged)
+
+    /*!
+        \qmlproperty int Metrics::interval
+        Interval in milliseconds in which rates are computed, the dump file is written
+        and updated() is emitted.
+        \default 5000
+    */
+    Q_PROPERTY(int interval READ interval WRITE setInterval NOTIFY intervalChanged)
+
+    /*!
+        \qmlproperty QString Metrics::dumpFile
+        Path of the file the metrics are written to periodically. Empty disables the dump.
+    */
+    Q_PROPERTY(QString dumpFile READ dumpFile WRITE setDumpFile NOTIFY dumpFileChanged)
+
+public:
+    explicit Metrics(QObject *parent = nullptr);
+    static Metrics* instance();
+    static QObject* instanceAsQObject(QQmlEngine *engine = nullptr, QJSEngine *scriptEngine = nullptr);
+    static QString  label(const QString& key, const QString& value);
+
+    bool        isEnabled() const;
+    void        setEnabled(bool enabled);
+    int         interval() const;
+    void        setInterval(int interval);
+    QString     dumpFile() const;
+    void        setDumpFile(const QString& dumpFile);
+
+    void        count(const QString& name, qint64 value = 1, const QString& label = QString());
+
+    /*!
+        \fn void Metrics::setCount(const QString& name, qint64 value, const QString& label)
+        Sets a counter which is maintained by its source, e.g. the byte counters of Connection.
+    */
+    void        setCount(const QString& name, qint64 value, const QString& label = QString());
+    void        gauge(const QString& name, double value, const QString& label = QString());
+
+    /*!
+        \fn void Metrics::observe(const QString& name, double value, const QString& label)
+        Adds a value to a histogram. The buckets are meant for durations in milliseconds.
+    */
+    void        observe(const QString& name, double value, const QString& label = QString());
+
+    /*!
+        \fn QVariantMap Metrics::snapshot()
+        Returns all metrics as a map with the keys counters, rates, gauges and histograms.
+    */
+    Q_INVOKABLE QVariantMap snapshot();
+    Q_INVOKABLE QString     toJson();
+    Q_INVOKABLE QString     toPrometheus();
+    Q_INVOKABLE void        reset();
+
+private:
+    enum Type
+    {
+        TYPE_COUNTER,
+        TYPE_GAUGE,
+        TYPE_HISTOGRAM
+    };
+
+    struct Histogram
+    {
+        QVector<qint64> buckets;
+        qint64          count = 0;
+        double          sum = 0;
+    };
+
+    static QString          key(const QString& name, const QString& label);
+    bool                    checkType(const QString& name, Type type);
+    void                    writeDump();
+
+    QAtomicInt                  _enabled;
+    QMutex                      _mutex;
+    QTimer                      _timer;
+    QString                     _dumpFile;
+    QHash<QString, qint64>      _counters;
+    QHash<QString, qint64>      _lastCounters;
+    QHash<QString, double>      _rates;
+    QHash<QString, double>      _gauges;
+    QHash<QString, Histogram>   _histograms;
+    QHash<QString, Type>        _types;
+    QSet<QString>               _conflicts;
+
+signals:
+    void enabledChanged();
+    void intervalChanged();
+    void dumpFileChanged();
+
+    /*!
+        \fn void Metrics::collect()
+        Emitted before the metrics are evaluated, so that sources which keep their own
+        counters are able to update their gauges.
+    */
+    void collect();
+    void updated();
+
+private slots:
+    void tick();
+};
+
+#endif // METRICS_H
@@ -0,0 +1,224 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * It is part of the QuickHub framework - www.quickhub.org
+ * Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de */
+
+
+#include "ResourceCache.h"
+#include "QHSettings.h"
+#include "../Core/CloudModel.h"
+#include "../Core/ConnectionManager.h"
+#include <QCborMap>
+#include <QCborValue>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QQmlEngine>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+class CacheWriteTask : public QRunnable
+{
+public:
+    CacheWriteTask(const QString& path, const QString& key, const QVariant& content) :
+        _path(path),
+        _key(key),
+        _content(content)
+    {
+    }
+
+    void run() override
+    {
+        QCborMap map;
+        map.insert(QStringLiteral("key"), _key);
+        map.insert(QStringLiteral("stored"), QDateTime::currentMSecsSinceEpoch());
+        map.insert(QStringLiteral("content"), QCborValue::fromVariant(_content));
+
+        QSaveFile file(_path);
+        if(!file.open(QIODevice::WriteOnly))
+            return;
+
+        file.write(map.toCborValue().toCbor());
+        file.commit();
+    }
+
+private:
+    QString     _path;
+    QString     _key;
+    QVariant    _content;
+};
+
+Q_GLOBAL_STATIC(ResourceCache, resourceCache);
+
+ResourceCache::ResourceCache(QObject *parent) : QObject(parent),
+    _directory(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/resources")
+{
+    // one writer keeps the writes of a file in order
+    _pool.setMaxThreadCount(1);
+    _timer.setSingleShot(true);
+    _timer.setInterval(2000);
+    connect(&_timer, &QTimer::timeout, this, &ResourceCache::writePending);
+}
+
+ResourceCache::~ResourceCache()
+{
+    _pool.waitForDone();
+}
+
+ResourceCache *ResourceCache::instance()
+{
+    return resourceCache;
+}
+
+QObject *ResourceCache::instanceAsQObject(QQmlEngine *engine, QJSEngine *scriptEngine)
+{
+    Q_UNUSED(scriptEngine)
+    Q_UNUSED(engine)
+
+    QQmlEngine::setObjectOwnership(instance(), QQmlEngine::CppOwnership);
+    return instance();
+}
+
+bool ResourceCache::isEnabled() const
+{
+    return _enabled;
+}
+
+void ResourceCache::setEnabled(bool enabled)
+{
+    if(_enabled == enabled)
+        return;
+
+    _enabled = enabled;
+    if(!_enabled)
+    {
+        _timer.stop();
+        _pending.clear();
+    }
+    Q_EMIT enabledChanged();
+}
+
+QString ResourceCache::directory() const
+{
+    return _directory;
+}
+
+void ResourceCache::setDirectory(const QString &directory)
+{
+    if(_directory == directory)
+        return;
+
+    _directory = directory;
+    Q_EMIT directoryChanged();
+}
+
+int ResourceCache::writeDelay() const
+{
+    return _timer.interval();
+}
+
+void ResourceCache::setWriteDelay(int writeDelay)
+{
+    if(_timer.interval() == writeDelay)
+        return;
+
+    _timer.setInterval(writeDelay);
+    Q_EMIT writeDelayChanged();
+}
+
+QVariant ResourceCache::load(const QString &type, const QString &descriptor)
+{
+    if(!_enabled || descriptor.isEmpty())
+        return QVariant();
+
+    const QString key = cacheKey(type, descriptor);
+    QFile file(filePath(key));
+    if(!file.open(QIODevice::ReadOnly) || file.size() <= 0)
+        return QVariant();
+
+    uchar* mapped = file.map(0, file.size());
+    if(!mapped)
+        return QVariant();
+
+    // the content is converted before the mapping is released
+    QVariant content;
+    QCborParserError error;
+    const QCborValue value = QCborValue::fromCbor(QByteArray::fromRawData(reinterpret_cast<const char*>(mapped), int(file.size())), &error);
+    if(error.error == QCborError::NoError && value[QStringLiteral("key")].toString() == key)
+        content = value[QStringLiteral("content")].toVariant();
+
+    file.unmap(mapped);
+    return content;
+}
+
+void ResourceCache::scheduleStore(const QString &type, const QString &descriptor, QObject *owner, std::function<QVariant ()> snapshot)
+{
+    if(!_enabled || descriptor.isEmpty())
+        return;
+
+    PendingStore pending;
+    pending.owner = owner;
+    pending.snapshot = snapshot;
+    _pending.insert(cacheKey(type, descriptor), pending);
+    _timer.start();
+}
+
+void ResourceCache::clear()
+{
+    _timer.stop();
+    _pending.clear();
+    _pool.waitForDone();
+
+    QDir dir(_directory);
+    for(const QString& file : dir.entryList(QStringList() << "*.cbor", QDir::Files))
+    {
+        dir.remove(file);
+    }
+}
+
+QString ResourceCache::cacheKey(const QString &type, const QString &descriptor)
+{
+    QString server = ConnectionManager::instance()->getServer();
+    QString user = CloudModel::instance()->getUserID();
+    QHSettings* settings = QHSettings::instance();
+
+    // until the connection is up and the user logged in, the last ones are assumed
+    if(server.isEmpty())
+        server = settings->value("resourceCache/lastServer").toString();
+    else if(settings->value("resourceCache/lastServer").toString() != server)
+        settings->setValue("resourceCache/lastServer", server);
+
+    if(user.isEmpty())
+        user = settings->value("resourceCache/lastUser").toString();
+    else if(settings->value("resourceCache/lastUser").toString() != user)
+        settings->setValue("resourceCache/lastUser", user);
+
+    return server + "|" + user + "|" + type + "|" + descriptor;
+}
+
+QString ResourceCache::filePath(const QString &key) const
+{
+    return _directory + "/" + QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex() + ".cbor";
+}
+
+void ResourceCache::writePending()
+{
+    if(_pending.isEmpty())
+        return;
+
+    QDir().mkpath(_directory);
+
+    QHashIterator<QString, PendingStore> it(_pending);
+    while(it.hasNext())
+    {
+        it.next();
+        if(it.value().owner.isNull())
+            continue;
+
+        _pool.start(new CacheWriteTask(filePath(it.key()), it.key(), it.value().snapshot()));
+    }
+    _pending.clear();
+}
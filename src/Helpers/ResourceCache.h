@@ -0,0 +1,115 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * It is part of the QuickHub framework - www.quickhub.org
+ * Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de */
+
+
+#ifndef RESOURCECACHE_H
+#define RESOURCECACHE_H
+
+#include <QObject>
+#include <QVariant>
+#include <QTimer>
+#include <QHash>
+#include <QPointer>
+#include <QThreadPool>
+#include <functional>
+
+class QQmlEngine;
+class QJSEngine;
+
+/*!
+    \class ResourceCache
+    \brief Keeps the last known content of resources on disk.
+
+    SynchronizedListModel, SynchronizedObjectModel and the list models based on AbstractListModel
+    load their cached content synchronously when their resource is set and show it until the
+    server sends the current content. Entries are keyed by server, user, resource type and
+    descriptor. Before the first login the last server and user are used.
+
+    Files are read memory mapped. Changes are written after writeDelay ms without further
+    changes, on a worker thread. The cache is disabled by default.
+*/
+
+class ResourceCache : public QObject
+{
+    Q_OBJECT
+
+    /*!
+        \qmlproperty bool ResourceCache::enabled
+        Resources are only loaded from and written to the cache while enabled.
+        \default false
+    */
+    Q_PROPERTY(bool enabled READ isEnabled WRITE setEnabled NOTIFY enabledChanged)
+
+    /*!
+        \qmlproperty QString ResourceCache::directory
+        Directory of the cache files.
+        \default <QStandardPaths::CacheLocation>/resources
+    */
+    Q_PROPERTY(QString directory READ directory WRITE setDirectory NOTIFY directoryChanged)
+
+    /*!
+        \qmlproperty int ResourceCache::writeDelay
+        Time in milliseconds after the last change before a resource is written.
+        \default 2000
+    */
+    Q_PROPERTY(int writeDelay READ writeDelay WRITE setWriteDelay NOTIFY writeDelayChanged)
+
+public:
+    explicit ResourceCache(QObject *parent = nullptr);
+    ~ResourceCache();
+    static ResourceCache* instance();
+    static QObject* instanceAsQObject(QQmlEngine *engine = nullptr, QJSEngine *scriptEngine = nullptr);
+
+    bool        isEnabled() const;
+    void        setEnabled(bool enabled);
+    QString     directory() const;
+    void        setDirectory(const QString& directory);
+    int         writeDelay() const;
+    void        setWriteDelay(int writeDelay);
+
+    /*!
+        \fn QVariant ResourceCache::load(const QString& type, const QString& descriptor)
+        Returns the cached content of the resource or an invalid QVariant.
+    */
+    QVariant    load(const QString& type, const QString& descriptor);
+
+    /*!
+        \fn void ResourceCache::scheduleStore(const QString& type, const QString& descriptor, QObject* owner, std::function<QVariant()> snapshot)
+        Marks the resource as changed. snapshot is called when the resource is written, as long as
+        owner still exists.
+    */
+    void        scheduleStore(const QString& type, const QString& descriptor, QObject* owner, std::function<QVariant()> snapshot);
+
+    /*!
+        \fn void ResourceCache::clear()
+        Removes all cached resources.
+    */
+    Q_INVOKABLE void clear();
+
+private:
+    struct PendingStore
+    {
+        QPointer<QObject>       owner;
+        std::function<QVariant()> snapshot;
+    };
+
+    QString     cacheKey(const QString& type, const QString& descriptor);
+    QString     filePath(const QString& key) const;
+    void        writePending();
+
+    bool                            _enabled = false;
+    QString                         _directory;
+    QTimer                          _timer;
+    QHash<QString, PendingStore>    _pending;
+    QThreadPool                     _pool;
+
+signals:
+    void enabledChanged();
+    void directoryChanged();
+    void writeDelayChanged();
+};
+
+#endif // RESOURCECACHE_H
@@ -25,6 +25,9 @@
 #include "SynchronizedObjectListModel.h"
 #include "FilteredDeviceModel.h"
 #include "StandaloneDevice.h"
+#include "Metrics.h"
+#include "ResourceCache.h"
+#include "SubscriptionRegistry.h"
 //#include "FileUploader.h"
 #include <qqml.h>
 class InitQuickHub
@@ -50,6 +53,9 @@ public:
         qmlRegisterSingletonType<CloudModel>(uri, 1, 0, "UserLogin", &CloudModel::instanceAsQObject);
         qmlRegisterSingletonType<ConnectionManager>(uri, 1, 0, "Connection", &ConnectionManager::instanceAsQObject);
         qmlRegisterSingletonType<StandaloneDevice>(uri, 1, 0, "StandaloneDevice", &StandaloneDevice::instanceAsQObject);
+        qmlRegisterSingletonType<Metrics>(uri, 1, 0, "Metrics", &Metrics::instanceAsQObject);
+        qmlRegisterSingletonType<ResourceCache>(uri, 1, 0, "ResourceCache", &ResourceCache::instanceAsQObject);
+        qmlRegisterSingletonType<SubscriptionRegistry>(uri, 1, 0, "Subscriptions", &SubscriptionRegistry::instanceAsQObject);
         qmlRegisterType<SynchronizedObjectListModel>(uri, 1, 0, "SynchronizedListLookupModel");
 
 //        qmlRegisterType<FileUploader>(uri, 1, 0, "FileUploader");
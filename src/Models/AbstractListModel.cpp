@@ -6,9 +6,12 @@
 
 
 #include "AbstractListModel.h"
+#include "../Helpers/ResourceCache.h"
+#include "../Helpers/ChangeCoalescer.h"
 #include <QJsonDocument>
 AbstractListModel::AbstractListModel(QObject *parent) : QAbstractListModel(parent),
-     _communicationHandler(new ResourceCommunicationHandler("list", this))
+     _communicationHandler(new ResourceCommunicationHandler("list", this)),
+     _coalescer(new ChangeCoalescer(this))
 {
     connect(_communicationHandler, &ResourceCommunicationHandler::newMessage, this, &AbstractListModel::messageHandler);
     connect(_communicationHandler, &ResourceCommunicationHandler::attachedChanged, this, &AbstractListModel::attachedChanged);
@@ -53,8 +56,27 @@ QVariantList AbstractListModel::getListData()
 
 void AbstractListModel::setDescriptor(QString descriptor)
 {
+    bool changed = descriptor != _descriptor;
+    _descriptor = descriptor;
     _communicationHandler->setDescriptor(descriptor);
     _communicationHandler->attachModel();
+    if(!changed)
+        return;
+
+    // the rows of the previous resource must not be shown for this one. The
+    // cached rows, if there are any, are shown until list:dump replaces them.
+    QVariantList cached = ResourceCache::instance()->load(QStringLiteral("list"), _descriptor).toList();
+    _coalescer->flush();
+    beginResetModel();
+    _listData = cached;
+    _cached = !cached.isEmpty();
+    endResetModel();
+
+    if(_initialized)
+    {
+        _initialized = false;
+        Q_EMIT initializedChanged();
+    }
 }
 
 void AbstractListModel::messageReceived(QVariant message)
@@ -69,28 +91,31 @@ bool AbstractListModel::sendMessage(QVariantMap msg)
 
 void AbstractListModel::messageHandler(QVariant message)
 {
-    QVariantMap msg = message.toMap();
-    QVariantMap parameters = msg["parameters"].toMap();
-    QString cmd = msg["command"].toString();
+    const QVariantMap msg = message.toMap();
+    const QVariantMap parameters = msg.value(QStringLiteral("parameters")).toMap();
+    const QString cmd = msg.value(QStringLiteral("command")).toString();
 
 
     if(cmd == "list:dump")
     {
-        QVariantList list = parameters["data"].toList();
+        QVariantList list = parameters.value(QStringLiteral("data")).toList();
+        _coalescer->flush();
         beginResetModel();
         _listData = list;
+        _cached = false;
         _initialized = true;
         Q_EMIT initializedChanged();
         endResetModel();
+        storeInCache();
         return;
     }
 
-    int idx = parameters["index"].toInt();
-    QVariant data = parameters["data"];
+    int idx = parameters.value(QStringLiteral("index")).toInt();
+    QVariant data = parameters.value(QStringLiteral("data"));
 
     if(cmd == "list:property:set")
     {
-        QString property = parameters["property"].toString();
+        QString property = parameters.value(QStringLiteral("property")).toString();
         if(idx >= _listData.count())
         {
             return;
@@ -98,32 +123,38 @@ void AbstractListModel::messageHandler(QVariant message)
         QVariantMap item = _listData.at(idx).toMap();
         item[property] = data;
         _listData.replace(idx, item);
-        Q_EMIT dataChanged(index(idx),index(idx));
+        _coalescer->rowChanged(idx, QVector<int>() << roleNames().key(property.toLatin1(), -1));
+        storeInCache();
         return;
     }
 
     if(cmd == "list:set")
     {
         _listData.replace(idx, data);
-        Q_EMIT dataChanged(index(idx),index(idx));
+        _coalescer->rowChanged(idx);
+        storeInCache();
         return;
     }
 
     if(cmd == "list:insertat")
     {
+        _coalescer->flush();
         Q_EMIT  beginInsertRows(QModelIndex(), idx, idx);
         _listData.insert(idx, data);
         Q_EMIT itemAdded(idx, data.toMap());
         Q_EMIT endInsertRows();
+        storeInCache();
         return;
     }
 
     if(cmd == "list:remove")
     {
+        _coalescer->flush();
         Q_EMIT  beginRemoveRows(QModelIndex(), idx, idx);
         Q_EMIT itemRemoved(idx, _listData.at(idx).toMap());
         _listData.removeAt(idx);
         Q_EMIT endRemoveRows();
+        storeInCache();
         return;
     }
 
@@ -132,8 +163,9 @@ void AbstractListModel::messageHandler(QVariant message)
 
 void AbstractListModel::attachedChanged()
 {
-    if(_communicationHandler->isAttached())
+    if(_communicationHandler->isAttached() && !_cached)
     {
+        _coalescer->flush();
         beginResetModel();
         _listData.clear();
         endResetModel();
@@ -145,3 +177,38 @@ bool AbstractListModel::initialized() const
     return _initialized;
 }
 
+bool AbstractListModel::coalesceChanges() const
+{
+    return _coalescer->isEnabled();
+}
+
+void AbstractListModel::setCoalesceChanges(bool coalesceChanges)
+{
+    if(_coalescer->isEnabled() == coalesceChanges)
+        return;
+
+    _coalescer->setEnabled(coalesceChanges);
+    Q_EMIT coalesceChangesChanged();
+}
+
+int AbstractListModel::coalesceInterval() const
+{
+    return _coalescer->interval();
+}
+
+void AbstractListModel::setCoalesceInterval(int coalesceInterval)
+{
+    if(_coalescer->interval() == coalesceInterval)
+        return;
+
+    _coalescer->setInterval(coalesceInterval);
+    Q_EMIT coalesceIntervalChanged();
+}
+
+void AbstractListModel::storeInCache()
+{
+    ResourceCache::instance()->scheduleStore(QStringLiteral("list"), _descriptor, this, [this]() {
+        return QVariant(_listData);
+    });
+}
+
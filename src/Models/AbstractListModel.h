@@ -12,11 +12,20 @@
 #include <QAbstractListModel>
 #include "../Core/ResourceCommunicationHandler.h"
 
+class ChangeCoalescer;
 class AbstractListModel : public QAbstractListModel
 {
     Q_OBJECT
     Q_PROPERTY(bool initialized READ initialized NOTIFY initializedChanged)
 
+    /*!
+        \qmlproperty bool AbstractListModel::coalesceChanges
+        If true, changed rows are reported once per frame (or every coalesceInterval ms).
+        \sa ChangeCoalescer
+    */
+    Q_PROPERTY(bool coalesceChanges READ coalesceChanges WRITE setCoalesceChanges NOTIFY coalesceChangesChanged)
+    Q_PROPERTY(int coalesceInterval READ coalesceInterval WRITE setCoalesceInterval NOTIFY coalesceIntervalChanged)
+
 
 public:
     virtual QVariant data(const QModelIndex &index, int role) const;
@@ -24,6 +33,10 @@ public:
     int rowCount(const QModelIndex &parent) const;
     Q_INVOKABLE QVariantList getListData();
     bool initialized() const;
+    bool coalesceChanges() const;
+    void setCoalesceChanges(bool coalesceChanges);
+    int coalesceInterval() const;
+    void setCoalesceInterval(int coalesceInterval);
 
 protected:
     AbstractListModel(QObject* parent);
@@ -37,13 +50,20 @@ private slots:
     void attachedChanged();
 
 private:
+    void                            storeInCache();
+
     ResourceCommunicationHandler*   _communicationHandler;
+    ChangeCoalescer*                _coalescer;
+    QString                         _descriptor;
     bool                            _initialized = false;
+    bool                            _cached = false;
 
 signals:
     void itemAdded(int idx, QVariantMap item);
     void itemRemoved(int idx, QVariantMap item);
     void initializedChanged();
+    void coalesceChangesChanged();
+    void coalesceIntervalChanged();
 };
 
 #endif // LISTMODEL_H
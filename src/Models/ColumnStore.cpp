@@ -0,0 +1,362 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * It is part of the QuickHub framework - www.quickhub.org
+ * Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de */
+
+
+#include "ColumnStore.h"
+
+namespace {
+
+ColumnStore::ColumnType typeOf(const QVariant& value)
+{
+    switch(value.userType())
+    {
+    case QMetaType::Bool:
+        return ColumnStore::COLUMN_BOOL;
+
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+        return ColumnStore::COLUMN_INT;
+
+    case QMetaType::Double:
+    case QMetaType::Float:
+        return ColumnStore::COLUMN_DOUBLE;
+
+    case QMetaType::QString:
+        return ColumnStore::COLUMN_STRING;
+
+    default:
+        return ColumnStore::COLUMN_VARIANT;
+    }
+}
+
+}
+
+int ColumnStore::count() const
+{
+    return _count;
+}
+
+int ColumnStore::columnCount() const
+{
+    return _columns.count();
+}
+
+QByteArray ColumnStore::columnName(int column) const
+{
+    if(column < 0 || column >= _columns.count())
+        return QByteArray();
+
+    return _columns.at(column).name;
+}
+
+ColumnStore::ColumnType ColumnStore::columnType(int column) const
+{
+    if(column < 0 || column >= _columns.count())
+        return COLUMN_VARIANT;
+
+    return _columns.at(column).type;
+}
+
+int ColumnStore::columnIndex(const QByteArray &name) const
+{
+    return _columnIndex.value(name, -1);
+}
+
+QVariant ColumnStore::value(int row, int column) const
+{
+    if(row < 0 || row >= _count || column < 0 || column >= _columns.count())
+        return QVariant();
+
+    return cell(_columns.at(column), row);
+}
+
+QVariantMap ColumnStore::row(int row) const
+{
+    QVariantMap map;
+    if(row < 0 || row >= _count)
+        return map;
+
+    for(const Column& column : _columns)
+    {
+        if(!column.missing.isEmpty() && column.missing.at(row))
+            continue;
+
+        map.insert(QString::fromLatin1(column.name), cell(column, row));
+    }
+
+    return map;
+}
+
+void ColumnStore::append(const QVariantList &rows)
+{
+    for(Column& column : _columns)
+    {
+        switch(column.type)
+        {
+        case COLUMN_INT: column.ints.reserve(_count + rows.count()); break;
+        case COLUMN_DOUBLE: column.doubles.reserve(_count + rows.count()); break;
+        case COLUMN_BOOL: column.bools.reserve(_count + rows.count()); break;
+        case COLUMN_STRING: column.strings.reserve(_count + rows.count()); break;
+        case COLUMN_VARIANT: column.variants.reserve(_count + rows.count()); break;
+        }
+    }
+
+    for(const QVariant& row : rows)
+    {
+        insert(_count, row);
+    }
+}
+
+void ColumnStore::insert(int row, const QVariant &data)
+{
+    if(row < 0 || row > _count)
+        return;
+
+    QVariantMap map = data.toMap();
+    QMapIterator<QString, QVariant> it(map);
+    while(it.hasNext())
+    {
+        it.next();
+        QByteArray name = it.key().toLatin1();
+        if(!_columnIndex.contains(name))
+            addColumn(name, it.value());
+    }
+
+    for(Column& column : _columns)
+    {
+        QVariant value = map.value(QString::fromLatin1(column.name));
+        accept(column, value);
+        insertCell(column, row, value);
+    }
+
+    _count++;
+}
+
+void ColumnStore::replace(int row, const QVariant &data)
+{
+    if(row < 0 || row >= _count)
+        return;
+
+    QVariantMap map = data.toMap();
+    QMapIterator<QString, QVariant> it(map);
+    while(it.hasNext())
+    {
+        it.next();
+        QByteArray name = it.key().toLatin1();
+        if(!_columnIndex.contains(name))
+            addColumn(name, it.value());
+    }
+
+    for(Column& column : _columns)
+    {
+        QVariant value = map.value(QString::fromLatin1(column.name));
+        accept(column, value);
+        setCell(column, row, value);
+    }
+}
+
+int ColumnStore::setValue(int row, const QByteArray &name, const QVariant &value)
+{
+    if(row < 0 || row >= _count)
+        return -1;
+
+    int index = _columnIndex.value(name, -1);
+    if(index < 0)
+        index = addColumn(name, value);
+
+    Column& column = _columns[index];
+    accept(column, value);
+    setCell(column, row, value);
+    return index;
+}
+
+void ColumnStore::remove(int row)
+{
+    if(row < 0 || row >= _count)
+        return;
+
+    for(Column& column : _columns)
+    {
+        removeCell(column, row);
+    }
+
+    _count--;
+}
+
+void ColumnStore::move(int from, int to)
+{
+    if(from < 0 || from >= _count || to < 0 || to >= _count || from == to)
+        return;
+
+    for(Column& column : _columns)
+    {
+        switch(column.type)
+        {
+        case COLUMN_INT: column.ints.move(from, to); break;
+        case COLUMN_DOUBLE: column.doubles.move(from, to); break;
+        case COLUMN_BOOL: column.bools.move(from, to); break;
+        case COLUMN_STRING: column.strings.move(from, to); break;
+        case COLUMN_VARIANT: column.variants.move(from, to); break;
+        }
+
+        if(!column.missing.isEmpty())
+            column.missing.move(from, to);
+    }
+}
+
+void ColumnStore::clear()
+{
+    _columns.clear();
+    _columnIndex.clear();
+    _count = 0;
+}
+
+int ColumnStore::addColumn(const QByteArray &name, const QVariant &value)
+{
+    Column column;
+    column.name = name;
+    column.type = typeOf(value);
+
+    // all rows stored so far do not have this key
+    switch(column.type)
+    {
+    case COLUMN_INT: column.ints.fill(0, _count); break;
+    case COLUMN_DOUBLE: column.doubles.fill(0, _count); break;
+    case COLUMN_BOOL: column.bools.fill(false, _count); break;
+    case COLUMN_STRING: column.strings.fill(QString(), _count); break;
+    case COLUMN_VARIANT: column.variants.fill(QVariant(), _count); break;
+    }
+
+    if(_count > 0)
+        column.missing.fill(true, _count);
+
+    _columns.append(column);
+    _columnIndex.insert(name, _columns.count() - 1);
+    return _columns.count() - 1;
+}
+
+void ColumnStore::accept(Column &column, const QVariant &value)
+{
+    if(!value.isValid() || column.type == COLUMN_VARIANT)
+        return;
+
+    ColumnType type = typeOf(value);
+    if(type == column.type)
+        return;
+
+    if(column.type == COLUMN_DOUBLE && type == COLUMN_INT)
+        return;
+
+    if(column.type == COLUMN_INT && type == COLUMN_DOUBLE)
+        promote(column, COLUMN_DOUBLE);
+    else
+        promote(column, COLUMN_VARIANT);
+}
+
+void ColumnStore::promote(Column &column, ColumnType type)
+{
+    QVector<QVariant> values;
+    values.reserve(_count);
+    for(int i = 0; i < _count; i++)
+    {
+        values << cell(column, i);
+    }
+
+    QVector<bool> missing = column.missing;
+    column.ints.clear();
+    column.doubles.clear();
+    column.bools.clear();
+    column.strings.clear();
+    column.variants.clear();
+    column.missing.clear();
+    column.type = type;
+
+    for(int i = 0; i < _count; i++)
+    {
+        insertCell(column, i, values.at(i));
+    }
+
+    column.missing = missing;
+}
+
+void ColumnStore::insertCell(Column &column, int row, const QVariant &value)
+{
+    switch(column.type)
+    {
+    case COLUMN_INT: column.ints.insert(row, value.toLongLong()); break;
+    case COLUMN_DOUBLE: column.doubles.insert(row, value.toDouble()); break;
+    case COLUMN_BOOL: column.bools.insert(row, value.toBool()); break;
+    case COLUMN_STRING: column.strings.insert(row, value.toString()); break;
+    case COLUMN_VARIANT: column.variants.insert(row, value); break;
+    }
+
+    if(!column.missing.isEmpty())
+    {
+        column.missing.insert(row, !value.isValid());
+    }
+    else if(!value.isValid())
+    {
+        // the cell is not counted in _count yet
+        column.missing.fill(false, _count + 1);
+        column.missing[row] = true;
+    }
+}
+
+void ColumnStore::setCell(Column &column, int row, const QVariant &value)
+{
+    switch(column.type)
+    {
+    case COLUMN_INT: column.ints[row] = value.toLongLong(); break;
+    case COLUMN_DOUBLE: column.doubles[row] = value.toDouble(); break;
+    case COLUMN_BOOL: column.bools[row] = value.toBool(); break;
+    case COLUMN_STRING: column.strings[row] = value.toString(); break;
+    case COLUMN_VARIANT: column.variants[row] = value; break;
+    }
+
+    if(!column.missing.isEmpty())
+    {
+        column.missing[row] = !value.isValid();
+    }
+    else if(!value.isValid())
+    {
+        column.missing.fill(false, _count);
+        column.missing[row] = true;
+    }
+}
+
+void ColumnStore::removeCell(Column &column, int row)
+{
+    switch(column.type)
+    {
+    case COLUMN_INT: column.ints.remove(row); break;
+    case COLUMN_DOUBLE: column.doubles.remove(row); break;
+    case COLUMN_BOOL: column.bools.remove(row); break;
+    case COLUMN_STRING: column.strings.remove(row); break;
+    case COLUMN_VARIANT: column.variants.remove(row); break;
+    }
+
+    if(!column.missing.isEmpty())
+        column.missing.remove(row);
+}
+
+QVariant ColumnStore::cell(const Column &column, int row) const
+{
+    if(!column.missing.isEmpty() && column.missing.at(row))
+        return QVariant();
+
+    switch(column.type)
+    {
+    case COLUMN_INT: return QVariant(qlonglong(column.ints.at(row)));
+    case COLUMN_DOUBLE: return QVariant(column.doubles.at(row));
+    case COLUMN_BOOL: return QVariant(column.bools.at(row));
+    case COLUMN_STRING: return QVariant(column.strings.at(row));
+    case COLUMN_VARIANT: return column.variants.at(row);
+    }
+
+    return QVariant();
+}
@@ -0,0 +1,101 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * It is part of the QuickHub framework - www.quickhub.org
+ * Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de */
+
+
+#ifndef COLUMNSTORE_H
+#define COLUMNSTORE_H
+
+#include <QVariant>
+#include <QVector>
+#include <QHash>
+#include <QByteArray>
+
+/*!
+    \class ColumnStore
+    \brief Stores the rows of a list resource column by column.
+
+    Every key of the row maps becomes a column. The schema is inferred from the rows as they
+    arrive: a column holds ints, doubles, bools or strings in a plain vector as long as all its
+    values have that type, and falls back to QVariant values otherwise. Ints are widened to
+    doubles instead. Keys which are missing in a row are flagged, so row() returns the maps
+    exactly as they were stored, apart from ints which come back as qlonglong.
+
+    value() is a lookup in a vector and does not copy any map.
+*/
+
+class ColumnStore
+{
+public:
+    enum ColumnType
+    {
+        COLUMN_INT,
+        COLUMN_DOUBLE,
+        COLUMN_BOOL,
+        COLUMN_STRING,
+        COLUMN_VARIANT
+    };
+
+    int         count() const;
+    int         columnCount() const;
+    QByteArray  columnName(int column) const;
+    ColumnType  columnType(int column) const;
+
+    /*!
+        \fn int ColumnStore::columnIndex(const QByteArray& name) const
+        Returns the column of the given key or -1 if no row has it.
+    */
+    int         columnIndex(const QByteArray& name) const;
+
+    QVariant    value(int row, int column) const;
+    QVariantMap row(int row) const;
+
+    void        append(const QVariantList& rows);
+    void        insert(int row, const QVariant& data);
+    void        replace(int row, const QVariant& data);
+
+    /*!
+        \fn int ColumnStore::setValue(int row, const QByteArray& name, const QVariant& value)
+        Sets a single value and returns its column. A new column is added for unknown keys.
+    */
+    int         setValue(int row, const QByteArray& name, const QVariant& value);
+    void        remove(int row);
+    void        move(int from, int to);
+
+    /*!
+        \fn void ColumnStore::clear()
+        Removes all rows and forgets the schema.
+    */
+    void        clear();
+
+private:
+    struct Column
+    {
+        QByteArray          name;
+        ColumnType          type = COLUMN_VARIANT;
+        QVector<qint64>     ints;
+        QVector<double>     doubles;
+        QVector<bool>       bools;
+        QVector<QString>    strings;
+        QVector<QVariant>   variants;
+
+        // empty as long as no value is missing
+        QVector<bool>       missing;
+    };
+
+    int         addColumn(const QByteArray& name, const QVariant& value);
+    void        accept(Column& column, const QVariant& value);
+    void        promote(Column& column, ColumnType type);
+    void        insertCell(Column& column, int row, const QVariant& value);
+    void        setCell(Column& column, int row, const QVariant& value);
+    void        removeCell(Column& column, int row);
+    QVariant    cell(const Column& column, int row) const;
+
+    QVector<Column>         _columns;
+    QHash<QByteArray, int>  _columnIndex;
+    int                     _count = 0;
+};
+
+#endif // COLUMNSTORE_H
@@ -7,9 +7,11 @@
 #include "DeviceAdapterModel.h"
 #include "DeviceModel.h"
 #include "DevicePropertyModel.h"
+#include "../Helpers/ChangeCoalescer.h"
 #include <QVariant>
 
-DeviceAdapterModel::DeviceAdapterModel(QObject *parent) : QAbstractListModel(parent)
+DeviceAdapterModel::DeviceAdapterModel(QObject *parent) : QAbstractListModel(parent),
+    _coalescer(new ChangeCoalescer(this))
 {
 }
 
@@ -74,6 +76,7 @@ void DeviceAdapterModel::setDeviceModels(QList<DeviceModel *> models)
 void DeviceAdapterModel::addDeviceModel(DeviceModel *model)
 {
     connect(model, &DeviceModel::initializedChanged, this, &DeviceAdapterModel::propertiesChanged);
+    _coalescer->flush();
     beginInsertRows(QModelIndex(), _models.count(), _models.count());
     _models.append(model);
     endInsertRows();
@@ -96,6 +99,7 @@ bool DeviceAdapterModel::removeDeviceModel(DeviceModel *model)
         _propertyToIndexMap.remove(model);
     }
 
+    _coalescer->flush();
     beginRemoveRows(QModelIndex(), idx, idx);
     _models.removeAt(idx);
     reIndex();
@@ -116,6 +120,34 @@ bool DeviceAdapterModel::getInitialized() const
     return _initialized;
 }
 
+bool DeviceAdapterModel::coalesceChanges() const
+{
+    return _coalescer->isEnabled();
+}
+
+void DeviceAdapterModel::setCoalesceChanges(bool coalesceChanges)
+{
+    if(_coalescer->isEnabled() == coalesceChanges)
+        return;
+
+    _coalescer->setEnabled(coalesceChanges);
+    Q_EMIT coalesceChangesChanged();
+}
+
+int DeviceAdapterModel::coalesceInterval() const
+{
+    return _coalescer->interval();
+}
+
+void DeviceAdapterModel::setCoalesceInterval(int coalesceInterval)
+{
+    if(_coalescer->interval() == coalesceInterval)
+        return;
+
+    _coalescer->setInterval(coalesceInterval);
+    Q_EMIT coalesceIntervalChanged();
+}
+
 void DeviceAdapterModel::reIndex()
 {
     _propertyToIndexMap.clear();
@@ -141,7 +173,7 @@ void DeviceAdapterModel::propertyValueChanged()
        int role = roleNames().key("_"+model->getName().toLatin1(), -1);
        QVector<int> roles;
        roles << role;
-       Q_EMIT dataChanged(this->index(index), this->index(index), roles);
+       _coalescer->rowChanged(index, roles);
    }
 }
 
@@ -171,13 +203,14 @@ void DeviceAdapterModel::propertiesChanged()
 
     if(!uninitializedEntriesFound)
     {
+        _coalescer->flush();
         beginResetModel();
         endResetModel();
         _initialized = true;
         Q_EMIT initializedChanged();
     }
     Q_EMIT modelInitialized(model);
-    Q_EMIT dataChanged(this->index(index), this->index(index));
+    _coalescer->rowChanged(index);
 }
 
 
@@ -22,6 +22,7 @@
 
 class DeviceModel;
 class DevicePropertyModel;
+class ChangeCoalescer;
 class DeviceAdapterModel : public QAbstractListModel
 {
     Q_OBJECT
@@ -29,6 +30,14 @@ class DeviceAdapterModel : public QAbstractListModel
     Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
     Q_PROPERTY(bool initialized READ getInitialized NOTIFY initializedChanged)
 
+    /*!
+        \qmlproperty bool DeviceAdapterModel::coalesceChanges
+        If true, changed device properties are reported once per frame (or every coalesceInterval ms).
+        \sa ChangeCoalescer
+    */
+    Q_PROPERTY(bool coalesceChanges READ coalesceChanges WRITE setCoalesceChanges NOTIFY coalesceChangesChanged)
+    Q_PROPERTY(int coalesceInterval READ coalesceInterval WRITE setCoalesceInterval NOTIFY coalesceIntervalChanged)
+
 public:
     explicit DeviceAdapterModel(QObject *parent = nullptr);
 
@@ -46,9 +55,14 @@ public:
     bool                    removeDeviceModel(DeviceModel *model);
     Q_INVOKABLE  DeviceModel* getModelAt(int index);
     bool                    getInitialized() const;
+    bool                    coalesceChanges() const;
+    void                    setCoalesceChanges(bool coalesceChanges);
+    int                     coalesceInterval() const;
+    void                    setCoalesceInterval(int coalesceInterval);
 
 private:
     void reIndex();
+    ChangeCoalescer*        _coalescer;
     QList<DeviceModel*>     _models;
     mutable QHash<int, QByteArray> _roles;
     /*!
@@ -67,6 +81,8 @@ signals:
     void modelInitialized(DeviceModel* model);
     void countChanged();
     void initializedChanged();
+    void coalesceChangesChanged();
+    void coalesceIntervalChanged();
 
 
 public slots:
@@ -7,12 +7,17 @@
 #include <QJsonDocument>
 #include "DeviceModel.h"
 #include "DevicePropertyModel.h"
+#include "../Core/SubscriptionRegistry.h"
 #include <QJsonArray>
 
 DeviceModel::DeviceModel(QObject *parent) : QQmlPropertyMap(this, parent),
-    _communicationHandler(new ResourceCommunicationHandler("device", this))
+    _communicationHandler(nullptr)
 {
-    connect(_communicationHandler, &ResourceCommunicationHandler::newMessage, this, &DeviceModel::messageReceived);
+}
+
+DeviceModel::~DeviceModel()
+{
+    unsubscribe();
 }
 
 
@@ -24,6 +29,9 @@ bool DeviceModel::triggerFunction(QString name, QVariantMap parameters)
     msgParameters["funcparams"] = parameters;
     msgParameters["funcname"] = name;
     msg["parameters"] = msgParameters;
+    if(!_communicationHandler)
+        return false;
+
     _communicationHandler->sendMessage(msg);
     return true;
 }
@@ -82,8 +90,7 @@ void DeviceModel::setResource(const QString &resource)
     _initialized = false;
     Q_EMIT initializedChanged();
     _resource = resource;
-    _communicationHandler->setDescriptor(_resource);
-    _communicationHandler->attachModel();
+    subscribe();
     Q_EMIT resourceChanged();
 }
 
@@ -105,11 +112,14 @@ QMap<QString, DevicePropertyModel*> DeviceModel::deviceProperties() const
 
 bool DeviceModel::getConnected() const
 {
-    return _communicationHandler->isAttached();
+    return _communicationHandler && _communicationHandler->isAttached();
 }
 
 ResourceCommunicationHandler::ModelState DeviceModel::getModelState() const
 {
+    if(!_communicationHandler)
+        return ResourceCommunicationHandler::MODEL_DISCONNECTED;
+
     return _communicationHandler->getState();
 }
 
@@ -135,7 +145,8 @@ void DeviceModel::setDescription(const QString &description)
     QVariantMap msgParameters;
     msgParameters["desc"] = description;
     msg["parameters"] = msgParameters;
-    _communicationHandler->sendMessage(msg);
+    if(_communicationHandler)
+        _communicationHandler->sendMessage(msg);
 }
 
 QString DeviceModel::uuid() const
@@ -209,7 +220,8 @@ void DeviceModel::sendVariant(QString property, QVariant value)
     msgParameters["property"] = property;
     msgParameters["value"] = value;
     msg["parameters"] = msgParameters;
-    _communicationHandler->sendMessage(msg);
+    if(_communicationHandler)
+        _communicationHandler->sendMessage(msg);
 }
 
 void DeviceModel::metadataEdited(QString name, QString key, QVariant value)
@@ -221,7 +233,8 @@ void DeviceModel::metadataEdited(QString name, QString key, QVariant value)
     data[key] = value;
     parameters[name] = data;
     msg["parameters"] = parameters;
-    _communicationHandler->sendMessage(msg);
+    if(_communicationHandler)
+        _communicationHandler->sendMessage(msg);
 }
 
 QVariant DeviceModel::updateValue(const QString &key, const QVariant &input)
@@ -385,10 +398,67 @@ void DeviceModel::messageReceived(QVariant message)
 
 void DeviceModel::connectObject()
 {
-    _communicationHandler->attachModel();
+    if(!_communicationHandler)
+        subscribe();
 }
 
 void DeviceModel::disconnectObject()
 {
-    _communicationHandler->detachModel();
+    // the attachment is shared, only this model lets go of it
+    if(!_communicationHandler)
+        return;
+
+    unsubscribe();
+    Q_EMIT connectedChanged();
+    Q_EMIT modelStateChanged();
+}
+
+void DeviceModel::subscribe()
+{
+    unsubscribe();
+    if(_resource.isEmpty())
+        return;
+
+    SubscriptionRegistry* registry = SubscriptionRegistry::instance();
+    _communicationHandler = registry->acquireHandler(QStringLiteral("device"), _resource, this);
+    registry->connectSubscriber(_communicationHandler, this, [](QObject* subscriber) {
+        DeviceModel* model = qobject_cast<DeviceModel*>(subscriber);
+        return model && model->_initialized ? QVariant(model->dumpMessage()) : QVariant();
+    });
+}
+
+void DeviceModel::unsubscribe()
+{
+    if(!_communicationHandler)
+        return;
+
+    disconnect(_communicationHandler, nullptr, this, nullptr);
+    SubscriptionRegistry::instance()->release(_communicationHandler, this, [this]() {
+        return _initialized ? QVariant(dumpMessage()) : QVariant();
+    });
+    _communicationHandler = nullptr;
+}
+
+QVariantMap DeviceModel::dumpMessage() const
+{
+    QVariantList properties;
+    for(DevicePropertyModel* property : _properties)
+    {
+        properties << property->toMap();
+    }
+
+    QVariantMap parameters;
+    parameters["funcs"] = _functions;
+    parameters["props"] = properties;
+    parameters["on"] = _online;
+    parameters["desc"] = _description;
+    parameters["uuid"] = _uuid;
+    parameters["type"] = _type;
+    parameters["tmp"] = _temporary;
+    parameters["suid"] = _suid;
+
+    QVariantMap msg;
+    msg["command"] = "device:dump";
+    msg["parameters"] = parameters;
+    return msg;
 }
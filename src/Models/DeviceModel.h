@@ -110,6 +110,7 @@ class DeviceModel : public QQmlPropertyMap
 
 public:
     explicit DeviceModel(QObject *parent = nullptr);
+    ~DeviceModel();
     Q_INVOKABLE bool triggerFunction(QString name, QVariantMap parameters);
     Q_INVOKABLE DevicePropertyModel* getProperty(QString name);
     Q_INVOKABLE bool hasProperty(QString name);
@@ -141,6 +142,11 @@ public:
     bool getInitialized() const;
 
 private:
+    // see SubscriptionRegistry
+    void subscribe();
+    void unsubscribe();
+    QVariantMap dumpMessage() const;
+
     void checkIfPropertiesAreEditable();
     DevicePropertyModel* createPropertyModel(QString name, QVariantMap metadata = QVariantMap());
 
@@ -92,7 +92,20 @@ void DevicePropertyModel::setIconId(const QString &iconId)
 
 QVariantMap DevicePropertyModel::toMap() const
 {
-    return QVariantMap();
+    // the format of init()
+    QVariantMap metadata = _metadata;
+    metadata["unit"] = _unitString;
+    metadata["desc"] = _description;
+    metadata["icon"] = _iconId;
+
+    QVariantMap map;
+    map["name"] = _name;
+    map["val"] = _realValue;
+    map["setVal"] = _setValue;
+    map["timestamp"] = _timestamp;
+    map["dirty"] = _dirty;
+    map["metadata"] = metadata;
+    return map;
 }
 
 void DevicePropertyModel::setMedatada(QString key, QVariant value)
@@ -7,6 +7,7 @@
 #include "FilteredDeviceModel.h"
 #include "DeviceModel.h"
 #include "DevicePropertyModel.h"
+#include "../Core/AttachQueue.h"
 #include <QJsonDocument>
 #include <QDebug>
 #include <QRegularExpression>
@@ -95,6 +96,8 @@ void FilteredDeviceModel::modelReset()
     if(_deviceType.isEmpty())
         return;
 
+    // all devices are attached with one request
+    AttachQueue::instance()->beginBatch();
     QList<DeviceModel*> models;
     QListIterator<QVariant> it(_deviceHandleList);
     while(it.hasNext())
@@ -104,6 +107,7 @@ void FilteredDeviceModel::modelReset()
         if(model)
             models << model;
     }
+    AttachQueue::instance()->endBatch();
 
     if(!models.isEmpty())
         setDeviceModels(models);
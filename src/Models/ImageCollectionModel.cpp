@@ -6,15 +6,17 @@
 
 #include "ImageCollectionModel.h"
 #include "CloudModel.h"
+#include "../Core/SubscriptionRegistry.h"
 #include <QJsonDocument>
 #include <QUrlQuery>
 
-ImageCollectionModel::ImageCollectionModel(QObject *parent) : QAbstractListModel(parent),
-    _handler(new ResourceCommunicationHandler("imgcoll", this))
+ImageCollectionModel::ImageCollectionModel(QObject *parent) : QAbstractListModel(parent)
 {
-    connect(_handler,SIGNAL(newMessage(QVariant)), this, SLOT(messageReceived(QVariant)));
-    connect(_handler,SIGNAL(attachedChanged()), this, SIGNAL(connectedChanged()));
-    connect(_handler,SIGNAL(stateChanged()), this, SIGNAL(modelStateChanged()));
+}
+
+ImageCollectionModel::~ImageCollectionModel()
+{
+    unsubscribe();
 }
 
 QString ImageCollectionModel::resource() const
@@ -25,11 +27,14 @@ QString ImageCollectionModel::resource() const
 
 bool ImageCollectionModel::getConnected() const
 {
-    return _handler->isAttached();
+    return _handler && _handler->isAttached();
 }
 
 ResourceCommunicationHandler::ModelState ImageCollectionModel::getModelState() const
 {
+    if(!_handler)
+        return ResourceCommunicationHandler::MODEL_DISCONNECTED;
+
     return _handler->getState();
 }
 
@@ -132,7 +137,57 @@ void ImageCollectionModel::setResource(const QString &resourceName)
         return;
 
     _resource = resourceName;
-    _handler->setDescriptor(_resource);
-    _handler->attachModel();
+    subscribe();
     Q_EMIT resourceChanged();
 }
+
+void ImageCollectionModel::subscribe()
+{
+    unsubscribe();
+    if(!_data.isEmpty())
+    {
+        beginResetModel();
+        _data.clear();
+        endResetModel();
+    }
+
+    if(_resource.isEmpty())
+        return;
+
+    SubscriptionRegistry* registry = SubscriptionRegistry::instance();
+    _handler = registry->acquireHandler(QStringLiteral("imgcoll"), _resource, this);
+    registry->connectSubscriber(_handler, this, [](QObject* subscriber) {
+        ImageCollectionModel* model = qobject_cast<ImageCollectionModel*>(subscriber);
+        return model && !model->_data.isEmpty() ? QVariant(model->dumpMessage()) : QVariant();
+    });
+}
+
+void ImageCollectionModel::unsubscribe()
+{
+    if(!_handler)
+        return;
+
+    disconnect(_handler, nullptr, this, nullptr);
+    SubscriptionRegistry::instance()->release(_handler, this, [this]() {
+        return !_data.isEmpty() ? QVariant(dumpMessage()) : QVariant();
+    });
+    _handler = nullptr;
+}
+
+QVariantMap ImageCollectionModel::dumpMessage() const
+{
+    QVariantMap data;
+    for(const QVariant& item : _data)
+    {
+        QVariantMap map = item.toMap();
+        data[map["uid"].toString()] = map["metadata"];
+    }
+
+    QVariantMap parameters;
+    parameters["data"] = data;
+
+    QVariantMap msg;
+    msg["command"] = "imgcoll:dump";
+    msg["parameters"] = parameters;
+    return msg;
+}
@@ -39,6 +39,7 @@ public:
     };
 
     explicit ImageCollectionModel(QObject *parent = nullptr);
+    ~ImageCollectionModel();
 
     QString resource() const;
     void setResource(const QString &resource);
@@ -56,6 +57,11 @@ signals:
     void modelStateChanged();
 
 private:
+    // see SubscriptionRegistry
+    void subscribe();
+    void unsubscribe();
+    QVariantMap dumpMessage() const;
+
     ResourceCommunicationHandler* _handler = nullptr;
     QString _resource;
     QList<QVariant> _data;
@@ -11,6 +11,47 @@
 #include "SynchronizedListLogic.h"
 #include "../Core/CloudModel.h"
 
+namespace {
+
+// marks the items of the longest strictly increasing subsequence, O(n log n)
+QVector<bool> longestIncreasingSubsequence(const QVector<int>& values)
+{
+    QVector<int> tails;
+    QVector<int> previous(values.count(), -1);
+    for(int i = 0; i < values.count(); i++)
+    {
+        int low = 0;
+        int high = tails.count();
+        while(low < high)
+        {
+            int mid = (low + high) / 2;
+            if(values.at(tails.at(mid)) < values.at(i))
+                low = mid + 1;
+            else
+                high = mid;
+        }
+
+        if(low > 0)
+            previous[i] = tails.at(low - 1);
+
+        if(low == tails.count())
+            tails << i;
+        else
+            tails[low] = i;
+    }
+
+    QVector<bool> result(values.count(), false);
+    int i = tails.isEmpty() ? -1 : tails.last();
+    while(i >= 0)
+    {
+        result[i] = true;
+        i = previous.at(i);
+    }
+    return result;
+}
+
+}
+
 
 SynchronizedListLogic::SynchronizedListLogic(QObject *parent) : QObject(parent),
     _communicationHandler(new ResourceCommunicationHandler("synclist", this))
@@ -18,31 +59,37 @@ SynchronizedListLogic::SynchronizedListLogic(QObject *parent) : QObject(parent),
     connect(_communicationHandler,SIGNAL(newMessage(QVariant)), this, SLOT(messageReceived(QVariant)));
     connect(_communicationHandler,SIGNAL(attachedChanged()), this, SIGNAL(connectedChanged()));
     connect(_communicationHandler,SIGNAL(stateChanged()), this, SLOT(stateChanged()));
+    connect(&_mutationTimer, &QTimer::timeout, this, &SynchronizedListLogic::mutationTimedOut);
+    _mutationTimer.setSingleShot(true);
+    _clock.start();
 }
 
 QString SynchronizedListLogic::getUserIDForIndex(int index)
 {
-    if(_metaInfo.size() > index && index >= 0)
+    const MetaInfo* info = metaInfoAt(index);
+    if(info)
     {
-        return _metaInfo.at(index).user;
+        return info->user;
     }
     return "unknown";
 }
 
 qint64 SynchronizedListLogic::getTimestampForIndex(int index)
 {
-    if(_metaInfo.size() > index && index >= 0)
+    const MetaInfo* info = metaInfoAt(index);
+    if(info)
     {
-        return _metaInfo.at(index).lastUpdate;
+        return info->lastUpdate;
     }
     return -1;
 }
 
 QString SynchronizedListLogic::getUUIDForIndex(int index)
 {
-    if(_metaInfo.size() > index && index >= 0)
+    const MetaInfo* info = metaInfoAt(index);
+    if(info)
     {
-        return _metaInfo.at(index).uuid;
+        return uuidString(*info);
     }
     return "";
 }
@@ -53,10 +100,23 @@ void SynchronizedListLogic::insertAt(int index, QVariantMap obj)
     parameters[QStringLiteral("index")] = index;
     parameters[QStringLiteral("data")] = obj;
 
+    if(_optimistic)
+    {
+        PendingMutation mutation;
+        mutation.command = QStringLiteral("synclist:insertat");
+        mutation.applied = mutatesLocally(false);
+        if(mutation.applied)
+        {
+            mutation.uuid = QUuid::createUuid().toString();
+            insertItem(localItem(mutation.uuid, obj), qBound(0, index, _metaInfo.count()));
+        }
+        addPendingMutation(mutation, parameters);
+    }
+
     QVariantMap msg;
     msg[QStringLiteral("command")] = "synclist:insertat";
     msg[QStringLiteral("parameters")] = parameters;
-    _communicationHandler->sendMessage(msg);
+    sendMutation(msg);
 }
 
 void SynchronizedListLogic::append(QObject *obj)
@@ -79,10 +139,23 @@ void SynchronizedListLogic::append(QVariantMap data)
     QVariantMap parameters;
     parameters[QStringLiteral("data")] = data;
 
+    if(_optimistic)
+    {
+        PendingMutation mutation;
+        mutation.command = QStringLiteral("synclist:append");
+        mutation.applied = mutatesLocally(false);
+        if(mutation.applied)
+        {
+            mutation.uuid = QUuid::createUuid().toString();
+            insertItem(localItem(mutation.uuid, data));
+        }
+        addPendingMutation(mutation, parameters);
+    }
+
     QVariantMap msg;
     msg[QStringLiteral("command")] = "synclist:append";
     msg[QStringLiteral("parameters")] = parameters;
-    _communicationHandler->sendMessage(msg);
+    sendMutation(msg);
 }
 
 void SynchronizedListLogic::appendList(QVariantList list)
@@ -92,7 +165,7 @@ void SynchronizedListLogic::appendList(QVariantList list)
     QVariantMap msg;
     msg[QStringLiteral("command")] = "synclist:appendlist";
     msg[QStringLiteral("parameters")] = parameters;
-    _communicationHandler->sendMessage(msg);
+    sendMutation(msg);
 }
 
 void SynchronizedListLogic::set(int index, QVariantMap data)
@@ -100,40 +173,75 @@ void SynchronizedListLogic::set(int index, QVariantMap data)
     QVariantMap parameters;
     parameters[QStringLiteral("data")] = data;
     parameters[QStringLiteral("index")] = index;
-    if(index >= 0 && index < _metaInfo.count())
+    const MetaInfo* info = metaInfoAt(index);
+    if(info)
     {
-        parameters[QStringLiteral("uuid")] = _metaInfo.at(index).uuid;
+        parameters[QStringLiteral("uuid")] = uuidString(*info);
+    }
+
+    if(_optimistic)
+    {
+        PendingMutation mutation;
+        mutation.command = QStringLiteral("synclist:set");
+        mutation.applied = info && mutatesLocally(true);
+        if(mutation.applied)
+        {
+            mutation.uuid = uuidString(*info);
+            mutation.previous = currentItem(index);
+            updateItem(localItem(mutation.uuid, data), index);
+        }
+        addPendingMutation(mutation, parameters);
     }
 
     QVariantMap msg;
     msg[QStringLiteral("command")] = "synclist:set";
     msg[QStringLiteral("parameters")] = parameters;
-    _communicationHandler->sendMessage(msg);
+    sendMutation(msg);
 }
 
 void SynchronizedListLogic::clear()
 {
     QVariantMap msg;
     msg[QStringLiteral("command")] = "synclist:clear";
-    _communicationHandler->sendMessage(msg);
+    sendMutation(msg);
 }
 
 int SynchronizedListLogic::getIndexForUUID(QString uuid)
 {
+    if(_windowed)
+        return windowIndexOf(uuid);
+
     return checkAndCorrectIndex(-1, uuid);
 }
 
 void SynchronizedListLogic::remove(int index)
 {
-    if(index >= 0 && index < _metaInfo.count())
+    const MetaInfo* info = metaInfoAt(index);
+    if(info)
     {
         QVariantMap msg;
         msg[QStringLiteral("command")] = "synclist:remove";
         QVariantMap parameters;
-        parameters[QStringLiteral("uuid")] = _metaInfo.at(index).uuid;
+        parameters[QStringLiteral("uuid")] = uuidString(*info);
         parameters[QStringLiteral("index")] = index;
+
+        if(_optimistic)
+        {
+            PendingMutation mutation;
+            mutation.command = QStringLiteral("synclist:remove");
+            mutation.applied = mutatesLocally(true);
+            if(mutation.applied)
+            {
+                mutation.uuid = uuidString(*info);
+                mutation.index = index;
+                mutation.previous = currentItem(index);
+                removeItem(index);
+            }
+            addPendingMutation(mutation, parameters);
+        }
+
         msg[QStringLiteral("parameters")] = parameters;
-        _communicationHandler->sendMessage(msg);
+        sendMutation(msg);
     }
 }
 
@@ -158,18 +266,35 @@ void SynchronizedListLogic::setFilter(const QVariantMap &filter)
 
 void SynchronizedListLogic::setProperty(int index, QString property, QVariant val)
 {
-    if((index < 0) | (index >= _metaInfo.count()))
+    const MetaInfo* info = metaInfoAt(index);
+    if(!info)
         return;
 
     QVariantMap msg;
     msg[QStringLiteral("command")] = "synclist:property:set";
     QVariantMap parameters;
     parameters[QStringLiteral("data")] = val;
-    parameters[QStringLiteral("uuid")] = _metaInfo.at(index).uuid;
+    parameters[QStringLiteral("uuid")] = uuidString(*info);
     parameters[QStringLiteral("index")] = index;
     parameters[QStringLiteral("property")] = property;
+
+    if(_optimistic)
+    {
+        PendingMutation mutation;
+        mutation.command = QStringLiteral("synclist:property:set");
+        mutation.applied = mutatesLocally(true);
+        if(mutation.applied)
+        {
+            mutation.uuid = uuidString(*info);
+            mutation.property = property;
+            mutation.previous = currentItem(index);
+            updateProperty(info->lastUpdate, property, val, index);
+        }
+        addPendingMutation(mutation, parameters);
+    }
+
     msg[QStringLiteral("parameters")]  = parameters;
-    _communicationHandler->sendMessage(msg);
+    sendMutation(msg);
 }
 
 int SynchronizedListLogic::checkAndCorrectIndex(int index, QString uuid)
@@ -180,24 +305,297 @@ int SynchronizedListLogic::checkAndCorrectIndex(int index, QString uuid)
     // let's hope that the order of items in the list didn't changed
     if(index >= 0 && _metaInfo.count() > index)
     {
-        if(_metaInfo.at(index).uuid == uuid)
+        if(uuidString(_metaInfo.at(index)) == uuid)
         {
             return index;
         }
     }
 
-    // need to search the appropriate index manually :(
-    QListIterator<MetaInfo> it(_metaInfo);
-    int i = 0;
-    while(it.hasNext())
+    return _uuidIndex.indexOf(uuid);
+}
+
+void SynchronizedListLogic::setOptimistic(bool optimistic)
+{
+    _optimistic = optimistic;
+}
+
+bool SynchronizedListLogic::optimistic() const
+{
+    return _optimistic;
+}
+
+void SynchronizedListLogic::setMutationTimeout(int timeout)
+{
+    _mutationTimeout = timeout;
+}
+
+int SynchronizedListLogic::mutationTimeout() const
+{
+    return _mutationTimeout;
+}
+
+void SynchronizedListLogic::beginBatch()
+{
+    _batchDepth++;
+}
+
+QString SynchronizedListLogic::commit()
+{
+    if(_batchDepth <= 0)
+        return QString();
+
+    if(--_batchDepth > 0 || _batch.isEmpty())
+        return QString();
+
+    const QString batchId = QString::number(++_batchCounter);
+    QVariantList operations;
+    operations.swap(_batch);
+
+    // the timeout of optimistic changes starts when they are sent
+    QSet<QString> opIds;
+    for(const QVariant& operation : qAsConst(operations))
     {
-        if(it.next().uuid == uuid)
-        {
-            return i;
-        }
-        i++;
+        opIds.insert(operation.toMap().value(QStringLiteral("parameters")).toMap().value(QStringLiteral("opid")).toString());
     }
-    return -1;
+    for(PendingMutation& mutation : _pendingMutations)
+    {
+        if(opIds.contains(mutation.opId))
+            mutation.sent = _clock.elapsed();
+    }
+
+    QVariantMap parameters;
+    parameters[QStringLiteral("batchid")] = batchId;
+    parameters[QStringLiteral("operations")] = operations;
+
+    QVariantMap msg;
+    msg[QStringLiteral("command")] = "synclist:batch";
+    msg[QStringLiteral("parameters")] = parameters;
+    _sentBatches.insert(batchId, operations);
+    _communicationHandler->sendMessage(msg);
+    return batchId;
+}
+
+bool SynchronizedListLogic::isBatching() const
+{
+    return _batchDepth > 0;
+}
+
+void SynchronizedListLogic::sendMutation(const QVariantMap &msg)
+{
+    if(_batchDepth > 0)
+    {
+        _batch << msg;
+        return;
+    }
+
+    _communicationHandler->sendMessage(msg);
+}
+
+void SynchronizedListLogic::setRowSource(std::function<QVariantMap (int)> source)
+{
+    _rowSource = source;
+}
+
+bool SynchronizedListLogic::mutatesLocally(bool needsRow) const
+{
+    if(_windowed || !_initialized)
+        return false;
+
+    if(needsRow)
+        return bool(_rowSource);
+
+    // rows are only added locally if they cannot end up between rows which are not loaded yet
+    return _remoteItemCount == _metaInfo.count() - localRowDelta();
+}
+
+void SynchronizedListLogic::addPendingMutation(PendingMutation mutation, QVariantMap &parameters)
+{
+    mutation.opId = QString::number(++_mutationCounter);
+    mutation.sent = _clock.elapsed();
+    parameters[QStringLiteral("opid")] = mutation.opId;
+    _pendingMutations << mutation;
+
+    if(!_mutationTimer.isActive())
+        _mutationTimer.start(_mutationTimeout);
+}
+
+bool SynchronizedListLogic::takePendingMutation(const QString &command, const QVariantMap &parameters, PendingMutation *mutation)
+{
+    // replies arrive in the order of the requests, servers which do not return the opid are matched by command
+    const QString opId = parameters.value(QStringLiteral("opid")).toString();
+    for(int i = 0; i < _pendingMutations.count(); i++)
+    {
+        const PendingMutation& pending = _pendingMutations.at(i);
+        if(opId.isEmpty() ? pending.command != command : pending.opId != opId)
+            continue;
+
+        if(mutation)
+            *mutation = pending;
+
+        _pendingMutations.removeAt(i);
+        if(_pendingMutations.isEmpty())
+            _mutationTimer.stop();
+
+        return true;
+    }
+
+    return false;
+}
+
+void SynchronizedListLogic::rollback(const PendingMutation &mutation)
+{
+    if(!mutation.applied)
+        return;
+
+    int index = _uuidIndex.indexOf(mutation.uuid);
+    if(mutation.command == QLatin1String("synclist:append") || mutation.command == QLatin1String("synclist:insertat"))
+    {
+        if(index >= 0)
+            removeItem(index);
+
+        return;
+    }
+
+    if(mutation.command == QLatin1String("synclist:remove"))
+    {
+        if(index < 0)
+            insertItem(mutation.previous, qBound(0, mutation.index, _metaInfo.count()));
+
+        return;
+    }
+
+    if(index < 0)
+        return;
+
+    if(mutation.command == QLatin1String("synclist:set"))
+    {
+        updateItem(mutation.previous, index);
+        return;
+    }
+
+    if(mutation.command == QLatin1String("synclist:property:set"))
+    {
+        const QVariant value = mutation.previous.value(QStringLiteral("data")).toMap().value(mutation.property);
+        updateProperty(mutation.previous.value(QStringLiteral("lastupdate")).toLongLong(), mutation.property, value, index);
+    }
+}
+
+void SynchronizedListLogic::rollbackAll(const QString &errorString)
+{
+    QList<PendingMutation> mutations = _pendingMutations;
+    clearPendingMutations();
+
+    // later changes may depend on earlier ones
+    for(int i = mutations.count() - 1; i >= 0; i--)
+    {
+        rollback(mutations.at(i));
+        Q_EMIT mutationFailed(mutations.at(i).command, errorString);
+    }
+}
+
+void SynchronizedListLogic::clearPendingMutations()
+{
+    _pendingMutations.clear();
+    _mutationTimer.stop();
+}
+
+int SynchronizedListLogic::localRowDelta() const
+{
+    int delta = 0;
+    for(const PendingMutation& mutation : _pendingMutations)
+    {
+        if(!mutation.applied)
+            continue;
+
+        if(mutation.command == QLatin1String("synclist:append") || mutation.command == QLatin1String("synclist:insertat"))
+            delta++;
+        else if(mutation.command == QLatin1String("synclist:remove"))
+            delta--;
+    }
+
+    return delta;
+}
+
+int SynchronizedListLogic::appendPosition() const
+{
+    // rows appended by other clients were appended before the rows which are still pending
+    int pending = 0;
+    for(const PendingMutation& mutation : _pendingMutations)
+    {
+        if(mutation.applied && mutation.command == QLatin1String("synclist:append"))
+            pending++;
+    }
+
+    return pending > 0 ? _metaInfo.count() - pending : -1;
+}
+
+QVariantMap SynchronizedListLogic::localItem(const QString &uuid, const QVariant &data) const
+{
+    // lastupdate 0 makes the next dump replace the row
+    QVariantMap item;
+    item[QStringLiteral("uuid")] = uuid;
+    item[QStringLiteral("userid")] = CloudModel::instance()->getUserID();
+    item[QStringLiteral("lastupdate")] = 0;
+    item[QStringLiteral("data")] = data;
+    return item;
+}
+
+QVariantMap SynchronizedListLogic::currentItem(int index) const
+{
+    const MetaInfo& info = _metaInfo.at(index);
+    QVariantMap item;
+    item[QStringLiteral("uuid")] = uuidString(info);
+    item[QStringLiteral("userid")] = info.user;
+    item[QStringLiteral("lastupdate")] = info.lastUpdate;
+    item[QStringLiteral("data")] = _rowSource(index);
+    return item;
+}
+
+void SynchronizedListLogic::mutationTimedOut()
+{
+    if(_pendingMutations.isEmpty())
+        return;
+
+    // changes of an open batch are not sent yet
+    if(_batchDepth > 0)
+    {
+        _mutationTimer.start(_mutationTimeout);
+        return;
+    }
+
+    qint64 age = _clock.elapsed() - _pendingMutations.first().sent;
+    if(age < _mutationTimeout)
+    {
+        _mutationTimer.start(int(_mutationTimeout - age));
+        return;
+    }
+
+    // the server state is unknown, the dump tells which changes were applied after all
+    rollbackAll(QStringLiteral("timeout"));
+    if(_communicationHandler->isAttached())
+        requestDump();
+}
+
+SynchronizedListLogic::MetaInfo SynchronizedListLogic::metaInfo(const QVariantMap &item)
+{
+    MetaInfo info;
+    info.user = item.value(QStringLiteral("userid")).toString();
+    info.lastUpdate = item.value(QStringLiteral("lastupdate")).toLongLong();
+
+    const QString uuid = item.value(QStringLiteral("uuid")).toString();
+    info.uuid = QUuid(uuid);
+    if(info.uuid.isNull() || info.uuid.toString() != uuid)
+        info.id = uuid;
+
+    return info;
+}
+
+QString SynchronizedListLogic::uuidString(const MetaInfo &info)
+{
+    if(!info.id.isNull())
+        return info.id;
+
+    return info.uuid.toString();
 }
 
 void SynchronizedListLogic::setPreloadCount(int preloadCount)
@@ -205,6 +603,11 @@ void SynchronizedListLogic::setPreloadCount(int preloadCount)
     _preloadCount = preloadCount;
 }
 
+int SynchronizedListLogic::preloadCount() const
+{
+    return _preloadCount;
+}
+
 int SynchronizedListLogic::getRemoteItemCount() const
 {
     return _remoteItemCount;
@@ -231,6 +634,323 @@ void SynchronizedListLogic::fetchMore()
 }
 
 
+void SynchronizedListLogic::setWindowSize(int windowSize)
+{
+    _windowSize = windowSize;
+    if(_windowed)
+        evictPages();
+}
+
+int SynchronizedListLogic::windowSize() const
+{
+    return _windowSize;
+}
+
+bool SynchronizedListLogic::isWindowed() const
+{
+    return _windowed;
+}
+
+int SynchronizedListLogic::pageSize() const
+{
+    return qMax(1, _preloadCount);
+}
+
+bool SynchronizedListLogic::isPageLoaded(int page) const
+{
+    return _pages.contains(page);
+}
+
+void SynchronizedListLogic::touchPage(int page)
+{
+    auto it = _pages.find(page);
+    if(it != _pages.end())
+        it->lastUsed = ++_pageUseCounter;
+}
+
+void SynchronizedListLogic::requestPage(int page)
+{
+    if(!_windowed || page < 0 || page * pageSize() >= _remoteItemCount)
+        return;
+
+    if(_pages.contains(page))
+    {
+        touchPage(page);
+        return;
+    }
+
+    if(_pendingPages.contains(page))
+        return;
+
+    // the higher the latency, the more rows are fetched per round trip
+    int pageCount = 1;
+    if(_pageRtt > 0)
+        pageCount = qBound(1, int(_pageRtt / PAGE_RTT_STEP) + 1, qMax(1, maxWindowPages() / 2));
+
+    int count = 0;
+    while(count < pageCount)
+    {
+        int next = page + count;
+        if(next * pageSize() >= _remoteItemCount || _pages.contains(next) || _pendingPages.contains(next))
+            break;
+
+        _pendingPages.insert(next);
+        count++;
+    }
+
+    PageRequest request;
+    request.firstPage = page;
+    request.pageCount = count;
+    request.sent = _clock.elapsed();
+    request.generation = _windowGeneration;
+    _pageRequests.append(request);
+    loadItems(page * pageSize(), count * pageSize());
+}
+
+void SynchronizedListLogic::pageReceived(const QVariantMap &parameters)
+{
+    // synclist:get does not echo the range, the server answers in order
+    if(_pageRequests.isEmpty())
+        return;
+
+    PageRequest request = _pageRequests.takeFirst();
+    qint64 rtt = _clock.elapsed() - request.sent;
+    _pageRtt = _pageRtt < 0 ? rtt : (_pageRtt * 7 + rtt) / 8;
+
+    // rows were inserted or removed in the meantime
+    if(request.generation != _windowGeneration)
+        return;
+
+    QVariantList list = parameters.value(QStringLiteral("data")).toList();
+    for(int i = 0; i < request.pageCount; i++)
+    {
+        int page = request.firstPage + i;
+        _pendingPages.remove(page);
+
+        QVariantList items = list.mid(i * pageSize(), pageSize());
+        if(items.isEmpty())
+            continue;
+
+        WindowPage windowPage;
+        windowPage.lastUsed = ++_pageUseCounter;
+        windowPage.rows.reserve(items.count());
+        QVariantList data;
+        data.reserve(items.count());
+        for(const QVariant& item : items)
+        {
+            const QVariantMap map = item.toMap();
+            windowPage.rows << metaInfo(map);
+            data << map.value(QStringLiteral("data"));
+        }
+
+        _pages.insert(page, windowPage);
+        Q_EMIT pageLoaded(page, data);
+    }
+
+    evictPages();
+}
+
+bool SynchronizedListLogic::handleWindowMessage(const QString &cmd, const QVariantMap &parameters, bool wasSender)
+{
+    const QVariant data = parameters.value(QStringLiteral("data"));
+
+    if(cmd == "synclist:get")
+    {
+        pageReceived(parameters);
+        return true;
+    }
+
+    if(cmd == "synclist:append")
+    {
+        insertWindowRows(_remoteItemCount, 1);
+    }
+    else if(cmd == "synclist:appendlist")
+    {
+        insertWindowRows(_remoteItemCount, data.toList().count());
+    }
+    else if(cmd == "synclist:insertat")
+    {
+        int index = parameters.value(QStringLiteral("index")).toInt();
+        insertWindowRows(qBound(0, index, _remoteItemCount), 1);
+    }
+    else if(cmd == "synclist:remove")
+    {
+        int index = windowIndex(parameters);
+        if(index < 0 || index >= _remoteItemCount)
+            return true;
+
+        removeWindowRows(index, 1);
+    }
+    else if(cmd == "synclist:property:set")
+    {
+        // rows which are not loaded are fetched with their current values later
+        int index = windowIndex(parameters);
+        if(!metaInfoAt(index))
+            return true;
+
+        _pages[index / pageSize()].rows[index % pageSize()].lastUpdate = parameters.value(QStringLiteral("lastupdate")).toLongLong();
+        Q_EMIT itemPropertyChanged(index, parameters.value(QStringLiteral("property")).toString(), data);
+    }
+    else if(cmd == "synclist:set")
+    {
+        int index = windowIndex(parameters);
+        if(!metaInfoAt(index))
+            return true;
+
+        const QVariantMap item = data.toMap();
+        _pages[index / pageSize()].rows[index % pageSize()] = metaInfo(item);
+        Q_EMIT itemUpdated(index, item.value(QStringLiteral("data")));
+    }
+    else if(cmd == "synclist:clear" || cmd == "synclist:delete")
+    {
+        if(cmd == "synclist:delete")
+        {
+            _metadata.clear();
+            Q_EMIT metadataChanged();
+        }
+
+        dropPagesFrom(0);
+        _remoteItemCount = 0;
+        Q_EMIT windowReset(0);
+    }
+    else
+    {
+        return false;
+    }
+
+    if(wasSender && !_applyingBatch)
+        Q_EMIT listSuccessfullModified();
+
+    return true;
+}
+
+void SynchronizedListLogic::insertWindowRows(int index, int count)
+{
+    if(count <= 0)
+        return;
+
+    dropPagesFrom(index / pageSize());
+    _remoteItemCount += count;
+    Q_EMIT windowRowsInserted(index, count);
+}
+
+void SynchronizedListLogic::removeWindowRows(int index, int count)
+{
+    if(count <= 0)
+        return;
+
+    dropPagesFrom(index / pageSize());
+    _remoteItemCount -= count;
+    Q_EMIT windowRowsRemoved(index, count);
+}
+
+void SynchronizedListLogic::dropPagesFrom(int page)
+{
+    // the rows behind a change have moved, so these pages and all pending replies are outdated
+    _windowGeneration++;
+
+    QList<int> dropped = _pendingPages.values();
+    _pendingPages.clear();
+
+    QMutableHashIterator<int, WindowPage> it(_pages);
+    while(it.hasNext())
+    {
+        it.next();
+        if(it.key() >= page)
+        {
+            dropped << it.key();
+            it.remove();
+        }
+    }
+
+    for(int droppedPage : dropped)
+    {
+        Q_EMIT pageEvicted(droppedPage);
+    }
+}
+
+void SynchronizedListLogic::evictPages()
+{
+    while(_pages.count() > maxWindowPages())
+    {
+        int oldest = -1;
+        quint64 lastUsed = 0;
+        QHashIterator<int, WindowPage> it(_pages);
+        while(it.hasNext())
+        {
+            it.next();
+            if(oldest < 0 || it.value().lastUsed < lastUsed)
+            {
+                oldest = it.key();
+                lastUsed = it.value().lastUsed;
+            }
+        }
+
+        _pages.remove(oldest);
+        Q_EMIT pageEvicted(oldest);
+    }
+}
+
+void SynchronizedListLogic::clearWindow()
+{
+    _pages.clear();
+    _pendingPages.clear();
+    _windowGeneration++;
+    _windowed = false;
+}
+
+int SynchronizedListLogic::maxWindowPages() const
+{
+    return qMax(2, (_windowSize + pageSize() - 1) / pageSize());
+}
+
+int SynchronizedListLogic::windowIndexOf(const QString &uuid) const
+{
+    QHashIterator<int, WindowPage> it(_pages);
+    while(it.hasNext())
+    {
+        it.next();
+        const QVector<MetaInfo>& rows = it.value().rows;
+        for(int i = 0; i < rows.count(); i++)
+        {
+            if(uuidString(rows.at(i)) == uuid)
+                return it.key() * pageSize() + i;
+        }
+    }
+    return -1;
+}
+
+int SynchronizedListLogic::windowIndex(const QVariantMap &parameters) const
+{
+    int index = parameters.value(QStringLiteral("index")).toInt();
+    QString uuid = parameters.value(QStringLiteral("uuid")).toString();
+    const MetaInfo* info = metaInfoAt(index);
+    if(uuid.isEmpty() || (info && uuidString(*info) == uuid))
+        return index;
+
+    // only loaded rows can be checked, the index of other rows is trusted
+    int loadedIndex = windowIndexOf(uuid);
+    if(loadedIndex >= 0)
+        return loadedIndex;
+
+    return info ? -1 : index;
+}
+
+const SynchronizedListLogic::MetaInfo *SynchronizedListLogic::metaInfoAt(int index) const
+{
+    if(index < 0)
+        return nullptr;
+
+    if(!_windowed)
+        return index < _metaInfo.count() ? &_metaInfo.at(index) : nullptr;
+
+    auto it = _pages.constFind(index / pageSize());
+    if(it == _pages.constEnd() || index % pageSize() >= it->rows.count())
+        return nullptr;
+
+    return &it->rows.at(index % pageSize());
+}
+
 void SynchronizedListLogic::requestDump()
 {
     QVariantMap msg;
@@ -261,7 +981,7 @@ void SynchronizedListLogic::setMetadata(const QVariantMap &metadata)
     QVariantMap parameters;
     parameters[QStringLiteral("metadata")] = metadata;
     msg[QStringLiteral("parameters")]  = parameters;
-    _communicationHandler->sendMessage(msg);
+    sendMutation(msg);
 }
 
 QString SynchronizedListLogic::getResource() const
@@ -274,11 +994,24 @@ void SynchronizedListLogic::setResource(const QString &resourceName)
     _resource = resourceName;
     _initialized = false;
     Q_EMIT initializedChanged(false);
+    clearPendingMutations();
+    _sentBatches.clear();
     this->clearAll();
     _communicationHandler->setDescriptor(_resource);
     _communicationHandler->attachModel();
 }
 
+void SynchronizedListLogic::restore(const QVariantList &items, const QVariantMap &metadata)
+{
+    if(_initialized)
+        return;
+
+    _metadata = metadata;
+    Q_EMIT metadataChanged();
+    clearAll();
+    appendMulti(items);
+}
+
 
 void SynchronizedListLogic::insertMulti(QVariantList items, int index)
 {
@@ -297,16 +1030,15 @@ void SynchronizedListLogic::insertMulti(QVariantList items, int index)
 
     int startIndex = i;
     QVariantList data;
+    data.reserve(items.count());
     QListIterator<QVariant> it(items);
     while(it.hasNext())
     {
-        QVariantMap item = it.next().toMap();
-        MetaInfo info;
-        info.user = item[QStringLiteral("userid")].toString();
-        info.lastUpdate = item[QStringLiteral("userid")].toLongLong();
-        info.uuid = item[QStringLiteral("uuid")].toString();
+        const QVariantMap item = it.next().toMap();
+        const MetaInfo info = metaInfo(item);
         _metaInfo.insert(i, info);
-        data << item[QStringLiteral("data")];
+        _uuidIndex.insert(i, uuidString(info));
+        data << item.value(QStringLiteral("data"));
         i++;
     }
 
@@ -316,41 +1048,133 @@ void SynchronizedListLogic::insertMulti(QVariantList items, int index)
 void SynchronizedListLogic::appendMulti(QVariantList items)
 {
     QVariantList data;
+    data.reserve(items.count());
     QListIterator<QVariant> it(items);
     while(it.hasNext())
     {
-        QVariantMap item = it.next().toMap();
-        MetaInfo info;
-        info.user = item[QStringLiteral("userid")].toString();
-        info.lastUpdate = item[QStringLiteral("userid")].toLongLong();
-        info.uuid = item[QStringLiteral("uuid")].toString();
+        const QVariantMap item = it.next().toMap();
+        const MetaInfo info = metaInfo(item);
         _metaInfo.append(info);
-        data << item[QStringLiteral("data")];
+        _uuidIndex.append(uuidString(info));
+        data << item.value(QStringLiteral("data"));
     }
     Q_EMIT itemsAppended(data);
 }
 
 void SynchronizedListLogic::insertItem(QVariant item, int index)
 {
-    QVariantMap map = item.toMap();
-    MetaInfo info;
-    info.user = map[QStringLiteral("userid")].toString();
-    info.lastUpdate = map[QStringLiteral("userid")].toLongLong();
-    info.uuid = map[QStringLiteral("uuid")].toString();
+    const QVariantMap map = item.toMap();
+    const MetaInfo info = metaInfo(map);
 
     if(index >= 0)
+    {
         _metaInfo.insert(index, info);
+        _uuidIndex.insert(index, uuidString(info));
+    }
     else
+    {
         _metaInfo.append(info);
-    Q_EMIT itemAdded(index, map[QStringLiteral("data")]);
+        _uuidIndex.append(uuidString(info));
+    }
+    Q_EMIT itemAdded(index, map.value(QStringLiteral("data")));
 }
 
 void SynchronizedListLogic::removeItem(int index)
 {
     _metaInfo.removeAt(index);
+    _uuidIndex.remove(index);
     Q_EMIT itemRemoved(index);
 }
 
+void SynchronizedListLogic::moveItem(int from, int to)
+{
+    const MetaInfo info = _metaInfo.at(from);
+    _metaInfo.move(from, to);
+    _uuidIndex.remove(from);
+    _uuidIndex.insert(to, uuidString(info));
+    Q_EMIT itemMoved(from, to);
+}
+
+void SynchronizedListLogic::resynchronize(QVariantList items)
+{
+    QVector<QString> uuids;
+    uuids.reserve(items.count());
+    QSet<QString> uuidSet;
+    uuidSet.reserve(items.count());
+    for(const QVariant& item : items)
+    {
+        const QString uuid = item.toMap().value(QStringLiteral("uuid")).toString();
+        uuids << uuid;
+        uuidSet.insert(uuid);
+    }
+
+    // current rows of the items which are kept, in the order of the dump
+    QVector<int> rows;
+    QVector<int> keptItems;
+    QVector<bool> keptRows(_metaInfo.count(), false);
+    for(int i = 0; i < uuids.count(); i++)
+    {
+        int row = _uuidIndex.indexOf(uuids.at(i));
+        if(row >= 0)
+        {
+            rows << row;
+            keptItems << i;
+            keptRows[row] = true;
+        }
+    }
+    int removed = keptRows.count(false);
+
+    // the longest run which is already in the right order stays in place, all other kept items are moved
+    QVector<bool> inPlace = longestIncreasingSubsequence(rows);
+    int moved = inPlace.count(false);
+    int inserted = items.count() - keptItems.count();
+
+    int threshold = qMax(_metaInfo.count(), items.count()) * RESYNC_RESET_PERCENT / 100;
+    bool uniqueUuids = uuidSet.count() == uuids.count() && !uuidSet.contains(QString());
+    if(!uniqueUuids || removed + moved + inserted > threshold)
+    {
+        clearAll();
+        appendMulti(items);
+        return;
+    }
+
+    for(int row = _metaInfo.count() - 1; row >= 0; row--)
+    {
+        if(!keptRows.at(row))
+            removeItem(row);
+    }
+
+    // every moved item goes right behind its predecessor in the dump
+    for(int i = 0; i < keptItems.count(); i++)
+    {
+        if(inPlace.at(i))
+            continue;
+
+        int from = _uuidIndex.indexOf(uuids.at(keptItems.at(i)));
+        int to = i == 0 ? 0 : _uuidIndex.indexOf(uuids.at(keptItems.at(i - 1))) + 1;
+        if(from < to)
+            to--;
+
+        if(from != to)
+            moveItem(from, to);
+    }
+
+    for(int i = 0; i < items.count(); i++)
+    {
+        const QVariantMap item = items.at(i).toMap();
+        if(_uuidIndex.indexOf(uuids.at(i)) != i)
+        {
+            insertItem(item, i);
+            continue;
+        }
+
+        // rows without a timestamp can not be compared and are always updated
+        qint64 lastUpdate = item.value(QStringLiteral("lastupdate")).toLongLong();
+        if(lastUpdate == 0 || lastUpdate != _metaInfo.at(i).lastUpdate)
+            updateItem(item, i);
+    }
+}
+
 void SynchronizedListLogic::updateProperty(qint64 timestamp, QString property, QVariant value, int index)
 {
     _metaInfo[index].lastUpdate = timestamp;
@@ -360,6 +1184,8 @@ void SynchronizedListLogic::updateProperty(qint64 timestamp, QString property, Q
 void SynchronizedListLogic::clearAll()
 {
     _metaInfo.clear();
+    _uuidIndex.clear();
+    clearWindow();
     Q_EMIT listCleared();
 }
 
@@ -371,13 +1197,11 @@ void SynchronizedListLogic::updateItem(QVariant item, int index)
     else
         i = _metaInfo.count() -1;
 
-    QVariantMap map = item.toMap();
-    MetaInfo info;
-    info.user = map[QStringLiteral("userid")].toString();
-    info.lastUpdate = map[QStringLiteral("userid")].toLongLong();
-    info.uuid = map[QStringLiteral("uuid")].toString();
+    const QVariantMap map = item.toMap();
+    const MetaInfo info = metaInfo(map);
     _metaInfo.replace(index, info);
-    Q_EMIT itemUpdated(i, map[QStringLiteral("data")]);
+    _uuidIndex.replace(index, uuidString(info));
+    Q_EMIT itemUpdated(i, map.value(QStringLiteral("data")));
 }
 
 bool SynchronizedListLogic::getConnected()
@@ -410,19 +1234,34 @@ void SynchronizedListLogic::disconnectList()
 
 void SynchronizedListLogic::messageReceived(QVariant message)
 {
-    QVariantMap msg = message.toMap();
-    QString cmd = msg[QStringLiteral("command")].toString();
-    bool wasSender = msg[QStringLiteral("reply")].toBool();
-    QVariantMap parameters = msg[QStringLiteral("parameters")].toMap();
-    QVariant data = parameters[QStringLiteral("data")];
+    // const access only: operator[] would detach the shared maps
+    const QVariantMap msg = message.toMap();
+    const QString cmd = msg.value(QStringLiteral("command")).toString();
+    const bool wasSender = msg.value(QStringLiteral("reply")).toBool();
+    const QVariantMap parameters = msg.value(QStringLiteral("parameters")).toMap();
+    const QVariant data = parameters.value(QStringLiteral("data"));
 
     if(cmd == "synclist:init")
     {
-        _metadata = parameters[QStringLiteral("metadata")].toMap();
+        _metadata = parameters.value(QStringLiteral("metadata")).toMap();
         Q_EMIT metadataChanged();
-        _remoteItemCount = parameters[QStringLiteral("count")].toInt();
+        _remoteItemCount = parameters.value(QStringLiteral("count")).toInt();
         Q_EMIT countChanged(_remoteItemCount);
         clearAll();
+        if(_windowSize > 0 && _preloadCount > 0 && _remoteItemCount >= 0)
+        {
+            // rows are requested page by page while the view scrolls
+            _windowed = true;
+            _pageRequests.clear();
+            Q_EMIT windowReset(_remoteItemCount);
+            if(!_initialized)
+            {
+                _initialized = true;
+                Q_EMIT initializedChanged(true);
+            }
+            return;
+        }
+
         if(_remoteItemCount < 0 || _preloadCount < 0)
             requestDump();
         else
@@ -432,12 +1271,23 @@ void SynchronizedListLogic::messageReceived(QVariant message)
 
     if(cmd == "synclist:dump")
     {
-        QVariantList list = parameters[QStringLiteral("data")].toList();
+        QVariantList list = parameters.value(QStringLiteral("data")).toList();
         _remoteItemCount = list.count();
-        _metadata = parameters[QStringLiteral("metadata")].toMap();
+        _metadata = parameters.value(QStringLiteral("metadata")).toMap();
         Q_EMIT metadataChanged();
-        clearAll();
-        appendMulti(list);
+
+        // the dump is the server state, local rows which are not in it are removed
+        clearPendingMutations();
+        if(_metaInfo.isEmpty())
+        {
+            clearAll();
+            appendMulti(list);
+        }
+        else
+        {
+            resynchronize(list);
+        }
+
         if(!_initialized)
         {
             _initialized = true;
@@ -446,9 +1296,55 @@ void SynchronizedListLogic::messageReceived(QVariant message)
         return;
     }
 
+    if(cmd == "synclist:batch")
+    {
+        // the operations are applied like single messages, the model updates once
+        const QString batchId = parameters.value(QStringLiteral("batchid")).toString();
+        _applyingBatch = true;
+        Q_EMIT batchStarted();
+        for(const QVariant& operation : parameters.value(QStringLiteral("operations")).toList())
+        {
+            QVariantMap message = operation.toMap();
+            message[QStringLiteral("reply")] = wasSender;
+            messageReceived(message);
+        }
+        _applyingBatch = false;
+        Q_EMIT batchApplied();
+
+        if(wasSender)
+        {
+            _sentBatches.remove(batchId);
+            Q_EMIT listSuccessfullModified();
+            Q_EMIT batchFinished(batchId, true, QString());
+        }
+        return;
+    }
+
+    if(cmd == "synclist:batch:failed")
+    {
+        // nothing was applied, optimistic changes are rolled back newest first
+        const QString batchId = parameters.value(QStringLiteral("batchid")).toString();
+        const QVariantList operations = _sentBatches.take(batchId);
+        for(int i = operations.count() - 1; i >= 0; i--)
+        {
+            const QVariantMap operation = operations.at(i).toMap();
+            const QVariantMap operationParameters = operation.value(QStringLiteral("parameters")).toMap();
+            PendingMutation mutation;
+            if(operationParameters.contains(QStringLiteral("opid"))
+                    && takePendingMutation(operation.value(QStringLiteral("command")).toString(), operationParameters, &mutation))
+                rollback(mutation);
+        }
+
+        Q_EMIT batchFinished(batchId, false, msg.value(QStringLiteral("errorstring")).toString());
+        return;
+    }
+
+    if(_windowed && handleWindowMessage(cmd, parameters, wasSender))
+        return;
+
     if(cmd == "synclist:get")
     {
-        QVariantList list = parameters[QStringLiteral("data")].toList();
+        QVariantList list = parameters.value(QStringLiteral("data")).toList();
         appendMulti(list);
 
         if(!_initialized)
@@ -460,9 +1356,23 @@ void SynchronizedListLogic::messageReceived(QVariant message)
         return;
     }
 
+    if(cmd.endsWith(QStringLiteral(":failed")))
+    {
+        const QString command = cmd.chopped(QStringLiteral(":failed").length());
+        PendingMutation mutation;
+        if(takePendingMutation(command, parameters, &mutation))
+            rollback(mutation);
+
+        Q_EMIT mutationFailed(command, msg.value(QStringLiteral("errorstring")).toString());
+        return;
+    }
+
+    PendingMutation mutation;
+    const bool confirmed = wasSender && takePendingMutation(cmd, parameters, &mutation) && mutation.applied;
+
     if(cmd == "synclist:metadata:set")
     {
-        _metadata = parameters["metadata"].toMap();
+        _metadata = parameters.value(QStringLiteral("metadata")).toMap();
         Q_EMIT metadataChanged();
         return;
     }
@@ -473,7 +1383,7 @@ void SynchronizedListLogic::messageReceived(QVariant message)
         Q_EMIT metadataChanged();
         clearAll();
         _remoteItemCount = 0;
-        if(wasSender)
+        if(wasSender && !_applyingBatch)
             Q_EMIT listSuccessfullModified();
 
         return;
@@ -481,11 +1391,14 @@ void SynchronizedListLogic::messageReceived(QVariant message)
 
     if(cmd == "synclist:append")
     {
-        if(_remoteItemCount == _metaInfo.count())
-            insertItem(data);
+        int local = confirmed ? _uuidIndex.indexOf(mutation.uuid) : -1;
+        if(local >= 0)
+            updateItem(data, local);
+        else if(_remoteItemCount == _metaInfo.count() - localRowDelta())
+            insertItem(data, appendPosition());
 
         _remoteItemCount++;
-        if(wasSender)
+        if(wasSender && !_applyingBatch)
             Q_EMIT listSuccessfullModified();
 
         return;
@@ -494,11 +1407,11 @@ void SynchronizedListLogic::messageReceived(QVariant message)
     if(cmd == "synclist:appendlist")
     {
         QVariantList items = data.toList();
-        if(_remoteItemCount == _metaInfo.count())
+        if(_remoteItemCount == _metaInfo.count() - localRowDelta() && appendPosition() < 0)
             appendMulti(items);
 
         _remoteItemCount += items.count();
-        if(wasSender)
+        if(wasSender && !_applyingBatch)
             Q_EMIT listSuccessfullModified();
 
         return;
@@ -507,7 +1420,7 @@ void SynchronizedListLogic::messageReceived(QVariant message)
     if(cmd == "synclist:insertat")
     {
         bool ok;
-        int index = parameters[QStringLiteral("index")].toInt(&ok);
+        int index = parameters.value(QStringLiteral("index")).toInt(&ok);
 
         if(!ok || index < 0)
         {
@@ -515,17 +1428,24 @@ void SynchronizedListLogic::messageReceived(QVariant message)
             return;
         }
 
-        if(index <= _metaInfo.count())
+        int local = confirmed ? _uuidIndex.indexOf(mutation.uuid) : -1;
+        if(local >= 0)
+        {
+            updateItem(data, local);
+            if(localRowDelta() == 0 && index < _metaInfo.count() && index != local)
+                moveItem(local, index);
+        }
+        else if(index <= _metaInfo.count())
         {
             insertItem(data, index);
         }
-        else if(_metaInfo.count() == _remoteItemCount)
+        else if(_metaInfo.count() - localRowDelta() == _remoteItemCount)
         {
             insertItem(data);
         }
         _remoteItemCount++;
 
-        if(wasSender)
+        if(wasSender && !_applyingBatch)
             Q_EMIT listSuccessfullModified();
 
         return;
@@ -534,13 +1454,21 @@ void SynchronizedListLogic::messageReceived(QVariant message)
     if(cmd == "synclist:remove")
     {
         _remoteItemCount --;
-        int index = parameters[QStringLiteral("index")].toInt();
-        QString uuid = parameters[QStringLiteral("uuid")].toString();
+        if(confirmed)
+        {
+            if(!_applyingBatch)
+                Q_EMIT listSuccessfullModified();
+
+            return;
+        }
+
+        int index = parameters.value(QStringLiteral("index")).toInt();
+        QString uuid = parameters.value(QStringLiteral("uuid")).toString();
         int correctIndex = checkAndCorrectIndex(index, uuid);
         if(correctIndex >= 0)
         {
             removeItem(correctIndex);
-            if(wasSender)
+            if(wasSender && !_applyingBatch)
                 Q_EMIT listSuccessfullModified();
 
             return;
@@ -549,16 +1477,16 @@ void SynchronizedListLogic::messageReceived(QVariant message)
 
     if(cmd == "synclist:property:set")
     {
-        int index = parameters[QStringLiteral("index")].toInt();
-        QString uuid = parameters[QStringLiteral("uuid")].toString();
-        qint64 lastUpdate = parameters[QStringLiteral("lastupdate")].toLongLong();
-        QString property = parameters[QStringLiteral("property")].toString();
-        QVariant value = parameters[QStringLiteral("data")];
+        int index = parameters.value(QStringLiteral("index")).toInt();
+        QString uuid = parameters.value(QStringLiteral("uuid")).toString();
+        qint64 lastUpdate = parameters.value(QStringLiteral("lastupdate")).toLongLong();
+        QString property = parameters.value(QStringLiteral("property")).toString();
+        QVariant value = parameters.value(QStringLiteral("data"));
         int correctIndex = checkAndCorrectIndex(index, uuid);
         if(correctIndex >= 0)
         {
             updateProperty(lastUpdate, property, value, correctIndex);
-            if(wasSender)
+            if(wasSender && !_applyingBatch)
                 Q_EMIT listSuccessfullModified();
 
             return;
@@ -567,13 +1495,13 @@ void SynchronizedListLogic::messageReceived(QVariant message)
 
     if(cmd == "synclist:set")
     {
-        int index = parameters[QStringLiteral("index")].toInt();
-        QString uuid = parameters[QStringLiteral("uuid")].toString();
+        int index = parameters.value(QStringLiteral("index")).toInt();
+        QString uuid = parameters.value(QStringLiteral("uuid")).toString();
         int correctIndex = checkAndCorrectIndex(index, uuid);
         if(correctIndex >= 0)
         {
             updateItem(data, correctIndex);
-            if(wasSender)
+            if(wasSender && !_applyingBatch)
                 Q_EMIT listSuccessfullModified();
 
             return;
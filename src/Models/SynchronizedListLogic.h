@@ -24,8 +24,12 @@
 #include "../Core/ListModelBase.h"
 #include "../Core/ResourceCommunicationHandler.h"
 #include "../Shared/VirtualConnection.h"
+#include "UuidIndex.h"
 #include <QObject>
 #include <QTimer>
+#include <QSet>
+#include <QElapsedTimer>
+#include <functional>
 
 class SynchronizedListLogic : public QObject
 {
@@ -33,7 +37,8 @@ class SynchronizedListLogic : public QObject
 
     struct MetaInfo
     {
-        QString uuid;
+        QUuid uuid;
+        QString id;     // only set if the uuid string does not match QUuid::toString()
         qint64 lastUpdate;
         QString user;
     };
@@ -155,12 +160,78 @@ public:
     QString getResource() const;
     void setResource(const QString &resourceName);
 
+    /*!
+        \fn void SynchronizedListLogic::restore(const QVariantList& items, const QVariantMap& metadata)
+        Shows previously cached items ({uuid, userid, lastupdate, data}) until the resource is dumped.
+        The dump is then diffed against them, see ResourceCache.
+    */
+    void restore(const QVariantList& items, const QVariantMap& metadata);
+
     // API for lazy loading while scrolling
     void loadItems(int from, int count);
     int getRemoteItemCount() const;
     void setPreloadCount(int preloadCount);
+    int preloadCount() const;
     void fetchMore();
 
+    /*!
+        \fn void SynchronizedListLogic::setWindowSize(int windowSize)
+        Enables the windowed mode if windowSize is greater than 0. It is used for lazily loaded lists
+        (preload count > 0 and the resource sends synclist:init). Rows are then loaded in pages of
+        preload count rows when requestPage() is called. At most windowSize rows stay loaded, the least
+        recently used pages are evicted. Instead of the item signals the list reports windowReset(),
+        pageLoaded(), pageEvicted(), windowRowsInserted() and windowRowsRemoved().
+    */
+    void setWindowSize(int windowSize);
+    int windowSize() const;
+    bool isWindowed() const;
+    int pageSize() const;
+    bool isPageLoaded(int page) const;
+
+    /*!
+        \fn void SynchronizedListLogic::touchPage(int page)
+        Marks the page as recently used, so it is evicted last.
+    */
+    void touchPage(int page);
+
+    /*!
+        \fn void SynchronizedListLogic::setOptimistic(bool optimistic)
+        If enabled, append(), insertAt(), set(), setProperty() and remove() change the local list
+        right away instead of waiting for the server. Every change is sent with an operation id
+        ("opid") and reconciled with the server's reply. It is rolled back if the server answers with
+        <command>:failed or does not reply within mutationTimeout() ms; after a timeout the list is
+        dumped again. Rows are only appended or inserted locally if the list is completely loaded,
+        and changes of existing rows need a row source, see setRowSource(). Windowed lists are never
+        changed optimistically.
+    */
+    void setOptimistic(bool optimistic);
+    bool optimistic() const;
+    void setMutationTimeout(int timeout);
+    int mutationTimeout() const;
+
+    /*!
+        \fn void SynchronizedListLogic::beginBatch()
+        Queues insertAt(), append(), appendList(), set(), setProperty(), remove(), clear() and
+        setMetadata() until commit() is called. Batches can be nested, the outermost commit() sends them.
+    */
+    void beginBatch();
+
+    /*!
+        \fn QString SynchronizedListLogic::commit()
+        Sends the queued changes in one synclist:batch message. The server applies all of them or none.
+        Returns the id of the batch, batchFinished() is emitted with it when the server answered.
+        Returns an empty string if nothing was sent because the batch is nested or empty.
+    */
+    QString commit();
+    bool isBatching() const;
+
+    /*!
+        \fn void SynchronizedListLogic::setRowSource(std::function<QVariantMap(int)> source)
+        Gives the logic read access to the rows of the UI model. It is needed to roll back optimistic
+        changes of existing rows.
+    */
+    void setRowSource(std::function<QVariantMap(int)> source);
+
 signals:
     void resourceChanged();
     void connectedChanged();
@@ -173,39 +244,147 @@ signals:
     void itemUpdated(int index, QVariant data);
     void itemAdded(int index, QVariant data);
     void itemRemoved(int index);
+    void itemMoved(int from, int to);
     void itemsAppended(QVariantList data);
     void listCleared();
     void countChanged(int count);
     void initializedChanged(bool initialized);
 
+    void windowReset(int count);
+    void pageLoaded(int page, QVariantList data);
+    void pageEvicted(int page);
+    void windowRowsInserted(int index, int count);
+    void windowRowsRemoved(int index, int count);
+
+    void mutationFailed(QString command, QString errorString);
+
+    // the operations of a batch are reported between batchStarted() and batchApplied()
+    void batchStarted();
+    void batchApplied();
+    void batchFinished(QString batchId, bool success, QString errorString);
+
 
 private:
     void    insertMulti(QVariantList items, int index = -1);
     void    appendMulti(QVariantList items);
     void    insertItem(QVariant item, int index = -1);
     void    removeItem(int index);
+    void    moveItem(int from, int to);
+    void    resynchronize(QVariantList items);
     void    updateProperty(qint64 timestamp, QString property, QVariant value, int index = -1);
     void    clearAll();
     void    updateItem(QVariant item, int index = -1);
 
 
+    // a re-dump which changes more rows than this resets the list instead of diffing it
+    static const int RESYNC_RESET_PERCENT = 30;
+
+    // a page request fetches one more page per PAGE_RTT_STEP ms of round trip time
+    static const int PAGE_RTT_STEP = 50;
+
+    struct WindowPage
+    {
+        QVector<MetaInfo> rows;
+        quint64 lastUsed = 0;
+    };
+
+    struct PageRequest
+    {
+        int firstPage;
+        int pageCount;
+        qint64 sent;
+        int generation;
+    };
+
+    // a change which was sent while optimistic() is enabled
+    struct PendingMutation
+    {
+        QString opId;
+        QString command;
+        bool applied = false;   // the change is shown locally
+        QString uuid;           // changed row, a local uuid for inserted rows
+        int index = -1;
+        QVariantMap previous;   // the row before the change
+        QString property;
+        qint64 sent = 0;
+    };
+
+    void    sendMutation(const QVariantMap& msg);
+    bool    mutatesLocally(bool needsRow) const;
+    void    addPendingMutation(PendingMutation mutation, QVariantMap& parameters);
+    bool    takePendingMutation(const QString& command, const QVariantMap& parameters, PendingMutation* mutation);
+    void    rollback(const PendingMutation& mutation);
+    void    rollbackAll(const QString& errorString);
+    void    clearPendingMutations();
+    int     localRowDelta() const;
+    int     appendPosition() const;
+    QVariantMap localItem(const QString& uuid, const QVariant& data) const;
+    QVariantMap currentItem(int index) const;
+
+    bool    handleWindowMessage(const QString& cmd, const QVariantMap& parameters, bool wasSender);
+    void    pageReceived(const QVariantMap& parameters);
+    void    insertWindowRows(int index, int count);
+    void    removeWindowRows(int index, int count);
+    void    dropPagesFrom(int page);
+    void    evictPages();
+    void    clearWindow();
+    int     maxWindowPages() const;
+    int     windowIndexOf(const QString& uuid) const;
+    int     windowIndex(const QVariantMap& parameters) const;
+    const MetaInfo* metaInfoAt(int index) const;
+
+    static MetaInfo metaInfo(const QVariantMap& item);
+    static QString  uuidString(const MetaInfo& info);
+
     ResourceCommunicationHandler* _communicationHandler;
     int checkAndCorrectIndex(int index, QString uuid);
     QList<QVariant>     _pendingMessages;
     QVariantMap         _metadata;
     QString             _resource;
     QList<MetaInfo>     _metaInfo;
+    UuidIndex           _uuidIndex;
     int                 _preloadCount = -1;
     int                 _remoteItemCount = -1 ;
     bool                _initialized = false;
 
+    int                     _windowSize = 0;
+    bool                    _windowed = false;
+    QHash<int, WindowPage>  _pages;
+    QSet<int>               _pendingPages;
+    QList<PageRequest>      _pageRequests;
+    int                     _windowGeneration = 0;
+    quint64                 _pageUseCounter = 0;
+    QElapsedTimer           _clock;
+    qint64                  _pageRtt = -1;
+
+    bool                            _optimistic = false;
+    int                             _mutationTimeout = 5000;
+    quint64                         _mutationCounter = 0;
+    QList<PendingMutation>          _pendingMutations;
+    QTimer                          _mutationTimer;
+    std::function<QVariantMap(int)> _rowSource;
+
+    int                             _batchDepth = 0;
+    quint64                         _batchCounter = 0;
+    QVariantList                    _batch;
+    QHash<QString, QVariantList>    _sentBatches;
+    bool                            _applyingBatch = false;
+
 public slots:
     void disconnectList();
     void connectList();
     void stateChanged();
 
+    /*!
+        \fn void SynchronizedListLogic::requestPage(int page)
+        Loads the given page in windowed mode, together with the following pages if the round trip
+        time is high. Pages which are loaded or already requested are not requested again.
+    */
+    void requestPage(int page);
+
 private slots:
     void messageReceived(QVariant message);
+    void mutationTimedOut();
 
 
 public slots:
@@ -11,64 +11,85 @@
 
 #include "SynchronizedListModel2.h"
 #include "../Core/CloudModel.h"
+#include "../Core/SubscriptionRegistry.h"
+#include "../Helpers/ResourceCache.h"
+#include "../Helpers/ChangeCoalescer.h"
 
 
-SynchronizedListModel2::SynchronizedListModel2(QObject *parent) : ListModelBase<QVariant>(parent),
-    _logic(new SynchronizedListLogic(this))
+SynchronizedListModel2::SynchronizedListModel2(QObject *parent) : QAbstractListModel(parent),
+    _list(nullptr),
+    _logic(nullptr),
+    _coalescer(new ChangeCoalescer(this))
 {
-    connect(_logic, &SynchronizedListLogic::resourceChanged, this, &SynchronizedListModel2::resourceChanged);
-    connect(_logic, &SynchronizedListLogic::connectedChanged, this, &SynchronizedListModel2::connectedChanged);
-    connect(_logic, &SynchronizedListLogic::modelStateChanged, this, &SynchronizedListModel2::modelStateChanged);
-    connect(_logic, &SynchronizedListLogic::metadataChanged, this, &SynchronizedListModel2::metadataChanged);
-    connect(_logic, &SynchronizedListLogic::listSuccessfullModified, this, &SynchronizedListModel2::listSuccessfullModified);
-    connect(_logic, &SynchronizedListLogic::itemPropertyChanged, this, &SynchronizedListModel2::itemPropertyChanged);
-    connect(_logic, &SynchronizedListLogic::itemUpdated, this, &SynchronizedListModel2::itemUpdated);
-    connect(_logic, &SynchronizedListLogic::itemAdded, this, &SynchronizedListModel2::itemAdded);
-    connect(_logic, &SynchronizedListLogic::itemRemoved, this, &SynchronizedListModel2::itemRemoved);
-    connect(_logic, &SynchronizedListLogic::itemsAppended, this, &SynchronizedListModel2::itemsAppended);
-    connect(_logic, &SynchronizedListLogic::listCleared, this, &SynchronizedListModel2::listCleared);
-    connect(_logic, &SynchronizedListLogic::initializedChanged, this, &SynchronizedListModel2::initializedChanged);
+    // the list is replaced by the shared one as soon as the resource is known
+    setList(new SynchronizedListStore(this), false);
+    connect(this, &SynchronizedListModel2::listModified, this, &SynchronizedListModel2::storeInCache);
+    connect(this, &SynchronizedListModel2::initializedChanged, this, &SynchronizedListModel2::storeInCache);
 }
 
+SynchronizedListModel2::~SynchronizedListModel2()
+{
+    releaseList(_list, _shared);
+}
+
+
+int SynchronizedListModel2::count() const
+{
+    if(_windowed)
+        return _windowVisible ? _windowCount : 0;
+
+    return _list->rows().count();
+}
+
+int SynchronizedListModel2::rowCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent)
+    return count();
+}
 
 QVariant SynchronizedListModel2::data(const QModelIndex &index, int role) const
 {
-    if(index.row() < m_dataList.size())
+    if(_windowed)
     {
-        QVariantMap map = m_dataList.at(index.row()).toMap();
+        if(!index.isValid() || index.row() >= count())
+            return QVariant();
 
-        if(role == Qt::DisplayRole)
+        int page = index.row() / _logic->pageSize();
+        auto it = _pages.constFind(page);
+        if(it == _pages.constEnd())
         {
-            QVariant val = map[roleNames().value(index.column()+1)];
-
-            return val.toString();
+            // placeholder
+            requestPage(page);
+            return QVariant();
         }
 
-        return map[roleNames().value(role)];
+        _logic->touchPage(page);
+        int column = it->columnIndex(_roles.value(role == Qt::DisplayRole ? index.column() + 1 : role));
+        QVariant value = it->value(index.row() % _logic->pageSize(), column);
+        return role == Qt::DisplayRole ? QVariant(value.toString()) : value;
     }
 
-    return QVariant();
+    if(!index.isValid() || index.row() >= _list->rows().count())
+        return QVariant();
+
+    // columns are looked up by name, their order changes when the list is dumped again.
+    // Roles keep their ids across dumps because views cache them.
+    const ColumnStore& rows = _list->rows();
+    const int columnRole = role == Qt::DisplayRole ? index.column() + 1 : role;
+    if(!_roles.contains(columnRole))
+        registerRoles(rows);
+
+    int column = rows.columnIndex(_roles.value(columnRole));
+    QVariant value = rows.value(index.row(), column);
+    return role == Qt::DisplayRole ? QVariant(value.toString()) : value;
 }
 
 QHash<int, QByteArray> SynchronizedListModel2::roleNames() const
 {
-    if(m_dataList.count() > 0)
-    {
-        QVariantMap map = m_dataList.at(0).toMap();
-        if(_roles.count() == map.count() + 1)
-        {
-            return _roles;
-        }
-
-        _roles.insert(Qt::DisplayRole, "display");
-        for(int i = 0; i < map.keys().size(); i++)
-        {
-            QByteArray key =  map.keys().at(i).toLatin1();
-            if(!_roles.values().contains(key))
-                _roles.insert(_roles.count(), key);
-        }
-    }
+    if(_windowed)
+        return _roles;
 
+    registerRoles(_list->rows());
     return _roles;
 }
 
@@ -119,14 +140,34 @@ void SynchronizedListModel2::clear()
 
 QVariant SynchronizedListModel2::get(int index)
 {
-    if(index < m_dataList.size() && index >= 0)
+    if(_windowed)
     {
-        return  m_dataList.at(index);
+        if(index < 0)
+            return QVariant();
+
+        auto it = _pages.constFind(index / _logic->pageSize());
+        if(it == _pages.constEnd())
+            return QVariant();
+
+        return it->row(index % _logic->pageSize());
+    }
+
+    if(index < _list->rows().count() && index >= 0)
+    {
+        return _list->rows().row(index);
     }
 
     return QVariant();
 }
 
+bool SynchronizedListModel2::isLoaded(int index) const
+{
+    if(!_windowed)
+        return index >= 0 && index < _list->rows().count();
+
+    return index >= 0 && index < count() && _pages.contains(index / _logic->pageSize());
+}
+
 int SynchronizedListModel2::getIndexForUUID(QString uuid)
 {
     return _logic->getIndexForUUID(uuid);
@@ -135,13 +176,32 @@ int SynchronizedListModel2::getIndexForUUID(QString uuid)
 
 void SynchronizedListModel2::componentComplete()
 {
-    if(!_filter.isEmpty())
-        _logic->setResource(_resourceName + ":" + QJsonDocument::fromVariant(_filter).toJson(QJsonDocument::Compact));
-    else
-        _logic->setResource(_resourceName);
     _complete = true;
+    subscribe();
+}
+
+
+void SynchronizedListModel2::beginBatch()
+{
+    _logic->beginBatch();
 }
 
+void SynchronizedListModel2::commit(QJSValue callback)
+{
+    bool nested = _logic->isBatching();
+    QString batchId = _logic->commit();
+    if(!batchId.isEmpty())
+    {
+        if(callback.isCallable())
+            _batchCallbacks.insert(batchId, callback);
+
+        return;
+    }
+
+    // an empty batch is done right away
+    if(nested && !_logic->isBatching() && callback.isCallable())
+        callback.call(QJSValueList { true, QString() });
+}
 
 void SynchronizedListModel2::remove(int index)
 {
@@ -176,6 +236,9 @@ void SynchronizedListModel2::setMetadata(const QVariantMap &metadata)
 bool SynchronizedListModel2::canFetchMore(const QModelIndex &parent) const
 {
     Q_UNUSED(parent)
+    if(_windowed)
+        return false;
+
     int remoteCount = _logic->getRemoteItemCount();
     if(remoteCount < 0)
       return false;
@@ -200,7 +263,7 @@ void SynchronizedListModel2::setResource(const QString &resourceName)
     if(!_complete)
         return;
 
-    _logic->setResource(resourceName);
+    subscribe();
 }
 
 QVariantMap SynchronizedListModel2::getFilter() const
@@ -214,25 +277,104 @@ void SynchronizedListModel2::setFilter(const QVariantMap &filter)
     if(!_complete)
         return;
 
-    _logic->setFilter(filter);
+    // a filtered list is another subscription
+    if(_shared)
+        subscribe();
+    else
+        _logic->setFilter(filter);
     Q_EMIT filterChanged();
 }
 
 int SynchronizedListModel2::preloadCount() const
 {
-    return _preloadCount;
+    return _logic->preloadCount();
 }
 
 void SynchronizedListModel2::setPreloadCount(int preloadCount)
 {
-    if(_preloadCount == preloadCount)
+    if(_logic->preloadCount() == preloadCount)
         return;
 
     _logic->setPreloadCount(preloadCount);
-    _preloadCount = preloadCount;
     Q_EMIT preloadCountChanged();
 }
 
+int SynchronizedListModel2::windowSize() const
+{
+    return _windowSize;
+}
+
+void SynchronizedListModel2::setWindowSize(int windowSize)
+{
+    if(_windowSize == windowSize)
+        return;
+
+    _windowSize = windowSize;
+    if(!_shared)
+        _logic->setWindowSize(windowSize);
+
+    // windowed lists are not shared
+    if(_complete && _shared != (windowSize <= 0))
+        subscribe();
+    Q_EMIT windowSizeChanged();
+}
+
+bool SynchronizedListModel2::optimistic() const
+{
+    return _logic->optimistic();
+}
+
+void SynchronizedListModel2::setOptimistic(bool optimistic)
+{
+    if(_logic->optimistic() == optimistic)
+        return;
+
+    _logic->setOptimistic(optimistic);
+    Q_EMIT optimisticChanged();
+}
+
+int SynchronizedListModel2::mutationTimeout() const
+{
+    return _logic->mutationTimeout();
+}
+
+void SynchronizedListModel2::setMutationTimeout(int mutationTimeout)
+{
+    if(_logic->mutationTimeout() == mutationTimeout)
+        return;
+
+    _logic->setMutationTimeout(mutationTimeout);
+    Q_EMIT mutationTimeoutChanged();
+}
+
+bool SynchronizedListModel2::coalesceChanges() const
+{
+    return _coalescer->isEnabled();
+}
+
+void SynchronizedListModel2::setCoalesceChanges(bool coalesceChanges)
+{
+    if(_coalescer->isEnabled() == coalesceChanges)
+        return;
+
+    _coalescer->setEnabled(coalesceChanges);
+    Q_EMIT coalesceChangesChanged();
+}
+
+int SynchronizedListModel2::coalesceInterval() const
+{
+    return _coalescer->interval();
+}
+
+void SynchronizedListModel2::setCoalesceInterval(int coalesceInterval)
+{
+    if(_coalescer->interval() == coalesceInterval)
+        return;
+
+    _coalescer->setInterval(coalesceInterval);
+    Q_EMIT coalesceIntervalChanged();
+}
+
 bool SynchronizedListModel2::getInitialized()
 {
     return _logic->getInitialized();
@@ -245,82 +387,532 @@ bool SynchronizedListModel2::getConnected()
 
 void SynchronizedListModel2::connectList()
 {
+    // the model has let go of its shared list, see disconnectList()
+    if(_complete && !_shared && _windowSize <= 0 && !descriptor().isEmpty())
+    {
+        subscribe();
+        return;
+    }
+
     _logic->connectList();
 }
 
 void SynchronizedListModel2::itemPropertyChanged(int index, QString property, QVariant data)
 {
-    if(index >= 0 && index < m_dataList.count())
+    // the rows of lists which are not windowed are changed by the SynchronizedListStore
+    if(!_windowed)
+        return;
+
+    auto it = _pages.find(index / _logic->pageSize());
+    if(it == _pages.end())
+        return;
+
+    it->setValue(index % _logic->pageSize(), property.toLatin1(), data);
+    registerRoles(*it);
+    QVector<int> roles;
+    roles << Qt::DisplayRole;
+    roles << _roles.key(property.toLatin1(), -1);
+    rowsChanged(index, index, roles);
+    modified(false);
+}
+
+void SynchronizedListModel2::itemUpdated(int index, QVariant data)
+{
+    if(!_windowed)
+        return;
+
+    auto it = _pages.find(index / _logic->pageSize());
+    if(it != _pages.end())
+    {
+        it->replace(index % _logic->pageSize(), data);
+        registerRoles(*it);
+        rowsChanged(index, index);
+    }
+    modified(false);
+}
+
+void SynchronizedListModel2::listRowsAboutToBeInserted(int first, int last)
+{
+    flushChangedRows();
+    beginInsertRows(QModelIndex(), first, last);
+}
+
+void SynchronizedListModel2::listRowsInserted(int first, int last)
+{
+    Q_UNUSED(first)
+    Q_UNUSED(last)
+    endInsertRows();
+}
+
+void SynchronizedListModel2::listRowsAboutToBeRemoved(int first, int last)
+{
+    flushChangedRows();
+    beginRemoveRows(QModelIndex(), first, last);
+}
+
+void SynchronizedListModel2::listRowsRemoved(int first, int last)
+{
+    Q_UNUSED(first)
+    Q_UNUSED(last)
+    endRemoveRows();
+}
+
+void SynchronizedListModel2::listRowAboutToBeMoved(int from, int to)
+{
+    flushChangedRows();
+    // beginMoveRows() expects the row in front of which the item ends up
+    beginMoveRows(QModelIndex(), from, from, QModelIndex(), to > from ? to + 1 : to);
+}
+
+void SynchronizedListModel2::listRowMoved(int from, int to)
+{
+    Q_UNUSED(from)
+    Q_UNUSED(to)
+    endMoveRows();
+}
+
+void SynchronizedListModel2::listRowChanged(int row, int column)
+{
+    QVector<int> roles;
+    if(column >= 0)
     {
-        QVariantMap item = m_dataList.at(index).toMap();
-        item[property] = data;
-        m_dataList.replace(index, item);
-        int role = roleNames().key(property.toLatin1(), -1);
-        QVector<int> roles;
+        registerRoles(_list->rows());
         roles << Qt::DisplayRole;
-        roles << role;
-        Q_EMIT dataChanged(this->index(index), this->index(index), roles);
-        Q_EMIT listModified();
+        roles << _roles.key(_list->rows().columnName(column), -1);
     }
+    rowsChanged(row, row, roles);
 }
 
-void SynchronizedListModel2::itemUpdated(int index, QVariant data)
+void SynchronizedListModel2::listAboutToBeCleared()
 {
-    ListModelBase::replaceItem(index, data);
+    flushChangedRows();
+    if(!_windowed)
+        return;
+
+    beginResetModel();
+    _pages.clear();
+    _requestedPages.clear();
+    _roles.clear();
+    _windowed = false;
+    _windowVisible = false;
+    _windowCount = 0;
+    endResetModel();
+}
+
+void SynchronizedListModel2::disconnectList()
+{
+    // a shared list stays attached for its other models
+    if(_shared)
+    {
+        SynchronizedListStore* list = createList();
+        list->setParent(this);
+        setList(list, false);
+        return;
+    }
+
+    _logic->disconnectList();
+}
+
+
+int SynchronizedListModel2::columnCount(const QModelIndex &parent) const
+{
+    Q_UNUSED( parent );
+    int roleCount = roleNames().count();
+    if(roleCount <= 0)
+        return 0;
+
+    return roleCount-1;
+}
+
+void SynchronizedListModel2::listAboutToBeReset()
+{
+    flushChangedRows();
+    beginResetModel();
+}
+
+void SynchronizedListModel2::windowReset(int count)
+{
+    // the model reset was begun by aboutToBeReset()
+    _pages.clear();
+    _requestedPages.clear();
+    _roles.clear();
+    _windowed = true;
+    _windowCount = count;
+
+    // rows are shown once the first page brings the roles
+    _windowVisible = false;
+    endResetModel();
+
+    if(count > 0)
+        _logic->requestPage(0);
+
+    Q_EMIT countChanged();
     Q_EMIT listModified();
 }
 
-void SynchronizedListModel2::itemAdded(int index, QVariant data)
+void SynchronizedListModel2::pageLoaded(int page, QVariantList data)
 {
-    if(index < 0)
+    ColumnStore store;
+    store.append(data);
+    registerRoles(store);
+    _pages.insert(page, store);
+    _requestedPages.remove(page);
+
+    if(!_windowVisible)
     {
-        ListModelBase::appendRow(data);
-        Q_EMIT sigItemAdded(this->count()-1, data);
+        if(_windowCount > 0)
+        {
+            beginInsertRows(QModelIndex(), 0, _windowCount - 1);
+            _windowVisible = true;
+            endInsertRows();
+        }
+        else
+        {
+            _windowVisible = true;
+        }
+        Q_EMIT countChanged();
     }
     else
     {
-        ListModelBase::insertRow(index, data);
-        Q_EMIT sigItemAdded(index, data);
+        int first = page * _logic->pageSize();
+        int last = qMin(first + data.count(), _windowCount) - 1;
+        if(first <= last)
+            Q_EMIT dataChanged(this->index(first), this->index(last));
     }
-    Q_EMIT countChanged();
     Q_EMIT listModified();
 }
 
-void SynchronizedListModel2::itemRemoved(int index)
+void SynchronizedListModel2::pageEvicted(int page)
 {
-    ListModelBase::takeRow(index);
-    Q_EMIT sigItemRemoved(index);
-    Q_EMIT countChanged();
-    Q_EMIT listModified();
+    _pages.remove(page);
+    _requestedPages.remove(page);
+    if(!_windowVisible)
+        return;
+
+    // visible rows of the page become placeholders and are requested again
+    int first = page * _logic->pageSize();
+    int last = qMin(first + _logic->pageSize(), _windowCount) - 1;
+    if(first <= last)
+        Q_EMIT dataChanged(this->index(first), this->index(last));
+}
+
+void SynchronizedListModel2::windowRowsInserted(int index, int count)
+{
+    if(!_windowVisible)
+    {
+        _windowCount += count;
+        _logic->requestPage(0);
+        return;
+    }
+
+    flushChangedRows();
+    beginInsertRows(QModelIndex(), index, index + count - 1);
+    _windowCount += count;
+    endInsertRows();
+    modified(true);
+}
+
+void SynchronizedListModel2::windowRowsRemoved(int index, int count)
+{
+    if(!_windowVisible)
+    {
+        _windowCount -= count;
+        return;
+    }
+
+    flushChangedRows();
+    beginRemoveRows(QModelIndex(), index, index + count - 1);
+    _windowCount -= count;
+    endRemoveRows();
+    modified(true);
+}
+
+void SynchronizedListModel2::registerRoles(const ColumnStore &store) const
+{
+    if(_roles.isEmpty())
+        _roles.insert(Qt::DisplayRole, "display");
+
+    for(int i = 0; i < store.columnCount(); i++)
+    {
+        QByteArray name = store.columnName(i);
+        if(_roles.key(name, -1) < 0)
+            _roles.insert(_roles.count(), name);
+    }
+}
+
+void SynchronizedListModel2::requestPage(int page) const
+{
+    if(_requestedPages.contains(page))
+        return;
+
+    // data() must not send messages, the request is queued
+    _requestedPages.insert(page);
+    QMetaObject::invokeMethod(_logic, "requestPage", Qt::QueuedConnection, Q_ARG(int, page));
+}
+
+void SynchronizedListModel2::subscribe()
+{
+    const QString descriptor = this->descriptor();
+    bool shared = !descriptor.isEmpty() && _windowSize <= 0;
+    bool created = false;
+
+    // a list which is not shared is reused for the next resource
+    auto create = [this, &created]() {
+        created = true;
+        if(!_shared)
+            return _list;
+
+        return createList();
+    };
+
+    SynchronizedListStore* list;
+    if(shared)
+        list = static_cast<SynchronizedListStore*>(SubscriptionRegistry::instance()->acquire(QStringLiteral("synclist"), descriptor, this, create));
+    else
+        list = create();
+
+    if(created)
+    {
+        // shared lists belong to the registry
+        list->setParent(shared ? nullptr : this);
+        list->logic()->setResource(descriptor);
+    }
+
+    setList(list, shared);
+
+    // a list which was joined is loaded already
+    if(created)
+        loadFromCache();
 }
 
-void SynchronizedListModel2::listCleared()
+SynchronizedListStore *SynchronizedListModel2::createList() const
 {
+    SynchronizedListStore* list = new SynchronizedListStore();
+    list->logic()->setPreloadCount(_logic->preloadCount());
+    list->logic()->setWindowSize(_windowSize);
+    list->logic()->setOptimistic(_logic->optimistic());
+    list->logic()->setMutationTimeout(_logic->mutationTimeout());
+    return list;
+}
+
+void SynchronizedListModel2::setList(SynchronizedListStore *list, bool shared)
+{
+    if(list == _list)
+    {
+        _shared = shared;
+        return;
+    }
+
+    SynchronizedListStore* previous = _list;
+    bool previousShared = _shared;
+
+    flushChangedRows();
+    beginResetModel();
+    if(previous)
+    {
+        disconnect(previous, nullptr, this, nullptr);
+        disconnect(previous->logic(), nullptr, this, nullptr);
+    }
+
+    _list = list;
+    _logic = list->logic();
+    _shared = shared;
+    _pages.clear();
+    _requestedPages.clear();
     _roles.clear();
-    ListModelBase::clear();
+    _windowed = false;
+    _windowVisible = false;
+    _windowCount = 0;
+    _batchUpdate = false;
+
+    connect(_logic, &SynchronizedListLogic::resourceChanged, this, &SynchronizedListModel2::resourceChanged);
+    connect(_logic, &SynchronizedListLogic::connectedChanged, this, &SynchronizedListModel2::connectedChanged);
+    connect(_logic, &SynchronizedListLogic::modelStateChanged, this, &SynchronizedListModel2::modelStateChanged);
+    connect(_logic, &SynchronizedListLogic::metadataChanged, this, &SynchronizedListModel2::metadataChanged);
+    connect(_logic, &SynchronizedListLogic::listSuccessfullModified, this, &SynchronizedListModel2::listSuccessfullModified);
+    connect(_logic, &SynchronizedListLogic::itemPropertyChanged, this, &SynchronizedListModel2::itemPropertyChanged);
+    connect(_logic, &SynchronizedListLogic::itemUpdated, this, &SynchronizedListModel2::itemUpdated);
+    connect(_logic, &SynchronizedListLogic::initializedChanged, this, &SynchronizedListModel2::initializedChanged);
+    connect(_logic, &SynchronizedListLogic::pageLoaded, this, &SynchronizedListModel2::pageLoaded);
+    connect(_logic, &SynchronizedListLogic::pageEvicted, this, &SynchronizedListModel2::pageEvicted);
+    connect(_logic, &SynchronizedListLogic::windowRowsInserted, this, &SynchronizedListModel2::windowRowsInserted);
+    connect(_logic, &SynchronizedListLogic::windowRowsRemoved, this, &SynchronizedListModel2::windowRowsRemoved);
+    connect(_logic, &SynchronizedListLogic::mutationFailed, this, &SynchronizedListModel2::mutationFailed);
+    connect(_logic, &SynchronizedListLogic::batchStarted, this, &SynchronizedListModel2::batchStarted);
+    connect(_logic, &SynchronizedListLogic::batchApplied, this, &SynchronizedListModel2::batchApplied);
+    connect(_logic, &SynchronizedListLogic::batchFinished, this, &SynchronizedListModel2::batchFinished);
+
+    connect(_list, &SynchronizedListStore::rowsAboutToBeInserted, this, &SynchronizedListModel2::listRowsAboutToBeInserted);
+    connect(_list, &SynchronizedListStore::rowsInserted, this, &SynchronizedListModel2::listRowsInserted);
+    connect(_list, &SynchronizedListStore::rowsAboutToBeRemoved, this, &SynchronizedListModel2::listRowsAboutToBeRemoved);
+    connect(_list, &SynchronizedListStore::rowsRemoved, this, &SynchronizedListModel2::listRowsRemoved);
+    connect(_list, &SynchronizedListStore::rowAboutToBeMoved, this, &SynchronizedListModel2::listRowAboutToBeMoved);
+    connect(_list, &SynchronizedListStore::rowMoved, this, &SynchronizedListModel2::listRowMoved);
+    connect(_list, &SynchronizedListStore::rowChanged, this, &SynchronizedListModel2::listRowChanged);
+    connect(_list, &SynchronizedListStore::itemAdded, this, &SynchronizedListModel2::sigItemAdded);
+    connect(_list, &SynchronizedListStore::itemRemoved, this, &SynchronizedListModel2::sigItemRemoved);
+    connect(_list, &SynchronizedListStore::aboutToBeCleared, this, &SynchronizedListModel2::listAboutToBeCleared);
+    connect(_list, &SynchronizedListStore::aboutToBeReset, this, &SynchronizedListModel2::listAboutToBeReset);
+    connect(_list, &SynchronizedListStore::reset, this, &SynchronizedListModel2::windowReset);
+    connect(_list, &SynchronizedListStore::modified, this, &SynchronizedListModel2::modified);
+    endResetModel();
+
+    if(!previous)
+        return;
+
+    releaseList(previous, previousShared);
     Q_EMIT countChanged();
-    Q_EMIT listModified();
+    Q_EMIT resourceChanged();
+    Q_EMIT connectedChanged();
+    Q_EMIT modelStateChanged();
+    Q_EMIT metadataChanged();
+    Q_EMIT initializedChanged();
+    Q_EMIT preloadCountChanged();
+    Q_EMIT optimisticChanged();
+    Q_EMIT mutationTimeoutChanged();
 }
 
-void SynchronizedListModel2::itemsAppended(QVariantList items)
+void SynchronizedListModel2::releaseList(SynchronizedListStore *list, bool shared)
 {
-    ListModelBase::appendRows(items);
-    Q_EMIT countChanged();
-    Q_EMIT listModified();
+    if(!list)
+        return;
+
+    disconnect(list, nullptr, this, nullptr);
+    disconnect(list->logic(), nullptr, this, nullptr);
+    if(shared)
+        SubscriptionRegistry::instance()->release(list, this);
+    else
+        list->deleteLater();
 }
 
-void SynchronizedListModel2::disconnectList()
+QString SynchronizedListModel2::descriptor() const
 {
-    _logic->disconnectList();
+    if(_filter.isEmpty())
+        return _resourceName;
+
+    return _resourceName + ":" + QJsonDocument::fromVariant(_filter).toJson(QJsonDocument::Compact);
 }
 
+void SynchronizedListModel2::loadFromCache()
+{
+    QVariantMap cached = ResourceCache::instance()->load(QStringLiteral("synclist"), _logic->getResource()).toMap();
+    if(cached.isEmpty())
+        return;
 
-int SynchronizedListModel2::columnCount(const QModelIndex &parent) const
+    _logic->restore(cached.value(QStringLiteral("items")).toList(), cached.value(QStringLiteral("metadata")).toMap());
+}
+
+void SynchronizedListModel2::storeInCache()
 {
-    Q_UNUSED( parent );
-    int roleCount = roleNames().count();
-    if(roleCount <= 0)
-        return 0;
+    // windowed lists never hold all rows, cached rows are only replaced by the server's
+    if(_windowed || !_logic->getInitialized())
+        return;
 
-    return roleCount-1;
+    // the snapshot is only taken while the list exists, no matter which of its models scheduled it
+    SynchronizedListStore* list = _list;
+    ResourceCache::instance()->scheduleStore(QStringLiteral("synclist"), _logic->getResource(), list, [list]() {
+        const ColumnStore& rows = list->rows();
+        SynchronizedListLogic* logic = list->logic();
+        QVariantList items;
+        items.reserve(rows.count());
+        for(int i = 0; i < rows.count(); i++)
+        {
+            QVariantMap item;
+            item[QStringLiteral("uuid")] = logic->getUUIDForIndex(i);
+            item[QStringLiteral("userid")] = logic->getUserIDForIndex(i);
+            item[QStringLiteral("lastupdate")] = logic->getTimestampForIndex(i);
+            item[QStringLiteral("data")] = rows.row(i);
+            items << item;
+        }
+
+        QVariantMap snapshot;
+        snapshot[QStringLiteral("items")] = items;
+        snapshot[QStringLiteral("metadata")] = logic->getMetadata();
+        return QVariant(snapshot);
+    });
+}
+
+void SynchronizedListModel2::rowsChanged(int first, int last, const QVector<int> &roles)
+{
+    if(!_batchUpdate)
+    {
+        for(int row = first; row <= last; row++)
+        {
+            _coalescer->rowChanged(row, roles);
+        }
+        return;
+    }
+
+    // an empty role list stands for all roles
+    if(_changedFirst < 0)
+    {
+        _changedFirst = first;
+        _changedLast = last;
+        _changedRoles = roles;
+        return;
+    }
+
+    _changedFirst = qMin(_changedFirst, first);
+    _changedLast = qMax(_changedLast, last);
+    if(roles.isEmpty() || _changedRoles.isEmpty())
+    {
+        _changedRoles.clear();
+        return;
+    }
+
+    for(int role : roles)
+    {
+        if(!_changedRoles.contains(role))
+            _changedRoles << role;
+    }
+}
+
+void SynchronizedListModel2::flushChangedRows()
+{
+    // rows which were changed before an insert or removal keep their index
+    _coalescer->flush();
+    if(_changedFirst < 0)
+        return;
+
+    Q_EMIT dataChanged(this->index(_changedFirst), this->index(_changedLast), _changedRoles);
+    _changedFirst = -1;
+    _changedLast = -1;
+    _changedRoles.clear();
+}
+
+void SynchronizedListModel2::modified(bool rowCountChanged)
+{
+    if(_batchUpdate)
+    {
+        _batchModified = true;
+        _batchCountChanged |= rowCountChanged;
+        return;
+    }
+
+    if(rowCountChanged)
+        Q_EMIT countChanged();
+
+    Q_EMIT listModified();
+}
+
+void SynchronizedListModel2::batchStarted()
+{
+    _batchUpdate = true;
+    _batchModified = false;
+    _batchCountChanged = false;
+}
+
+void SynchronizedListModel2::batchApplied()
+{
+    _batchUpdate = false;
+    flushChangedRows();
+    if(_batchModified)
+        modified(_batchCountChanged);
+}
+
+void SynchronizedListModel2::batchFinished(QString batchId, bool success, QString errorString)
+{
+    QJSValue callback = _batchCallbacks.take(batchId);
+    if(callback.isCallable())
+        callback.call(QJSValueList { success, errorString });
 }
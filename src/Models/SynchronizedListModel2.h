@@ -7,25 +7,39 @@
 #ifndef SynchronizedListModel2_H
 #define SynchronizedListModel2_H
 
-#include "../Core/ListModelBase.h"
 #include "../Core/ResourceCommunicationHandler.h"
 #include "../Shared/VirtualConnection.h"
 #include "SynchronizedListLogic.h"
+#include "SynchronizedListStore.h"
 #include <QObject>
+#include <QAbstractListModel>
+#include <QSet>
 #include <QQmlParserStatus>
+#include <QJSValue>
+
+class ChangeCoalescer;
 
 /*!
     \qmltype SynchronizedListModel
     \inqmlmodule QuickHub
-    \inherits ListModelBase<QVariant>
+    \inherits QAbstractListModel
     \instantiates SynchronizedListModel2
     \brief Provides access to QuickHub list resources
 
     In addition, this class is the UI model part of SynchronizedListModel. The WebSocket
     interface to the server is wrapped in SynchronizedListLogic
+
+    The rows are kept in a ColumnStore. Every key of the rows is a role; role n+1 is column n,
+    the display role shows the value of the column as string.
+
+    All models which show the same resource with the same filter share one SynchronizedListStore,
+    see SubscriptionRegistry. The resource is attached and dumped once and its rows are kept once.
+    preloadCount, optimistic and mutationTimeout are settings of the shared list; a model which joins
+    a loaded list takes them over, changing them changes them for all its models. Lists with a
+    windowSize are not shared.
 */
 
-class SynchronizedListModel2 : public ListModelBase<QVariant>, public QQmlParserStatus
+class SynchronizedListModel2 : public QAbstractListModel, public QQmlParserStatus
 {
     Q_OBJECT
     /*!
@@ -42,6 +56,48 @@ class SynchronizedListModel2 : public ListModelBase<QVariant>, public QQmlParser
     */
     Q_PROPERTY(int preloadCount READ preloadCount WRITE setPreloadCount NOTIFY preloadCountChanged)
 
+    /*!
+        \qmlproperty int SynchronizedListModel2::windowSize
+        If greater than 0, lazily loaded lists (preloadCount > 0) are kept in a window of at most
+        windowSize rows. count then holds the remote item count. Rows which are not loaded return
+        undefined for all roles and are fetched page by page as soon as a view asks for them.
+        The least recently used pages are evicted. windowSize should be larger than the number of
+        rows a view shows and caches at once.
+        \sa isLoaded
+    */
+    Q_PROPERTY(int windowSize READ windowSize WRITE setWindowSize NOTIFY windowSizeChanged)
+
+    /*!
+        \qmlproperty bool SynchronizedListModel2::optimistic
+        If true, append(), insertAt(), set(), setProperty() and remove() change the rows right away
+        instead of waiting for the server. Changes the server rejects or does not confirm within
+        mutationTimeout ms are rolled back and reported by mutationFailed().
+        \default false
+    */
+    Q_PROPERTY(bool optimistic READ optimistic WRITE setOptimistic NOTIFY optimisticChanged)
+
+    /*!
+        \qmlproperty int SynchronizedListModel2::mutationTimeout
+        Time in milliseconds after which an optimistic change without reply is rolled back.
+        \default 5000
+    */
+    Q_PROPERTY(int mutationTimeout READ mutationTimeout WRITE setMutationTimeout NOTIFY mutationTimeoutChanged)
+
+    /*!
+        \qmlproperty bool SynchronizedListModel2::coalesceChanges
+        If true, changed rows are reported to the views once per frame (or every coalesceInterval ms)
+        instead of once per change. Adjacent rows with the same changed roles are reported together.
+        \default false
+    */
+    Q_PROPERTY(bool coalesceChanges READ coalesceChanges WRITE setCoalesceChanges NOTIFY coalesceChangesChanged)
+
+    /*!
+        \qmlproperty int SynchronizedListModel2::coalesceInterval
+        Time in milliseconds between two reports of coalesced changes. 0 reports them once per frame.
+        \default 0
+    */
+    Q_PROPERTY(int coalesceInterval READ coalesceInterval WRITE setCoalesceInterval NOTIFY coalesceIntervalChanged)
+
     /*!
         \qmlproperty int SynchronizedListModel2::resource
         The resource identifier is used to determine from which resource the data should be loaded.
@@ -86,6 +142,8 @@ class SynchronizedListModel2 : public ListModelBase<QVariant>, public QQmlParser
 
 public:
 
+    int count() const;
+    virtual int rowCount(const QModelIndex &parent = QModelIndex()) const override;
     virtual int columnCount(const QModelIndex &parent = QModelIndex()) const override;
     /*!
         \fn QString SynchronizedListModel2::getUserIDForIndex(int index)
@@ -148,6 +206,20 @@ public:
     */
     Q_INVOKABLE void clear();
 
+    /*!
+        \fn void SynchronizedListModel2::beginBatch()
+        Collects all following changes until commit() is called. Batches can be nested.
+    */
+    Q_INVOKABLE void beginBatch();
+
+    /*!
+        \fn void SynchronizedListModel2::commit(QJSValue callback)
+        Sends the collected changes in one message. The server applies all of them or none, the
+        model is updated once when the server confirms the batch. The optional callback is called
+        with (success, errorString) when the server answered.
+    */
+    Q_INVOKABLE void commit(QJSValue callback = QJSValue());
+
     /*!
         \fn void SynchronizedListModel2::remove(int index)
         Removes and deletes all the apropriate item with the given index from list.
@@ -174,6 +246,13 @@ public:
     */
     Q_INVOKABLE  QVariant get(int index);
 
+    /*!
+        \fn bool SynchronizedListModel2::isLoaded(int index)
+        Returns false if the row at index is a placeholder which is not loaded yet. This is
+        only the case if a windowSize is set.
+    */
+    Q_INVOKABLE bool isLoaded(int index) const;
+
     /*!
         \fn QVariant SynchronizedListModel2::get(int index)
         Returns the current index for the object with the given uuid.
@@ -193,6 +272,8 @@ public:
     mutable QHash<int, QByteArray> _roles;
 
 
+    ~SynchronizedListModel2();
+
     // Property getters & setters
     bool getConnected();
 
@@ -210,6 +291,21 @@ public:
     int preloadCount() const;
     void setPreloadCount(int preloadCount);
 
+    int windowSize() const;
+    void setWindowSize(int windowSize);
+
+    bool optimistic() const;
+    void setOptimistic(bool optimistic);
+
+    int mutationTimeout() const;
+    void setMutationTimeout(int mutationTimeout);
+
+    bool coalesceChanges() const;
+    void setCoalesceChanges(bool coalesceChanges);
+
+    int coalesceInterval() const;
+    void setCoalesceInterval(int coalesceInterval);
+
     bool getInitialized();
 
 signals:
@@ -223,13 +319,53 @@ signals:
     void listSuccessfullModified();
     void filterChanged();
     void preloadCountChanged();
+    void windowSizeChanged();
+    void optimisticChanged();
+    void mutationTimeoutChanged();
+    void coalesceChangesChanged();
+    void coalesceIntervalChanged();
+    void mutationFailed(QString command, QString errorString);
     void listModified();
     void initializedChanged();
 
 private:
+    SynchronizedListStore*  _list;
     SynchronizedListLogic*  _logic;
+    ChangeCoalescer*        _coalescer;
+
+    // see SubscriptionRegistry
+    void                    subscribe();
+    SynchronizedListStore*  createList() const;
+    void                    setList(SynchronizedListStore* list, bool shared);
+    void                    releaseList(SynchronizedListStore* list, bool shared);
+    QString                 descriptor() const;
+    bool                    _shared = false;
+
+    // see ResourceCache
+    void                    loadFromCache();
+
+    // changes of a batch are reported at once, see beginBatch
+    void                    rowsChanged(int first, int last, const QVector<int>& roles = QVector<int>());
+    void                    flushChangedRows();
+    void                    modified(bool rowCountChanged);
+    bool                    _batchUpdate = false;
+    bool                    _batchModified = false;
+    bool                    _batchCountChanged = false;
+    int                     _changedFirst = -1;
+    int                     _changedLast = -1;
+    QVector<int>            _changedRoles;
+    QHash<QString, QJSValue> _batchCallbacks;
+
+    // windowed mode, see windowSize
+    void                    registerRoles(const ColumnStore& store) const;
+    void                    requestPage(int page) const;
+    int                     _windowSize = 0;
+    bool                    _windowed = false;
+    bool                    _windowVisible = false;
+    int                     _windowCount = 0;
+    QHash<int, ColumnStore> _pages;
+    mutable QSet<int>       _requestedPages;
     QVariantMap             _filter;
-    int                     _preloadCount=50;
     bool                    _complete = false;
     QString                 _resourceName;
 
@@ -239,10 +375,29 @@ public slots:
 
     void itemPropertyChanged(int index, QString property, QVariant data);
     void itemUpdated(int index, QVariant data);
-    void itemAdded(int index, QVariant data);
-    void itemRemoved(int index);
-    void listCleared();
-    void itemsAppended(QVariantList items);
+    void storeInCache();
+
+    void batchStarted();
+    void batchApplied();
+    void batchFinished(QString batchId, bool success, QString errorString);
+
+    void windowReset(int count);
+    void pageLoaded(int page, QVariantList data);
+    void pageEvicted(int page);
+    void windowRowsInserted(int index, int count);
+    void windowRowsRemoved(int index, int count);
+
+private slots:
+    // changes of the SynchronizedListStore
+    void listRowsAboutToBeInserted(int first, int last);
+    void listRowsInserted(int first, int last);
+    void listRowsAboutToBeRemoved(int first, int last);
+    void listRowsRemoved(int first, int last);
+    void listRowAboutToBeMoved(int from, int to);
+    void listRowMoved(int from, int to);
+    void listRowChanged(int row, int column);
+    void listAboutToBeCleared();
+    void listAboutToBeReset();
 };
 
 #endif // SynchronizedListModel2_H
@@ -0,0 +1,138 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * It is part of the QuickHub framework - www.quickhub.org
+ * Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de */
+
+
+#include "SynchronizedListStore.h"
+
+SynchronizedListStore::SynchronizedListStore(QObject *parent) : QObject(parent),
+    _logic(new SynchronizedListLogic(this))
+{
+    connect(_logic, &SynchronizedListLogic::itemPropertyChanged, this, &SynchronizedListStore::itemPropertyChanged);
+    connect(_logic, &SynchronizedListLogic::itemUpdated, this, &SynchronizedListStore::itemUpdated);
+    connect(_logic, &SynchronizedListLogic::itemAdded, this, &SynchronizedListStore::addItem);
+    connect(_logic, &SynchronizedListLogic::itemRemoved, this, &SynchronizedListStore::removeItem);
+    connect(_logic, &SynchronizedListLogic::itemMoved, this, &SynchronizedListStore::moveItem);
+    connect(_logic, &SynchronizedListLogic::itemsAppended, this, &SynchronizedListStore::appendItems);
+    connect(_logic, &SynchronizedListLogic::listCleared, this, &SynchronizedListStore::clearItems);
+    connect(_logic, &SynchronizedListLogic::windowReset, this, &SynchronizedListStore::resetWindow);
+    _logic->setRowSource([this](int index) {
+        return _rows.row(index);
+    });
+}
+
+SynchronizedListStore::~SynchronizedListStore()
+{
+    if(_logic->getConnected())
+        _logic->disconnectList();
+}
+
+SynchronizedListLogic *SynchronizedListStore::logic() const
+{
+    return _logic;
+}
+
+const ColumnStore &SynchronizedListStore::rows() const
+{
+    return _rows;
+}
+
+void SynchronizedListStore::itemPropertyChanged(int index, QString property, QVariant data)
+{
+    // windowed lists are kept by the model
+    if(_logic->isWindowed())
+        return;
+
+    if(index >= 0 && index < _rows.count())
+    {
+        int column = _rows.setValue(index, property.toLatin1(), data);
+        Q_EMIT rowChanged(index, column);
+        Q_EMIT modified(false);
+    }
+}
+
+void SynchronizedListStore::itemUpdated(int index, QVariant data)
+{
+    if(_logic->isWindowed())
+        return;
+
+    if(index >= 0 && index < _rows.count())
+    {
+        _rows.replace(index, data);
+        Q_EMIT rowChanged(index, -1);
+    }
+    Q_EMIT modified(false);
+}
+
+void SynchronizedListStore::addItem(int index, QVariant data)
+{
+    if(index < 0 || index > _rows.count())
+        index = _rows.count();
+
+    Q_EMIT rowsAboutToBeInserted(index, index);
+    _rows.insert(index, data);
+    Q_EMIT rowsInserted(index, index);
+    Q_EMIT itemAdded(index, data);
+    Q_EMIT modified(true);
+}
+
+void SynchronizedListStore::removeItem(int index)
+{
+    if(index >= 0 && index < _rows.count())
+    {
+        Q_EMIT rowsAboutToBeRemoved(index, index);
+        _rows.remove(index);
+        Q_EMIT rowsRemoved(index, index);
+    }
+    Q_EMIT itemRemoved(index);
+    Q_EMIT modified(true);
+}
+
+void SynchronizedListStore::moveItem(int from, int to)
+{
+    if(from < 0 || from >= _rows.count() || to < 0 || to >= _rows.count() || from == to)
+        return;
+
+    Q_EMIT rowAboutToBeMoved(from, to);
+    _rows.move(from, to);
+    Q_EMIT rowMoved(from, to);
+    Q_EMIT modified(false);
+}
+
+void SynchronizedListStore::appendItems(QVariantList items)
+{
+    if(!items.isEmpty())
+    {
+        int first = _rows.count();
+        Q_EMIT rowsAboutToBeInserted(first, first + items.count() - 1);
+        _rows.append(items);
+        Q_EMIT rowsInserted(first, first + items.count() - 1);
+    }
+    Q_EMIT modified(true);
+}
+
+void SynchronizedListStore::clearItems()
+{
+    Q_EMIT aboutToBeCleared();
+    int count = _rows.count();
+    if(count > 0)
+        Q_EMIT rowsAboutToBeRemoved(0, count - 1);
+
+    // the next dump may bring a different schema
+    _rows.clear();
+    Q_EMIT cleared();
+
+    if(count > 0)
+        Q_EMIT rowsRemoved(0, count - 1);
+
+    Q_EMIT modified(true);
+}
+
+void SynchronizedListStore::resetWindow(int count)
+{
+    Q_EMIT aboutToBeReset();
+    _rows.clear();
+    Q_EMIT reset(count);
+}
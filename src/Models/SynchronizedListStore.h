@@ -0,0 +1,74 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * It is part of the QuickHub framework - www.quickhub.org
+ * Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de */
+
+
+#ifndef SYNCHRONIZEDLISTSTORE_H
+#define SYNCHRONIZEDLISTSTORE_H
+
+#include <QObject>
+#include "SynchronizedListLogic.h"
+#include "ColumnStore.h"
+
+/*!
+    \class SynchronizedListStore
+    \brief Holds the rows of a list resource for all SynchronizedListModels which show it.
+
+    The store applies the changes reported by its SynchronizedListLogic to a ColumnStore. Every
+    change of the row count is announced before and reported after the rows are changed, so each
+    model can call the matching begin and end functions of QAbstractItemModel. Stores are shared
+    through the SubscriptionRegistry. The rows of windowed lists are kept by the model.
+*/
+
+class SynchronizedListStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SynchronizedListStore(QObject *parent = nullptr);
+    ~SynchronizedListStore();
+
+    SynchronizedListLogic*  logic() const;
+    const ColumnStore&      rows() const;
+
+signals:
+    void rowsAboutToBeInserted(int first, int last);
+    void rowsInserted(int first, int last);
+    void rowsAboutToBeRemoved(int first, int last);
+    void rowsRemoved(int first, int last);
+    void rowAboutToBeMoved(int from, int to);
+    void rowMoved(int from, int to);
+
+    // column is -1 if the whole row was replaced
+    void rowChanged(int row, int column);
+
+    void itemAdded(int index, QVariant data);
+    void itemRemoved(int index);
+    void aboutToBeCleared();
+    void cleared();
+
+    // the rows were dropped because the list switched to windowed mode
+    void aboutToBeReset();
+    void reset(int count);
+
+    // emitted after every change, like SynchronizedListModel2::listModified
+    void modified(bool rowCountChanged);
+
+private:
+    SynchronizedListLogic*  _logic;
+    ColumnStore             _rows;
+
+private slots:
+    void itemPropertyChanged(int index, QString property, QVariant data);
+    void itemUpdated(int index, QVariant data);
+    void addItem(int index, QVariant data);
+    void removeItem(int index);
+    void moveItem(int from, int to);
+    void appendItems(QVariantList items);
+    void clearItems();
+    void resetWindow(int count);
+};
+
+#endif // SYNCHRONIZEDLISTSTORE_H
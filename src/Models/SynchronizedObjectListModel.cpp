@@ -16,6 +16,8 @@ SynchronizedObjectListModel::SynchronizedObjectListModel(QObject *parent) : QObj
     connect(_logic, &SynchronizedListLogic::itemAdded, this, &SynchronizedObjectListModel::itemAdded);
     connect(_logic, &SynchronizedListLogic::itemPropertyChanged, this, &SynchronizedObjectListModel::itemPropertyChanged);
     connect(_logic, &SynchronizedListLogic::itemRemoved, this, &SynchronizedObjectListModel::itemRemoved);
+    connect(_logic, &SynchronizedListLogic::itemUpdated, this, &SynchronizedObjectListModel::itemUpdated);
+    connect(_logic, &SynchronizedListLogic::itemMoved, this, &SynchronizedObjectListModel::itemMoved);
     connect(_logic, &SynchronizedListLogic::initializedChanged, this, &SynchronizedObjectListModel::initializedChanged);
 }
 
@@ -63,6 +65,32 @@ void SynchronizedObjectListModel::itemRemoved(int index)
     Q_EMIT sigItemRemoved(key);
 }
 
+void SynchronizedObjectListModel::itemUpdated(int index, QVariant data)
+{
+    if(index < 0 || index >= _keyList.count())
+        return;
+
+    QVariantMap map = data.toMap();
+    QString key = map[_lookupKey].toString();
+    if(key != _keyList.at(index))
+    {
+        itemRemoved(index);
+        itemAdded(index, data);
+        return;
+    }
+
+    initPropertyMap(map, _map.value(key, nullptr));
+}
+
+void SynchronizedObjectListModel::itemMoved(int from, int to)
+{
+    if(from < 0 || from >= _keyList.count() || to < 0 || to >= _keyList.count())
+        return;
+
+    _keyList.move(from, to);
+    Q_EMIT keysChanged();
+}
+
 void SynchronizedObjectListModel::listCleared()
 {
     _keyList.clear();
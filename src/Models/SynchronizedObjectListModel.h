@@ -149,6 +149,8 @@ private slots:
     void itemPropertyChanged(int index, QString property, QVariant data);
     void itemAdded(int index, QVariant data);
     void itemRemoved(int index);
+    void itemUpdated(int index, QVariant data);
+    void itemMoved(int from, int to);
     void listCleared();
 
 private:
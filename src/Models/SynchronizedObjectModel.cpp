@@ -8,45 +8,46 @@
 #include "SynchronizedObjectModel.h"
 #include <QDebug>
 #include "../Core/CloudModel.h"
+#include "../Core/SubscriptionRegistry.h"
+#include "../Helpers/ResourceCache.h"
 #include <QJsonDocument>
 SynchronizedObjectModel::SynchronizedObjectModel(QObject *parent) : QQmlPropertyMap(this, parent),
-    _communicationHandler(new ResourceCommunicationHandler("object", this))
+    _communicationHandler(nullptr)
 {
-    connect(_communicationHandler,SIGNAL(newMessage(QVariant)), this, SLOT(messageReceived(QVariant)));
-    connect(_communicationHandler,SIGNAL(attachedChanged()), this, SIGNAL(connectedChanged()));
-    connect(_communicationHandler,SIGNAL(stateChanged()), this, SIGNAL(modelStateChanged()));
 }
 
 SynchronizedObjectModel::~SynchronizedObjectModel()
 {
+    unsubscribe();
 }
 
 void SynchronizedObjectModel::connectObject()
 {
-    _communicationHandler->attachModel();
+    if(!_communicationHandler)
+        subscribe();
 }
 
 void SynchronizedObjectModel::disconnectObject()
 {
-    _communicationHandler->detachModel();
+    // the attachment is shared, only this model lets go of it
+    if(!_communicationHandler)
+        return;
+
+    unsubscribe();
+    Q_EMIT connectedChanged();
+    Q_EMIT modelStateChanged();
 }
 
 QVariant SynchronizedObjectModel::updateValue(const QString &key, const QVariant &input)
 {
-    QVariantMap msg;
-    msg["command"] = "object:property:set";
-    QVariantMap parameters;
-    parameters["property"] = key;
-    parameters["data"] = input;
-    msg["parameters"]  = parameters;
-    _communicationHandler->sendMessage(msg);
+    sendProperty(key, input);
     return input;
 }
 
 
 bool SynchronizedObjectModel::getConnected() const
 {
-    return _communicationHandler->isAttached();
+    return _communicationHandler && _communicationHandler->isAttached();
 }
 
 QVariantMap SynchronizedObjectModel::getMetadata() const
@@ -61,16 +62,11 @@ bool SynchronizedObjectModel::initialized() const
 
 Q_INVOKABLE void SynchronizedObjectModel::setProperty(QString key, QVariant value)
 {
-    QVariantMap msg;
-    msg["command"] = "object:property:set";
-    QVariantMap parameters;
-    parameters["property"] = key;
-    parameters["data"] = value;
-    msg["parameters"]  = parameters;
-    _communicationHandler->sendMessage(msg);
+    sendProperty(key, value);
     this->insert(key, value);
     _keys << key;
     Q_EMIT keysChanged();
+    storeInCache();
 }
 
 void SynchronizedObjectModel::setPropertyWithCallback(QString key, QVariant value, QJSValue callback)
@@ -83,6 +79,9 @@ void SynchronizedObjectModel::setPropertyWithCallback(QString key, QVariant valu
 
 ResourceCommunicationHandler::ModelState SynchronizedObjectModel::getModelState() const
 {
+    if(!_communicationHandler)
+        return ResourceCommunicationHandler::MODEL_DISCONNECTED;
+
     return _communicationHandler->getState();
 }
 
@@ -98,7 +97,10 @@ void SynchronizedObjectModel::setFilter(const QVariantMap &filter)
     QVariantMap parameters;
     parameters[QStringLiteral("data")] = filter;
     msg[QStringLiteral("parameters")] = parameters;
-    _communicationHandler->sendMessage(msg);
+
+    // the filter applies to the attachment, which is shared by all models of the resource
+    if(_communicationHandler)
+        _communicationHandler->sendMessage(msg);
     Q_EMIT filterChanged();
 }
 
@@ -116,9 +118,9 @@ void SynchronizedObjectModel::setResource(const QString &resourceName)
     _initialized = false;
     Q_EMIT initializedChanged();
     _resource = resourceName;
-    _communicationHandler->setDescriptor(_resource);
-    _communicationHandler->attachModel();
+    subscribe();
     Q_EMIT resourceChanged();
+    loadFromCache();
 }
 
 QStringList SynchronizedObjectModel::keys()
@@ -154,6 +156,7 @@ void SynchronizedObjectModel::messageReceived(QVariant message)
         Q_EMIT metadataChanged();
         Q_EMIT initializedChanged();
         Q_EMIT keysChanged();
+        storeInCache();
         return;
     }
 
@@ -164,6 +167,7 @@ void SynchronizedObjectModel::messageReceived(QVariant message)
         _keys << key;
         this->insert(key, value);
         Q_EMIT keysChanged();
+        storeInCache();
         return;
     }
 
@@ -198,3 +202,107 @@ void SynchronizedObjectModel::resetProperties()
     Q_EMIT keysChanged();
     QListIterator<QString>it(keys);
 }
+
+void SynchronizedObjectModel::subscribe()
+{
+    unsubscribe();
+    if(_resource.isEmpty())
+        return;
+
+    SubscriptionRegistry* registry = SubscriptionRegistry::instance();
+    _communicationHandler = registry->acquireHandler(QStringLiteral("object"), _resource, this);
+    registry->connectSubscriber(_communicationHandler, this, [](QObject* subscriber) {
+        SynchronizedObjectModel* model = qobject_cast<SynchronizedObjectModel*>(subscriber);
+        return model && model->_initialized ? QVariant(model->dumpMessage()) : QVariant();
+    });
+}
+
+void SynchronizedObjectModel::unsubscribe()
+{
+    if(!_communicationHandler)
+        return;
+
+    disconnect(_communicationHandler, nullptr, this, nullptr);
+    SubscriptionRegistry::instance()->release(_communicationHandler, this, [this]() {
+        return _initialized ? QVariant(dumpMessage()) : QVariant();
+    });
+    _communicationHandler = nullptr;
+}
+
+void SynchronizedObjectModel::sendProperty(const QString &key, const QVariant &value)
+{
+    QVariantMap msg;
+    msg["command"] = "object:property:set";
+    QVariantMap parameters;
+    parameters["property"] = key;
+    parameters["data"] = value;
+    msg["parameters"]  = parameters;
+    if(!_communicationHandler)
+        return;
+
+    _communicationHandler->sendMessage(msg);
+
+    // the server does not echo the change to the shared attachment, the other models take it from here
+    for(QObject* subscriber : SubscriptionRegistry::instance()->subscribers(_communicationHandler))
+    {
+        SynchronizedObjectModel* model = qobject_cast<SynchronizedObjectModel*>(subscriber);
+        if(model && model != this)
+            model->messageReceived(msg);
+    }
+}
+
+QVariantMap SynchronizedObjectModel::dumpMessage() const
+{
+    QVariantMap data;
+    for(const QString& key : _keys)
+    {
+        QVariantMap property = _objectdata.value(key).toMap();
+        property["data"] = this->value(key);
+        data.insert(key, property);
+    }
+
+    QVariantMap parameters;
+    parameters["data"] = data;
+    parameters["metadata"] = _metadata;
+
+    QVariantMap msg;
+    msg["command"] = "object:dump";
+    msg["parameters"] = parameters;
+    return msg;
+}
+
+void SynchronizedObjectModel::loadFromCache()
+{
+    QVariantMap cached = ResourceCache::instance()->load(QStringLiteral("object"), _resource).toMap();
+    if(cached.isEmpty() || _initialized)
+        return;
+
+    // the properties are shown until object:dump overwrites them
+    _metadata = cached.value(QStringLiteral("metadata")).toMap();
+    QMapIterator<QString, QVariant> it(cached.value(QStringLiteral("data")).toMap());
+    while(it.hasNext())
+    {
+        it.next();
+        this->insert(it.key(), it.value());
+        _keys << it.key();
+    }
+
+    Q_EMIT metadataChanged();
+    Q_EMIT keysChanged();
+}
+
+void SynchronizedObjectModel::storeInCache()
+{
+    ResourceCache::instance()->scheduleStore(QStringLiteral("object"), _resource, this, [this]() {
+        QVariantMap data;
+        for(const QString& key : qAsConst(_keys))
+        {
+            data.insert(key, this->value(key));
+        }
+
+        QVariantMap snapshot;
+        snapshot[QStringLiteral("data")] = data;
+        snapshot[QStringLiteral("metadata")] = _metadata;
+        return QVariant(snapshot);
+    });
+}
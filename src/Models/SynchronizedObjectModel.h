@@ -22,6 +22,9 @@
 
     In addition, this class is the QML interface to  SynchronizedObjectModel. The WebSocket
     interface to the server is wrapped by this class
+
+    All models of the same resource share one attachment, see SubscriptionRegistry. A model
+    which is added to a loaded resource takes its properties from another model.
 */
 
 class SynchronizedObjectModel : public QQmlPropertyMap
@@ -127,6 +130,16 @@ public slots:
 protected:
 
 private:
+    // see SubscriptionRegistry
+    void                            subscribe();
+    void                            unsubscribe();
+    QVariantMap                     dumpMessage() const;
+    void                            sendProperty(const QString& key, const QVariant& value);
+
+    // see ResourceCache
+    void                            loadFromCache();
+    void                            storeInCache();
+
     QSet<QString>                    _keys;
     ResourceCommunicationHandler*   _communicationHandler;
     QVariantMap                     _metadata;
@@ -0,0 +1,239 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * It is part of the QuickHub framework - www.quickhub.org
+ * Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de */
+
+
+#include "UuidIndex.h"
+#include <QVector>
+
+UuidIndex::UuidIndex()
+{
+}
+
+UuidIndex::~UuidIndex()
+{
+    clear();
+}
+
+int UuidIndex::count() const
+{
+    return size(_root);
+}
+
+void UuidIndex::insert(int row, const QString &uuid)
+{
+    if(row < 0 || row > count())
+        row = count();
+
+    Node* node = new Node;
+    node->priority = nextPriority();
+    setKey(node, uuid);
+
+    Node* left;
+    Node* right;
+    split(_root, row, left, right);
+    _root = merge(merge(left, node), right);
+    _root->parent = nullptr;
+}
+
+void UuidIndex::append(const QString &uuid)
+{
+    insert(count(), uuid);
+}
+
+void UuidIndex::replace(int row, const QString &uuid)
+{
+    Node* node = nodeAt(row);
+    if(!node)
+        return;
+
+    unsetKey(node);
+    setKey(node, uuid);
+}
+
+void UuidIndex::remove(int row)
+{
+    if(row < 0 || row >= count())
+        return;
+
+    Node* left;
+    Node* middle;
+    Node* right;
+    split(_root, row, left, right);
+    split(right, 1, middle, right);
+
+    unsetKey(middle);
+    delete middle;
+
+    _root = merge(left, right);
+    if(_root)
+        _root->parent = nullptr;
+}
+
+void UuidIndex::clear()
+{
+    // iterative, the tree is only balanced in expectation
+    QVector<Node*> stack;
+    if(_root)
+        stack << _root;
+
+    while(!stack.isEmpty())
+    {
+        Node* node = stack.takeLast();
+        if(node->left)
+            stack << node->left;
+        if(node->right)
+            stack << node->right;
+        delete node;
+    }
+
+    _root = nullptr;
+    _nodes.clear();
+    _idNodes.clear();
+}
+
+int UuidIndex::indexOf(const QString &uuid) const
+{
+    QUuid key(uuid);
+    Node* node = key.isNull() ? _idNodes.value(uuid) : _nodes.value(key);
+    if(!node)
+        return -1;
+
+    int row = size(node->left);
+    while(node->parent)
+    {
+        if(node->parent->right == node)
+            row += size(node->parent->left) + 1;
+
+        node = node->parent;
+    }
+    return row;
+}
+
+int UuidIndex::size(Node *node)
+{
+    return node ? node->size : 0;
+}
+
+void UuidIndex::update(Node *node)
+{
+    node->size = 1 + size(node->left) + size(node->right);
+    if(node->left)
+        node->left->parent = node;
+    if(node->right)
+        node->right->parent = node;
+}
+
+void UuidIndex::split(Node *node, int count, Node *&left, Node *&right)
+{
+    if(!node)
+    {
+        left = right = nullptr;
+        return;
+    }
+
+    if(size(node->left) < count)
+    {
+        split(node->right, count - size(node->left) - 1, node->right, right);
+        left = node;
+    }
+    else
+    {
+        split(node->left, count, left, node->left);
+        right = node;
+    }
+
+    update(node);
+
+    // the roots of both halves may still point to their old parent
+    if(left)
+        left->parent = nullptr;
+    if(right)
+        right->parent = nullptr;
+}
+
+UuidIndex::Node *UuidIndex::merge(Node *left, Node *right)
+{
+    if(!left)
+        return right;
+    if(!right)
+        return left;
+
+    if(left->priority > right->priority)
+    {
+        left->right = merge(left->right, right);
+        update(left);
+        return left;
+    }
+
+    right->left = merge(left, right->left);
+    update(right);
+    return right;
+}
+
+UuidIndex::Node *UuidIndex::nodeAt(int row) const
+{
+    if(row < 0 || row >= count())
+        return nullptr;
+
+    Node* node = _root;
+    while(node)
+    {
+        int leftSize = size(node->left);
+        if(row < leftSize)
+        {
+            node = node->left;
+        }
+        else if(row == leftSize)
+        {
+            return node;
+        }
+        else
+        {
+            row -= leftSize + 1;
+            node = node->right;
+        }
+    }
+    return nullptr;
+}
+
+void UuidIndex::setKey(Node *node, const QString &uuid)
+{
+    node->uuid = QUuid(uuid);
+    if(node->uuid.isNull())
+    {
+        node->id = uuid;
+        _idNodes.insert(uuid, node);
+    }
+    else
+    {
+        node->id.clear();
+        _nodes.insert(node->uuid, node);
+    }
+}
+
+void UuidIndex::unsetKey(Node *node)
+{
+    // duplicated uuids only keep the most recent node in the hash
+    if(node->uuid.isNull())
+    {
+        if(_idNodes.value(node->id) == node)
+            _idNodes.remove(node->id);
+    }
+    else
+    {
+        if(_nodes.value(node->uuid) == node)
+            _nodes.remove(node->uuid);
+    }
+}
+
+quint32 UuidIndex::nextPriority()
+{
+    // xorshift32
+    _seed ^= _seed << 13;
+    _seed ^= _seed >> 17;
+    _seed ^= _seed << 5;
+    return _seed;
+}
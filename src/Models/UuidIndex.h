@@ -0,0 +1,74 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * It is part of the QuickHub framework - www.quickhub.org
+ * Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de */
+
+
+#ifndef UUIDINDEX_H
+#define UUIDINDEX_H
+
+#include <QHash>
+#include <QString>
+#include <QUuid>
+
+/*!
+    \class UuidIndex
+    \brief Maps the uuids of list items to their current row.
+
+    The rows are kept as an implicit treap (an order-statistic tree) and the uuids are hashed
+    to their tree nodes, so indexOf(), insert() and remove() take O(log n) no matter where in
+    the list the row is. Uuids are hashed as 128 bit QUuid values; ids which are no valid uuid
+    are hashed as strings.
+*/
+
+class UuidIndex
+{
+public:
+    UuidIndex();
+    ~UuidIndex();
+
+    int     count() const;
+    void    insert(int row, const QString& uuid);
+    void    append(const QString& uuid);
+    void    replace(int row, const QString& uuid);
+    void    remove(int row);
+    void    clear();
+
+    /*!
+        \fn int UuidIndex::indexOf(const QString& uuid) const
+        Returns the row of the given uuid or -1 if it is not part of the list.
+    */
+    int     indexOf(const QString& uuid) const;
+
+private:
+    Q_DISABLE_COPY(UuidIndex)
+
+    struct Node
+    {
+        Node*   left = nullptr;
+        Node*   right = nullptr;
+        Node*   parent = nullptr;
+        int     size = 1;
+        quint32 priority = 0;
+        QUuid   uuid;
+        QString id;     // only used for ids which are no valid uuid
+    };
+
+    static int  size(Node* node);
+    static void update(Node* node);
+    static void split(Node* node, int count, Node*& left, Node*& right);
+    static Node* merge(Node* left, Node* right);
+
+    Node*   nodeAt(int row) const;
+    void    setKey(Node* node, const QString& uuid);
+    void    unsetKey(Node* node);
+    quint32 nextPriority();
+
+    Node*                   _root = nullptr;
+    QHash<QUuid, Node*>     _nodes;
+    QHash<QString, Node*>   _idNodes;
+    quint32                 _seed = 0x9e3779b9;
+};
+
+#endif // UUIDINDEX_H
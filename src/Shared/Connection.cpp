@@ -8,22 +8,165 @@
 #include "Connection.h"
 #include "VirtualConnection.h"
 #include <QDebug>
-#include <QJsonDocument>
+
+namespace
+{
+    // the size of a message as the socket writes it, QWebSocket splits it into frames of
+    // at most frameSize bytes with a header of 2 bytes, the extended length and the mask
+    qint64 webSocketSize(qint64 size, qint64 frameSize, bool masked)
+    {
+        qint64 total = size;
+        qint64 remaining = size;
+        do
+        {
+            qint64 length = qMin(remaining, frameSize);
+            total += 2 + (length > 0xffff ? 8 : (length > 125 ? 2 : 0)) + (masked ? 4 : 0);
+            remaining -= length;
+        }
+        while(remaining > 0);
+
+        return total;
+    }
+}
 
 void Connection::sendVariant(const QVariant& data)
 {
-    _socket->sendBinaryMessage(QJsonDocument::fromVariant(data.toMap()).toJson(QJsonDocument::Compact));
+    if(!_socket && !_replaying)
+        return;
+
+    const QVariantMap msg = data.toMap();
+    QByteArray frame = MessageCodec::encode(msg, _codec);
+    _messagesSent++;
+
+    // keepalive traffic, ACKs and the connection handshake must not wait
+    // behind a batch or behind queued bulk data. Closing a virtual connection
+    // must not overtake its queued frames, so it takes the regular way.
+    QString command = msg.value(QStringLiteral("command")).toString();
+    bool closing = command == QStringLiteral("connection:close") || command == QStringLiteral("connection:closed");
+    if(command == QStringLiteral("ping") || command == QStringLiteral("pong") || (command.startsWith(QStringLiteral("connection:")) && !closing)
+            || msg.value(QStringLiteral("payload")).toMap().value(QStringLiteral("command")).toString() == QStringLiteral("ACK"))
+    {
+        writeFrame(frame, SendQueue::LANE_CONTROL);
+        return;
+    }
+
+    // the virtual connection the frame belongs to keeps its order in the send queue
+    QString key = msg.contains(QStringLiteral("ch")) ? msg.value(QStringLiteral("ch")).toString() : msg.value(QStringLiteral("uuid")).toString();
+    if(!_batching || !_peerUnpacksBatches)
+    {
+        writeFrame(frame, frame.size() > _fragmentSize ? SendQueue::LANE_BULK : SendQueue::LANE_INTERACTIVE, QStringList(key));
+        return;
+    }
+
+    _outbox.append(frame);
+    _outboxKeys.append(key);
+    _outboxBytes += frame.size();
+
+    if(_outboxBytes >= _batchMaxBytes)
+    {
+        flushBatch();
+        return;
+    }
+
+    if(!_batchTimer->isActive())
+        _batchTimer->start();
+}
+
+void Connection::flushBatch()
+{
+    if(_batchTimer)
+        _batchTimer->stop();
+
+    if(_outbox.isEmpty())
+        return;
+
+    QByteArray frame;
+    if(_outbox.count() == 1)
+        frame = _outbox.first();
+    else
+    {
+        frame = MessageCodec::encodeBatch(_outbox, _codec);
+        _framesSaved += _outbox.count() - 1;
+    }
+
+    QStringList keys = _outboxKeys;
+    _outbox.clear();
+    _outboxKeys.clear();
+    _outboxBytes = 0;
+    writeFrame(frame, frame.size() > _fragmentSize ? SendQueue::LANE_BULK : SendQueue::LANE_INTERACTIVE, keys);
+}
+
+void Connection::writeFrame(QByteArray frame, SendQueue::Lane lane, const QStringList& keys)
+{
+    if(!_socket && !_replaying)
+        return;
+
+    _framesSent++;
+    _bytesSentUncompressed += frame.size();
+
+    if(_compressFrames && frame.size() >= _compressionThreshold)
+        frame = MessageCodec::compress(frame);
+
+    _bytesSent += frame.size();
+    _sendQueue.enqueue(frame, lane, keys);
+    writeQueuedFrames();
+}
+
+void Connection::writeQueuedFrames()
+{
+    // while a session is being resumed, only the handshake may pass
+    SendQueue::Lane lowest = _resuming ? SendQueue::LANE_CONTROL : SendQueue::LANE_BULK;
+    while((_socket || _replaying) && _connected && !_sendQueue.isEmpty(lowest) && _bytesInFlight < _highWaterMark)
+    {
+        // large frames are split, so that urgent frames can be sent in between
+        QByteArray frame = _sendQueue.take(lowest, _peerJoinsFragments ? _fragmentSize : 0);
+        Q_EMIT frameWritten(frame);
+        if(_replaying)
+            continue;
+
+        // QWebSocket has no bytesToWrite(), so the bytes handed to the socket are counted
+        // here and released again by bytesWritten(), which includes the websocket framing.
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+        const qint64 frameSize = qint64(_socket->outgoingFrameSize());
+#else
+        const qint64 frameSize = 512 * 1024;
+#endif
+        _bytesInFlight += webSocketSize(frame.size(), frameSize, _maskFrames);
+        _socket->sendBinaryMessage(frame);
+    }
+
+    updateCongestion();
+}
+
+void Connection::socketBytesWritten(qint64 bytes)
+{
+    _bytesInFlight = qMax(Q_INT64_C(0), _bytesInFlight - bytes);
+    writeQueuedFrames();
+}
+
+void Connection::updateCongestion()
+{
+    bool congested = _sendQueue.bytes() + _bytesInFlight >= _highWaterMark;
+    if(congested == _congested)
+        return;
+
+    _congested = congested;
+    Q_EMIT congestionChanged(_congested);
 }
 
 Connection::Connection(QWebSocket *socket, QObject *parent): QObject(parent),
     _connected(false)
 {
+    _clock.start();
+    QObject::connect(this, &Connection::disconnected, this, &Connection::releaseClosingChannels);
     setSocket(socket);
 }
 
 Connection::Connection(QObject *parent) : QObject(parent),
     _connected(false)
 {
+    _clock.start();
+    QObject::connect(this, &Connection::disconnected, this, &Connection::releaseClosingChannels);
 }
 
 Connection::~Connection()
@@ -34,12 +177,24 @@ Connection::~Connection()
 
 void Connection::connect(QString ident)
 {
+    if(_suspended && ident != _url)
+        endSuspension();
+
+    _url = ident;
+
+    // this side opens the socket, so it is the client which has to mask its frames
+    _maskFrames = true;
     if(_socket)
         _socket->open(ident);
 }
 
 void Connection::disconnect()
 {
+    // a deliberate disconnect ends the session
+    _sessionId.clear();
+    if(_suspended)
+        endSuspension();
+
     if(_socket)
         _socket->close();
 }
@@ -58,10 +213,63 @@ void Connection::reset()
     }
 }
 
-void Connection::addVirtualConnection(VirtualConnection *connection)
+int Connection::addVirtualConnection(VirtualConnection *connection)
 {
     _handles.insert(connection->getUUID(), connection);
     QObject::connect(connection, &VirtualConnection::destroyed, this, &Connection::handleDeleted);
+
+    if(!_freeChannels.isEmpty())
+    {
+        int channel = _freeChannels.takeLast();
+        _channels[channel] = connection;
+        return channel;
+    }
+
+    _channels.append(connection);
+    return _channels.count() - 1;
+}
+
+void Connection::closeChannel(const QString &uuid, int channel)
+{
+    if(channel >= 0)
+        _closingChannels.insert(uuid, channel);
+}
+
+VirtualConnection *Connection::getVirtualConnection(const QString &uuid) const
+{
+    return _handles.value(uuid, nullptr);
+}
+
+void Connection::setReplayMode(bool enabled)
+{
+    if(_replaying == enabled)
+        return;
+
+    _replaying = enabled;
+    _aliases.clear();
+    _channelAliases.clear();
+    _connected = enabled;
+    if(enabled)
+        Q_EMIT connected();
+    else
+        Q_EMIT disconnected();
+}
+
+bool Connection::isReplaying() const
+{
+    return _replaying;
+}
+
+void Connection::injectFrame(const QByteArray &frame)
+{
+    messageReceived(frame);
+}
+
+void Connection::addAlias(const QString &uuid, int channel, VirtualConnection *connection)
+{
+    _aliases.insert(uuid, connection);
+    if(channel >= 0)
+        _channelAliases.insert(channel, connection);
 }
 
 bool Connection::isConnected()
@@ -69,6 +277,365 @@ bool Connection::isConnected()
     return _connected;
 }
 
+void Connection::setPreferredCodec(MessageCodec::Format codec)
+{
+    if(_preferredCodec == codec)
+        return;
+
+    _preferredCodec = codec;
+    if(_connected)
+        negotiate();
+}
+
+MessageCodec::Format Connection::getPreferredCodec() const
+{
+    return _preferredCodec;
+}
+
+MessageCodec::Format Connection::getCodec() const
+{
+    return _codec;
+}
+
+void Connection::setBatching(bool enabled, int maxBytes, int maxDelay)
+{
+    _batchMaxBytes = maxBytes;
+    if(!_batchTimer)
+    {
+        _batchTimer = new QTimer(this);
+        _batchTimer->setSingleShot(true);
+        QObject::connect(_batchTimer, &QTimer::timeout, this, &Connection::flushBatch);
+    }
+    _batchTimer->setInterval(maxDelay);
+
+    if(_batching == enabled)
+        return;
+
+    _batching = enabled;
+    if(!_batching)
+        flushBatch();
+
+    if(_connected)
+        negotiate();
+}
+
+bool Connection::getBatching() const
+{
+    return _batching;
+}
+
+void Connection::setCompression(bool enabled, int threshold)
+{
+    _compressionThreshold = threshold;
+    if(_compression == enabled)
+        return;
+
+    _compression = enabled;
+    if(_connected)
+        negotiate();
+}
+
+bool Connection::getCompression() const
+{
+    return _compression;
+}
+
+void Connection::setSendQueueLimits(int highWaterMark, int fragmentSize)
+{
+    _highWaterMark = highWaterMark;
+    _fragmentSize = fragmentSize;
+    writeQueuedFrames();
+}
+
+bool Connection::isCongested() const
+{
+    return _congested;
+}
+
+void Connection::setSessionResumption(bool enabled, int window)
+{
+    _suspendWindow = window;
+    if(_sessionResumption == enabled)
+        return;
+
+    _sessionResumption = enabled;
+    if(!_sessionResumption)
+        _sessionId.clear();
+
+    if(_connected)
+        negotiate();
+}
+
+bool Connection::getSessionResumption() const
+{
+    return _sessionResumption;
+}
+
+bool Connection::isSuspended() const
+{
+    return _suspended;
+}
+
+void Connection::suspend()
+{
+    _suspended = true;
+    if(!_suspendTimer)
+    {
+        _suspendTimer = new QTimer(this);
+        _suspendTimer->setSingleShot(true);
+        QObject::connect(_suspendTimer, &QTimer::timeout, this, &Connection::endSuspension);
+
+        _reconnectTimer = new QTimer(this);
+        _reconnectTimer->setInterval(1000);
+        QObject::connect(_reconnectTimer, &QTimer::timeout, this, &Connection::reconnect);
+    }
+
+    _suspendTimer->start(_suspendWindow);
+    _reconnectTimer->start();
+    Q_EMIT suspendedChanged();
+}
+
+void Connection::reconnect()
+{
+    if(_socket && _socket->state() == QAbstractSocket::UnconnectedState)
+        _socket->open(_url);
+}
+
+void Connection::endSuspension()
+{
+    if(!_suspended)
+        return;
+
+    _suspended = false;
+    _resuming = false;
+    _sessionId.clear();
+    _suspendTimer->stop();
+    _reconnectTimer->stop();
+    if(_batchTimer)
+        _batchTimer->stop();
+    _outbox.clear();
+    _outboxKeys.clear();
+    _outboxBytes = 0;
+    _sendQueue.clear();
+    updateCongestion();
+    Q_EMIT suspendedChanged();
+
+    // continue like the connection has been lost without a session
+    if(_connected)
+    {
+        _socket->abort();
+        return;
+    }
+
+    Q_EMIT disconnected();
+}
+
+void Connection::finishResume(const QVariantMap &parameters)
+{
+    const QString session = parameters["session"].toString();
+    _suspendTimer->stop();
+    _reconnectTimer->stop();
+    _suspended = false;
+    _resuming = false;
+
+    if(session.isEmpty() || session != _sessionId)
+    {
+        // the server has forgotten about us, everything starts from scratch
+        _sessionId = session;
+        _sendQueue.clear();
+        Q_EMIT suspendedChanged();
+        Q_EMIT disconnected();
+        Q_EMIT connected();
+        return;
+    }
+
+    // frames of virtual connections the server has forgotten are addressed to stale channels
+    const QVariantList resumed = parameters["resumed"].toList();
+    QSet<QString> stale;
+    QHashIterator<QString, VirtualConnection*> it(_handles);
+    while(it.hasNext())
+    {
+        it.next();
+        if(resumed.contains(it.key()))
+            continue;
+
+        stale << it.key();
+        if(it.value()->getRemoteChannel() >= 0)
+            stale << QString::number(it.value()->getRemoteChannel());
+    }
+    _sendQueue.remove(stale);
+
+    it.toFront();
+    while(it.hasNext())
+    {
+        it.next();
+        it.value()->resumeSession(resumed.contains(it.key()));
+    }
+
+    Q_EMIT suspendedChanged();
+    writeQueuedFrames();
+}
+
+void Connection::setDecoderThreads(int threads)
+{
+    if(threads <= 0)
+    {
+        if(!_decoder)
+            return;
+
+        // deliver the frames in flight before switching back
+        _decoder->waitForDone();
+        decodedFramesReady();
+        delete _decoder;
+        _decoder = nullptr;
+        return;
+    }
+
+    if(_decoder)
+    {
+        _decoder->setThreadCount(threads);
+        return;
+    }
+
+    _decoder = new FrameDecoder(threads, this);
+    QObject::connect(_decoder, &FrameDecoder::ready, this, &Connection::decodedFramesReady);
+}
+
+int Connection::getDecoderThreads() const
+{
+    if(!_decoder)
+        return 0;
+
+    return _decoder->getThreadCount();
+}
+
+QVariantMap Connection::getStatistics() const
+{
+    QVariantMap statistics;
+    statistics["messagesSent"] = _messagesSent;
+    statistics["framesSent"] = _framesSent;
+    statistics["framesSaved"] = _framesSaved;
+    statistics["messagesReceived"] = _messagesReceived;
+    statistics["framesReceived"] = _framesReceived;
+    statistics["framesSavedInbound"] = _messagesReceived - _framesReceived;
+    statistics["bytesSent"] = _bytesSent;
+    statistics["bytesSentUncompressed"] = _bytesSentUncompressed;
+    statistics["bytesReceived"] = _bytesReceived;
+    statistics["bytesReceivedUncompressed"] = _bytesReceivedUncompressed;
+    statistics["fragmentsSent"] = _sendQueue.fragments();
+    statistics["bytesQueued"] = _sendQueue.bytes();
+    statistics["bytesInFlight"] = _bytesInFlight;
+    statistics["framesDecoding"] = _decoder ? _decoder->pending() : 0;
+    return statistics;
+}
+
+void Connection::negotiate()
+{
+    // peers which don't know about negotiation simply ignore this message
+    // and we keep talking JSON.
+    QVariantMap parameters;
+    if(_preferredCodec != MessageCodec::FORMAT_JSON || _codec != MessageCodec::FORMAT_JSON)
+    {
+        QVariantList codecs;
+        codecs << MessageCodec::formatName(_preferredCodec);
+        if(_preferredCodec != MessageCodec::FORMAT_JSON)
+            codecs << MessageCodec::formatName(MessageCodec::FORMAT_JSON);
+        parameters["codecs"] = codecs;
+    }
+
+    // announces that we are able to unpack batches
+    if(_batching)
+        parameters["batch"] = true;
+
+    if(_compression || _compressFrames)
+    {
+        QVariantList compression;
+        if(_compression)
+            compression << QStringLiteral("zlib");
+        parameters["compression"] = compression;
+    }
+
+    // announces that we are able to join fragmented frames
+    parameters["fragments"] = true;
+
+    // an empty session id asks the server to open a new session. When resuming,
+    // the server replays everything after the sequence numbers we send along.
+    if(_sessionResumption)
+    {
+        parameters["session"] = _sessionId;
+        if(_resuming)
+        {
+            QVariantMap channels;
+            QHashIterator<QString, VirtualConnection*> it(_handles);
+            while(it.hasNext())
+            {
+                it.next();
+                channels[it.key()] = it.value()->getLastSequence();
+            }
+            parameters["channels"] = channels;
+        }
+    }
+
+    QVariantMap msg;
+    msg["command"] = "connection:negotiate";
+    msg["parameters"] = parameters;
+    sendVariant(msg);
+}
+
+void Connection::negotiationRequested(const QVariantMap &parameters)
+{
+    // batched frames are encoded for the current agreement
+    flushBatch();
+
+    MessageCodec::Format codec = MessageCodec::FORMAT_JSON;
+    QListIterator<QVariant> it(parameters["codecs"].toList());
+    while(it.hasNext())
+    {
+        QString name = it.next().toString();
+        if(name == MessageCodec::formatName(MessageCodec::FORMAT_CBOR) || name == MessageCodec::formatName(MessageCodec::FORMAT_JSON))
+        {
+            codec = MessageCodec::formatFromName(name);
+            break;
+        }
+    }
+
+    QVariantMap answer;
+    answer["codec"] = MessageCodec::formatName(codec);
+    answer["batch"] = parameters["batch"].toBool();
+    answer["fragments"] = parameters["fragments"].toBool();
+    answer["compression"] = parameters["compression"].toList().contains(QStringLiteral("zlib")) ? QStringLiteral("zlib") : QString();
+
+    QVariantMap msg;
+    msg["command"] = "connection:negotiated";
+    msg["parameters"] = answer;
+    sendVariant(msg);
+
+    // the answer itself still goes out with the old codec
+    negotiationFinished(answer);
+}
+
+void Connection::negotiationFinished(const QVariantMap &parameters)
+{
+    // a batch must not mix frames of the old and the new codec
+    flushBatch();
+
+    _peerUnpacksBatches = parameters["batch"].toBool();
+    _compressFrames = parameters["compression"].toString() == QStringLiteral("zlib");
+    _peerJoinsFragments = parameters["fragments"].toBool();
+
+    MessageCodec::Format codec = MessageCodec::formatFromName(parameters["codec"].toString());
+    if(codec != _codec)
+    {
+        _codec = codec;
+        Q_EMIT codecChanged();
+    }
+
+    if(_resuming)
+        finishResume(parameters);
+    else if(_sessionResumption)
+        _sessionId = parameters["session"].toString();
+}
+
 void Connection::setSocket(QWebSocket *socket)
 {
     if(_socket)
@@ -78,6 +645,8 @@ void Connection::setSocket(QWebSocket *socket)
         QObject::disconnect(_socket, &QWebSocket::disconnected, this, &Connection::socketDisconnected);
         QObject::disconnect(_socket, SIGNAL(error(QAbstractSocket::SocketError)), this, SIGNAL(socketError(QAbstractSocket::SocketError)));
         QObject::disconnect(_socket,SIGNAL(binaryMessageReceived(QByteArray)), this,SLOT(messageReceived(QByteArray)));
+        QObject::disconnect(_socket, &QWebSocket::bytesWritten, this, &Connection::socketBytesWritten);
+        QObject::disconnect(_socket, &QWebSocket::pong, this, &Connection::socketPong);
         #ifndef WEB_ASSEMBLY
         QObject::disconnect(_socket, &QWebSocket::sslErrors, this, &Connection::sslErrors);
         typedef void (QWebSocket:: *sslErrorsSignal)(const QList<QSslError> &);
@@ -103,6 +672,8 @@ void Connection::setSocket(QWebSocket *socket)
     QObject::connect(_socket, &QWebSocket::disconnected, this, &Connection::socketDisconnected);
     QObject::connect(_socket, SIGNAL(error(QAbstractSocket::SocketError)), this, SIGNAL(socketError(QAbstractSocket::SocketError)));
     QObject::connect(_socket,SIGNAL(binaryMessageReceived(QByteArray)), this,SLOT(messageReceived(QByteArray)));
+    QObject::connect(_socket, &QWebSocket::bytesWritten, this, &Connection::socketBytesWritten);
+    QObject::connect(_socket, &QWebSocket::pong, this, &Connection::socketPong);
     #ifndef WEB_ASSEMBLY
     QObject::connect(_socket, &QWebSocket::sslErrors, this, &Connection::sslErrors);
     typedef void (QWebSocket:: *sslErrorsSignal)(const QList<QSslError> &);
@@ -123,15 +694,57 @@ void Connection::setSocket(QWebSocket *socket)
 
 void Connection::socketDisconnected()
 {
+    bool keepSession = _sessionResumption && !_sessionId.isEmpty() && _suspendWindow > 0;
     _connected = false;
+    _resuming = false;
+    _peerUnpacksBatches = false;
+    _compressFrames = false;
+    _peerJoinsFragments = false;
+    if(_decoder)
+        _decoder->clear();
+    _bytesInFlight = 0;
+    _fragments.clear();
+    if(_codec != MessageCodec::FORMAT_JSON)
+    {
+        _codec = MessageCodec::FORMAT_JSON;
+        Q_EMIT codecChanged();
+    }
+
+    // messages sent while suspended are kept and go out once the session is resumed.
+    // The other side drops the fragments it has received, so a frame sent in part starts over.
+    if(keepSession)
+    {
+        _sendQueue.restartFragments();
+        if(!_suspended)
+            suspend();
+        return;
+    }
+
+    _outbox.clear();
+    _outboxKeys.clear();
+    _outboxBytes = 0;
+    _sendQueue.clear();
+    updateCongestion();
     Q_EMIT disconnected();
 }
 
 void Connection::socketConnected()
 {
     _connected = true;
+    _lastReceived = _clock.elapsed();
+    _pingSentAt = -1;
     if(_keepAlive)
         _keepAliveTimer->start();
+
+    // the virtual connections don't notice a resumed session
+    if(_suspended)
+    {
+        _resuming = true;
+        negotiate();
+        return;
+    }
+
+    negotiate();
     Q_EMIT connected();
 }
 
@@ -141,42 +754,168 @@ void Connection::handleDeleted()
     QString key = _handles.key(connection,"");
     if(key != "")
         _handles.remove(key);
+
+    int channel = _channels.indexOf(connection);
+    if(channel >= 0)
+    {
+        _channels[channel] = nullptr;
+
+        // frames for a closing channel may still be on their way
+        if(_closingChannels.key(channel).isEmpty())
+            _freeChannels.append(channel);
+    }
+
+    QMutableHashIterator<QString, VirtualConnection*> aliases(_aliases);
+    while(aliases.hasNext())
+    {
+        if(aliases.next().value() == connection)
+            aliases.remove();
+    }
+
+    QMutableHashIterator<int, VirtualConnection*> channelAliases(_channelAliases);
+    while(channelAliases.hasNext())
+    {
+        if(channelAliases.next().value() == connection)
+            channelAliases.remove();
+    }
+}
+
+void Connection::channelClosed(const QString &uuid)
+{
+    if(!_closingChannels.contains(uuid))
+        return;
+
+    int channel = _closingChannels.take(uuid);
+    if(channel < _channels.count() && !_channels[channel])
+        _freeChannels.append(channel);
+}
+
+void Connection::releaseClosingChannels()
+{
+    // without a connection nothing can arrive for the closed channels anymore
+    QHashIterator<QString, int> it(_closingChannels);
+    while(it.hasNext())
+    {
+        it.next();
+        if(it.value() < _channels.count() && !_channels[it.value()])
+            _freeChannels.append(it.value());
+    }
+    _closingChannels.clear();
 }
 
 void Connection::messageReceived(QByteArray message)
 {
-   QJsonParseError error;
-   QVariantMap msg = QJsonDocument::fromJson(message, &error).toVariant().toMap();
-   if(error.error != QJsonParseError::NoError)
+   Q_EMIT frameReceived(message);
+   _bytesReceived += message.size();
+   _lastReceived = _clock.elapsed();
+
+   if(MessageCodec::isFragment(message))
    {
-       qDebug()<<"Connection: Inavlid Json.";
+       quint32 id;
+       bool last;
+       QByteArray data;
+       if(!MessageCodec::readFragment(message, &id, &last, &data))
+       {
+           qDebug()<<"Connection: Invalid fragment received.";
+           return;
+       }
+
+       _fragments[id].append(data);
+       if(!last)
+           return;
+
+       message = _fragments.take(id);
+   }
+
+   _framesReceived++;
+   if(_decoder)
+   {
+       _decoder->enqueue(message);
        return;
    }
 
-   if(_keepAlive)
+   deployFrame(FrameDecoder::decodeFrame(message));
+}
+
+void Connection::decodedFramesReady()
+{
+    FrameDecoder::Result frame;
+    while(_decoder && _decoder->takeNext(frame))
+    {
+        deployFrame(frame);
+    }
+}
+
+void Connection::deployFrame(const FrameDecoder::Result &frame)
+{
+    if(!frame.ok)
+    {
+        qDebug()<<"Connection: Invalid frame received.";
+        return;
+    }
+
+    _bytesReceivedUncompressed += frame.size;
+    Q_EMIT frameDecoded(frame.size, frame.decodeTime);
+
+    QListIterator<MessageEnvelope> it(frame.envelopes);
+    while(it.hasNext())
+    {
+        deployEnvelope(it.next());
+    }
+}
+
+void Connection::deployEnvelope(const MessageEnvelope &envelope)
+{
+   const QString command = envelope.command();
+   _messagesReceived++;
+   if(command == QStringLiteral("pong"))
    {
-       _timeoutTimer->stop();
-       _keepAliveTimer->start();
-       if(msg["command"] == "pong")
-           return;
+       if(_pingSentAt >= 0)
+           pongReceived(quint64(_clock.elapsed() - _pingSentAt));
+       return;
    }
 
-   if(msg["command"] == "ping")
+   if(command == QStringLiteral("ping"))
    {
        QVariantMap pong;
        pong["command"] = "pong";
        sendVariant(pong);
    }
 
-   QString uuid = msg["uuid"].toString();
-   if(_handles.contains(uuid))
+   if(command == QStringLiteral("connection:negotiate"))
+   {
+       negotiationRequested(envelope.value(QStringLiteral("parameters")).toMap());
+       return;
+   }
+
+   if(command == QStringLiteral("connection:negotiated"))
+   {
+       negotiationFinished(envelope.value(QStringLiteral("parameters")).toMap());
+       return;
+   }
+
+   if(command == QStringLiteral("connection:closed"))
+       channelClosed(envelope.uuid());
+
+   // only the envelope has been read so far. The payload is
+   // materialized by the VirtualConnection which consumes it.
+   VirtualConnection* handle = nullptr;
+   const int channel = envelope.channel();
+   if(_replaying)
+       handle = channel >= 0 ? _channelAliases.value(channel, nullptr) : _aliases.value(envelope.uuid(), _handles.value(envelope.uuid(), nullptr));
+   else if(channel >= 0)
+       handle = _channels.value(channel, nullptr);
+   else
+       handle = _handles.value(envelope.uuid(), nullptr);
+
+   if(handle)
    {
-       _handles.value(uuid)->deployMessage(msg);
+       handle->deployMessage(envelope);
    }
-   else if(msg["command"].toString()=="connection:register")
+   else if(command == QStringLiteral("connection:register"))
    {
-       VirtualConnection* vconnection = new VirtualConnection(uuid, this);
-       vconnection->deployMessage(msg);
+       VirtualConnection* vconnection = new VirtualConnection(envelope.uuid(), this);
+       vconnection->deployMessage(envelope);
        Q_EMIT newVirtualConnection(vconnection);
    }
 }
@@ -204,39 +943,47 @@ void Connection::setKeepAlive(int interval, int timeout)
             _keepAliveTimer = nullptr;
         }
 
-        if(_timeoutTimer)
-        {
-            _timeoutTimer->stop();
-            delete _timeoutTimer;
-            _timeoutTimer = nullptr;
-        }
-
         _keepAlive = false;
         return;
     }
-    else
-    {
-        if (!_keepAliveTimer)
-        {
-            _keepAliveTimer = new QTimer(this);
-            _keepAliveTimer->setSingleShot(true);
-            QObject::connect(_keepAliveTimer, &QTimer::timeout, this, &Connection::sendPing);
-        }
 
-        if(!_timeoutTimer)
-        {
-            _timeoutTimer = new QTimer(this);
-            _timeoutTimer->setSingleShot(true);
-            QObject::connect(_timeoutTimer, &QTimer::timeout, this, &Connection::timeout);
-        }
+    if (!_keepAliveTimer)
+    {
+        _keepAliveTimer = new QTimer(this);
+        QObject::connect(_keepAliveTimer, &QTimer::timeout, this, &Connection::checkAlive);
+    }
 
-        _timeoutTimer->setInterval(_timeout);
-        _keepAliveTimer->setInterval(_pingInterval);
+    // one timer checks the timestamps instead of restarting timers on every frame
+    _keepAliveTimer->setInterval(qMax(50, qMin(interval, timeout) / 2));
+    _lastReceived = _clock.elapsed();
+    _pingSentAt = -1;
+    if(_connected)
         _keepAliveTimer->start();
-        _pingInterval = interval;
-        _timeout = timeout;
-        _keepAlive = true;
+    _keepAlive = true;
+}
+
+void Connection::checkAlive()
+{
+    if(!_connected || _replaying)
+        return;
+
+    qint64 now = _clock.elapsed();
+    if(_pingSentAt >= 0 && now - _pingSentAt > _timeout)
+    {
+        _pingsLost++;
+        _pingSentAt = -1;
+        Q_EMIT latencyChanged();
+    }
+
+    if(now - _lastReceived > qint64(_pingInterval) + _timeout)
+    {
+        timeout();
+        return;
     }
+
+    // as long as frames are coming in, there is no need to ask
+    if(_pingSentAt < 0 && now - _lastReceived >= _pingInterval)
+        sendPing();
 }
 
 void Connection::sendPing()
@@ -244,14 +991,76 @@ void Connection::sendPing()
     if(!_connected)
         return;
 
+    _pingSentAt = _clock.elapsed();
+    _pingsSent++;
+
+#ifndef WEB_ASSEMBLY
+    _socket->ping();
+#else
+    // browsers don't expose websocket ping frames
     QVariantMap ping;
     ping["command"] = "ping";
-    _socket->sendBinaryMessage(QJsonDocument::fromVariant(ping).toJson());
-    _timeoutTimer->start();
+    sendVariant(ping);
+#endif
+}
+
+void Connection::pongReceived(quint64 elapsedTime)
+{
+    _lastReceived = _clock.elapsed();
+    if(_pingSentAt < 0)
+        return;
+
+    _pingSentAt = -1;
+
+    // smoothed like the retransmission timer of TCP (RFC 6298)
+    double sample = double(elapsedTime);
+    if(_srtt < 0)
+    {
+        _srtt = sample;
+        _rttVar = sample / 2;
+    }
+    else
+    {
+        _rttVar = 0.75 * _rttVar + 0.25 * qAbs(_srtt - sample);
+        _srtt = 0.875 * _srtt + 0.125 * sample;
+    }
+
+    Q_EMIT latencyChanged();
+}
+
+void Connection::socketPong(quint64 elapsedTime, const QByteArray &payload)
+{
+    Q_UNUSED(payload)
+    pongReceived(elapsedTime);
+}
+
+double Connection::getRoundTripTime() const
+{
+    return _srtt;
+}
+
+double Connection::getJitter() const
+{
+    return _rttVar;
+}
+
+double Connection::getPacketLoss() const
+{
+    if(_pingsSent == 0)
+        return 0;
+
+    return double(_pingsLost) / double(_pingsSent);
 }
 
 void Connection::timeout()
 {
+    if(_sessionResumption && !_sessionId.isEmpty())
+    {
+        // the socket is dead, suspend the session and try to get it back
+        _socket->abort();
+        return;
+    }
+
     _connected = false;
     qDebug()<<Q_FUNC_INFO<<": Timeout.";
     Q_EMIT disconnected();
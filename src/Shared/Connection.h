@@ -11,6 +11,10 @@
 #include <QObject>
 #include <QWebSocket>
 #include <QTimer>
+#include <QElapsedTimer>
+#include "MessageCodec.h"
+#include "FrameDecoder.h"
+#include "SendQueue.h"
 
 class VirtualConnection;
 class Connection : public QObject
@@ -24,22 +28,202 @@ public:
     void        connect(QString ident);
     void        disconnect();
     void        sendVariant(const QVariant &data);
-    void        addVirtualConnection(VirtualConnection* connection);
+
+    /*!
+        \fn int Connection::addVirtualConnection(VirtualConnection* connection)
+        Registers the virtual connection and returns the channel id under which
+        frames addressed to it are routed.
+    */
+    int         addVirtualConnection(VirtualConnection* connection);
+
+    /*!
+        \fn void Connection::closeChannel(const QString& uuid, int channel)
+        Called when a virtual connection has sent connection:close. The peer may still send
+        frames on the channel, so its id is not handed out again before connection:closed
+        has arrived for uuid or the connection is lost.
+    */
+    void        closeChannel(const QString& uuid, int channel);
+
+    /*!
+        \fn void Connection::setKeepAlive(int interval, int timeout)
+        Sends a websocket ping if nothing has been received for interval milliseconds.
+        The connection is considered dead if nothing arrives within the following timeout
+        milliseconds. The answers of the pings are used to measure the round trip time.
+    */
     void        setKeepAlive(int interval, int timeout = 1000);
     bool        isConnected();
     void        setSocket(QWebSocket* socket);
     QWebSocket* getSocket();
     void        reset();
+    VirtualConnection* getVirtualConnection(const QString& uuid) const;
+
+    /*!
+        \fn void Connection::setReplayMode(bool enabled)
+        Puts the connection into a connected state without any socket. Outgoing frames are
+        only emitted by frameWritten(), incoming frames are fed in with injectFrame().
+        Used by FrameReplayer to run the client against a recording.
+    */
+    void        setReplayMode(bool enabled);
+    bool        isReplaying() const;
+    void        injectFrame(const QByteArray& frame);
+
+    /*!
+        \fn void Connection::addAlias(const QString& uuid, int channel, VirtualConnection* connection)
+        In replay mode, routes frames which are addressed to the uuid or channel of a
+        recorded virtual connection to the given one.
+    */
+    void        addAlias(const QString& uuid, int channel, VirtualConnection* connection);
+
+    /*!
+        \fn void Connection::setPreferredCodec(MessageCodec::Format codec)
+        Sets the wire format this side asks for during the connect handshake.
+        Frames are sent as JSON until the other side has agreed on the codec.
+    */
+    void                    setPreferredCodec(MessageCodec::Format codec);
+    MessageCodec::Format    getPreferredCodec() const;
+    MessageCodec::Format    getCodec() const;
+
+    /*!
+        \fn void Connection::setBatching(bool enabled, int maxBytes, int maxDelay)
+        If enabled and the other side is able to unpack them, outgoing messages are collected
+        and sent as one connection:batch frame. A batch is sent after maxDelay milliseconds
+        (0 means at the end of the current event loop turn) or as soon as it exceeds maxBytes.
+    */
+    void                    setBatching(bool enabled, int maxBytes = 64 * 1024, int maxDelay = 0);
+    bool                    getBatching() const;
+
+    /*!
+        \fn void Connection::setCompression(bool enabled, int threshold)
+        If enabled and the other side agrees, frames of at least threshold bytes are
+        deflated before they are written. Smaller frames like pings and ACKs are
+        always sent as they are.
+    */
+    void                    setCompression(bool enabled, int threshold = 4096);
+    bool                    getCompression() const;
+
+    /*!
+        \fn void Connection::setSendQueueLimits(int highWaterMark, int fragmentSize)
+        Frames are handed to the socket only while less than highWaterMark bytes are waiting
+        to be written. Everything else is kept in the send queue, where control frames overtake
+        interactive commands and both overtake bulk frames. Frames larger than fragmentSize
+        count as bulk data and are fragmented if the other side is able to join the fragments.
+    */
+    void                    setSendQueueLimits(int highWaterMark = 256 * 1024, int fragmentSize = 16 * 1024);
+
+    /*!
+        \fn bool Connection::isCongested() const
+        Returns true while more than the high water mark is queued for sending.
+    */
+    bool                    isCongested() const;
+
+    /*!
+        \fn double Connection::getRoundTripTime() const
+        Returns the smoothed round trip time in milliseconds or -1 if it has not been measured yet.
+        getJitter() returns its mean deviation, getPacketLoss() the share of unanswered pings.
+    */
+    double                  getRoundTripTime() const;
+    double                  getJitter() const;
+    double                  getPacketLoss() const;
+
+    /*!
+        \fn void Connection::setSessionResumption(bool enabled, int window)
+        If enabled and the server supports it, a lost socket suspends the session instead of
+        disconnecting the virtual connections. The connection reconnects on its own for up
+        to window milliseconds. The server then replays what has been missed, and only virtual
+        connections it was not able to resume are registered again.
+    */
+    void                    setSessionResumption(bool enabled, int window = 30000);
+    bool                    getSessionResumption() const;
+    bool                    isSuspended() const;
+
+    /*!
+        \fn void Connection::setDecoderThreads(int threads)
+        Incoming frames are decoded by the given number of worker threads instead of
+        the thread the connection lives in. 0 decodes them synchronously, which is the default.
+        Messages are delivered in order and on the thread of the connection in both cases.
+    */
+    void                    setDecoderThreads(int threads);
+    int                     getDecoderThreads() const;
+
+    /*!
+        \fn QVariantMap Connection::getStatistics() const
+        Returns the frame and message counters of this connection.
+    */
+    QVariantMap             getStatistics() const;
 
 private:
+    void                                writeFrame(QByteArray frame, SendQueue::Lane lane, const QStringList& keys = QStringList());
+    void                                writeQueuedFrames();
+    void                                updateCongestion();
+    void                                suspend();
+    void                                reconnect();
+    void                                endSuspension();
+    void                                finishResume(const QVariantMap& parameters);
+    void                                pongReceived(quint64 elapsedTime);
+    void                                deployFrame(const FrameDecoder::Result& frame);
+    void                                deployEnvelope(const MessageEnvelope& envelope);
+    void                                negotiate();
+    void                                negotiationRequested(const QVariantMap& parameters);
+    void                                negotiationFinished(const QVariantMap& parameters);
+
     QWebSocket*                         _socket = nullptr;
     bool                                _connected;
     QHash<QString, VirtualConnection*>  _handles;
+    QVector<VirtualConnection*>         _channels;
+    QVector<int>                        _freeChannels;
+    QHash<QString, int>                 _closingChannels;
     bool                                _keepAlive = false;
     int                                 _pingInterval;
     int                                 _timeout;
     QTimer*                             _keepAliveTimer = nullptr;
-    QTimer*                             _timeoutTimer =  nullptr;
+    QElapsedTimer                       _clock;
+    qint64                              _lastReceived = 0;
+    qint64                              _pingSentAt = -1;
+    qint64                              _pingsSent = 0;
+    qint64                              _pingsLost = 0;
+    double                              _srtt = -1;
+    double                              _rttVar = 0;
+    MessageCodec::Format                _codec = MessageCodec::FORMAT_JSON;
+    MessageCodec::Format                _preferredCodec = MessageCodec::FORMAT_JSON;
+    bool                                _batching = false;
+    bool                                _peerUnpacksBatches = false;
+    int                                 _batchMaxBytes = 64 * 1024;
+    QTimer*                             _batchTimer = nullptr;
+    QList<QByteArray>                   _outbox;
+    QStringList                         _outboxKeys;
+    int                                 _outboxBytes = 0;
+    qint64                              _messagesSent = 0;
+    qint64                              _framesSent = 0;
+    qint64                              _framesSaved = 0;
+    qint64                              _messagesReceived = 0;
+    qint64                              _framesReceived = 0;
+    bool                                _compression = false;
+    bool                                _compressFrames = false;
+    int                                 _compressionThreshold = 4096;
+    qint64                              _bytesSent = 0;
+    qint64                              _bytesSentUncompressed = 0;
+    qint64                              _bytesReceived = 0;
+    qint64                              _bytesReceivedUncompressed = 0;
+    FrameDecoder*                       _decoder = nullptr;
+    SendQueue                           _sendQueue;
+    qint64                              _bytesInFlight = 0;
+    bool                                _maskFrames = false;
+    int                                 _highWaterMark = 256 * 1024;
+    int                                 _fragmentSize = 16 * 1024;
+    bool                                _congested = false;
+    bool                                _peerJoinsFragments = false;
+    QHash<quint32, QByteArray>          _fragments;
+    QString                             _url;
+    bool                                _sessionResumption = false;
+    int                                 _suspendWindow = 30000;
+    QString                             _sessionId;
+    bool                                _suspended = false;
+    bool                                _resuming = false;
+    QTimer*                             _suspendTimer = nullptr;
+    QTimer*                             _reconnectTimer = nullptr;
+    bool                                _replaying = false;
+    QHash<QString, VirtualConnection*>  _aliases;
+    QHash<int, VirtualConnection*>      _channelAliases;
 
 
 signals:
@@ -47,13 +231,45 @@ signals:
     void disconnected();
     void newVirtualConnection(VirtualConnection* connection);
     void socketError(QAbstractSocket::SocketError error);
+    void codecChanged();
+
+    /*!
+        \fn void Connection::congestionChanged(bool congested)
+        Emitted when the send queue exceeds the high water mark and when it has drained
+        below it again. Senders of bulk data should hold back while congested is true.
+    */
+    void congestionChanged(bool congested);
+    void suspendedChanged();
+    void latencyChanged();
+
+    /*!
+        \fn void Connection::frameDecoded(int size, qint64 decodeTime)
+        Emitted for every incoming frame with its uncompressed size and the time in
+        nanoseconds it took to decode it.
+    */
+    void frameDecoded(int size, qint64 decodeTime);
+
+    /*!
+        \fn void Connection::frameReceived(const QByteArray& frame)
+        Emitted for every frame as it arrives from the socket, before it is processed.
+        frameWritten() is emitted for every frame handed to the socket.
+    */
+    void frameReceived(const QByteArray& frame);
+    void frameWritten(const QByteArray& frame);
 
 private slots:
+    void flushBatch();
+    void decodedFramesReady();
+    void socketBytesWritten(qint64 bytes);
     void timeout();
     void sendPing();
+    void checkAlive();
+    void socketPong(quint64 elapsedTime, const QByteArray& payload);
     void socketDisconnected();
     void socketConnected();
     void handleDeleted();
+    void channelClosed(const QString& uuid);
+    void releaseClosingChannels();
     void messageReceived(QByteArray message);
  //   void messageReceived(QVariantMap msg);
     void errorSlot(QAbstractSocket::SocketError error);
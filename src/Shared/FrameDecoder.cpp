@@ -0,0 +1,169 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * It is part of the QuickHub framework - www.quickhub.org
+ * Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de */
+
+
+#include "FrameDecoder.h"
+#include <QRunnable>
+#include <QMutexLocker>
+#include <QElapsedTimer>
+
+class DecodeTask : public QRunnable
+{
+public:
+    DecodeTask(FrameDecoder* decoder, quint64 sequence, const QByteArray& frame) :
+        _decoder(decoder),
+        _sequence(sequence),
+        _frame(frame)
+    {
+    }
+
+    void run() override
+    {
+        _decoder->finished(_sequence, FrameDecoder::decodeFrame(_frame, true));
+    }
+
+private:
+    FrameDecoder*   _decoder;
+    quint64         _sequence;
+    QByteArray      _frame;
+};
+
+namespace
+{
+    void unpack(const MessageEnvelope& envelope, QList<MessageEnvelope>& envelopes, bool materialize)
+    {
+        if(envelope.command() == QStringLiteral("connection:batch"))
+        {
+            QListIterator<MessageEnvelope> it(envelope.unpackBatch());
+            while(it.hasNext())
+            {
+                unpack(it.next(), envelopes, materialize);
+            }
+            return;
+        }
+
+        // the parsed payload is cached inside the envelope and travels with it
+        if(materialize)
+            envelope.payload();
+
+        envelopes.append(envelope);
+    }
+}
+
+FrameDecoder::FrameDecoder(int threads, QObject *parent) : QObject(parent)
+{
+    _pool.setMaxThreadCount(threads);
+}
+
+FrameDecoder::~FrameDecoder()
+{
+    _pool.clear();
+    _pool.waitForDone();
+}
+
+void FrameDecoder::enqueue(const QByteArray &frame)
+{
+    quint64 sequence;
+    {
+        QMutexLocker locker(&_mutex);
+        sequence = _nextSequence++;
+    }
+    _pool.start(new DecodeTask(this, sequence, frame));
+}
+
+bool FrameDecoder::takeNext(Result &result)
+{
+    QMutexLocker locker(&_mutex);
+    auto it = _results.find(_nextDelivery);
+    if(it == _results.end())
+        return false;
+
+    result = it.value();
+    _results.erase(it);
+    _nextDelivery++;
+    return true;
+}
+
+int FrameDecoder::pending()
+{
+    QMutexLocker locker(&_mutex);
+    return int(_nextSequence - _nextDelivery);
+}
+
+void FrameDecoder::setThreadCount(int threads)
+{
+    _pool.setMaxThreadCount(threads);
+}
+
+int FrameDecoder::getThreadCount() const
+{
+    return _pool.maxThreadCount();
+}
+
+void FrameDecoder::waitForDone()
+{
+    _pool.waitForDone();
+}
+
+void FrameDecoder::clear()
+{
+    _pool.clear();
+
+    // results of tasks which are still running are dropped in finished()
+    QMutexLocker locker(&_mutex);
+    _results.clear();
+    _nextDelivery = _nextSequence;
+}
+
+FrameDecoder::Result FrameDecoder::decodeFrame(const QByteArray &frame, bool materialize)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    Result result;
+    result.size = frame.size();
+
+    QByteArray data = frame;
+    if(MessageCodec::isCompressed(data))
+    {
+        data = MessageCodec::decompress(frame, &result.ok);
+        if(!result.ok)
+            return result;
+
+        result.size = data.size();
+    }
+
+    MessageEnvelope envelope = MessageCodec::decodeEnvelope(data, &result.ok);
+    if(!result.ok)
+        return result;
+
+    unpack(envelope, result.envelopes, materialize);
+    result.decodeTime = timer.nsecsElapsed();
+    return result;
+}
+
+void FrameDecoder::finished(quint64 sequence, const Result &result)
+{
+    QMutexLocker locker(&_mutex);
+    if(sequence < _nextDelivery)
+        return;
+
+    _results.insert(sequence, result);
+    if(sequence != _nextDelivery || _notifyPending)
+        return;
+
+    _notifyPending = true;
+    QMetaObject::invokeMethod(this, "notifyReady", Qt::QueuedConnection);
+}
+
+void FrameDecoder::notifyReady()
+{
+    {
+        QMutexLocker locker(&_mutex);
+        _notifyPending = false;
+    }
+    Q_EMIT ready();
+}
@@ -0,0 +1,82 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * It is part of the QuickHub framework - www.quickhub.org
+ * Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de */
+
+
+#ifndef FRAMEDECODER_H
+#define FRAMEDECODER_H
+
+#include <QObject>
+#include <QMap>
+#include <QMutex>
+#include <QThreadPool>
+#include "MessageCodec.h"
+
+/*!
+    \class FrameDecoder
+    \brief Decodes incoming frames on a small thread pool.
+
+    Inflating, parsing and materializing the payloads of large frames is done by
+    worker threads, so that a big dump does not block the GUI thread. Frames may be
+    decoded in parallel, but they are handed out strictly in the order in which they
+    have been received. ready() is emitted on the thread the decoder lives in as soon
+    as the next frame can be taken.
+*/
+
+class FrameDecoder : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Result
+    {
+        bool                    ok = false;
+        int                     size = 0;
+        qint64                  decodeTime = 0;
+        QList<MessageEnvelope>  envelopes;
+    };
+
+    explicit    FrameDecoder(int threads, QObject *parent = nullptr);
+                ~FrameDecoder();
+
+    void        enqueue(const QByteArray& frame);
+    bool        takeNext(Result& result);
+    int         pending();
+    void        setThreadCount(int threads);
+    int         getThreadCount() const;
+    void        waitForDone();
+
+    /*!
+        \fn void FrameDecoder::clear()
+        Drops all frames which are still queued or in progress.
+    */
+    void        clear();
+
+    /*!
+        \fn FrameDecoder::Result FrameDecoder::decodeFrame(const QByteArray& frame, bool materialize)
+        Inflates and decodes a single frame and unpacks batches. If materialize is true,
+        the payloads are parsed as well, so the consumer gets them without any further work.
+    */
+    static Result decodeFrame(const QByteArray& frame, bool materialize = false);
+
+signals:
+    void        ready();
+
+private:
+    friend class DecodeTask;
+    void        finished(quint64 sequence, const Result& result);
+
+    QThreadPool             _pool;
+    QMutex                  _mutex;
+    QMap<quint64, Result>   _results;
+    quint64                 _nextSequence = 0;
+    quint64                 _nextDelivery = 0;
+    bool                    _notifyPending = false;
+
+private slots:
+    void        notifyReady();
+};
+
+#endif // FRAMEDECODER_H
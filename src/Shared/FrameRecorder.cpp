@@ -0,0 +1,84 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * It is part of the QuickHub framework - www.quickhub.org
+ * Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de */
+
+
+#include "FrameRecorder.h"
+#include "Connection.h"
+#include <QDebug>
+
+FrameRecorder::FrameRecorder(QObject *parent) : QObject(parent)
+{
+}
+
+FrameRecorder::~FrameRecorder()
+{
+    stop();
+}
+
+bool FrameRecorder::start(Connection *connection, const QString &path)
+{
+    stop();
+
+    _file.setFileName(path);
+    if(!_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qWarning()<<Q_FUNC_INFO<<": Unable to open "<<path;
+        return false;
+    }
+
+    _stream.setDevice(&_file);
+    _stream.setVersion(QDataStream::Qt_5_12);
+    _stream << MAGIC << VERSION;
+
+    _connection = connection;
+    _frames = 0;
+    _clock.start();
+    connect(connection, &Connection::frameReceived, this, &FrameRecorder::inboundFrame);
+    connect(connection, &Connection::frameWritten, this, &FrameRecorder::outboundFrame);
+    return true;
+}
+
+void FrameRecorder::stop()
+{
+    if(_connection)
+        QObject::disconnect(_connection, nullptr, this, nullptr);
+
+    _connection = nullptr;
+    if(_file.isOpen())
+    {
+        _stream.setDevice(nullptr);
+        _file.close();
+    }
+}
+
+bool FrameRecorder::isRecording() const
+{
+    return _file.isOpen();
+}
+
+qint64 FrameRecorder::framesRecorded() const
+{
+    return _frames;
+}
+
+void FrameRecorder::record(Direction direction, const QByteArray &frame)
+{
+    if(!_file.isOpen())
+        return;
+
+    _stream << quint8(direction) << qint64(_clock.nsecsElapsed() / 1000) << frame;
+    _frames++;
+}
+
+void FrameRecorder::inboundFrame(const QByteArray &frame)
+{
+    record(INBOUND, frame);
+}
+
+void FrameRecorder::outboundFrame(const QByteArray &frame)
+{
+    record(OUTBOUND, frame);
+}
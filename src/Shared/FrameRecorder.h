@@ -0,0 +1,64 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * It is part of the QuickHub framework - www.quickhub.org
+ * Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de */
+
+
+#ifndef FRAMERECORDER_H
+#define FRAMERECORDER_H
+
+#include <QObject>
+#include <QFile>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QPointer>
+
+class Connection;
+
+/*!
+    \class FrameRecorder
+    \brief Writes the frames of a Connection to a file.
+
+    Every frame is stored as it was on the wire, together with its direction and the
+    time in microseconds since the recording has been started. The file starts with the
+    magic "QHRC" and a format version. FrameReplayer plays such a file back.
+*/
+
+class FrameRecorder : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Direction
+    {
+        INBOUND = 0,
+        OUTBOUND = 1
+    };
+
+    static const quint32 MAGIC = 0x51485243;
+    static const quint32 VERSION = 1;
+
+    explicit    FrameRecorder(QObject *parent = nullptr);
+                ~FrameRecorder();
+
+    bool        start(Connection* connection, const QString& path);
+    void        stop();
+    bool        isRecording() const;
+    qint64      framesRecorded() const;
+
+private:
+    void        record(Direction direction, const QByteArray& frame);
+
+    QPointer<Connection>    _connection;
+    QFile                   _file;
+    QDataStream             _stream;
+    QElapsedTimer           _clock;
+    qint64                  _frames = 0;
+
+private slots:
+    void        inboundFrame(const QByteArray& frame);
+    void        outboundFrame(const QByteArray& frame);
+};
+
+#endif // FRAMERECORDER_H
@@ -0,0 +1,305 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * It is part of the QuickHub framework - www.quickhub.org
+ * Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de */
+
+
+#include "FrameReplayer.h"
+#include "FrameRecorder.h"
+#include "FrameDecoder.h"
+#include "Connection.h"
+#include "VirtualConnection.h"
+#include <QFile>
+#include <QDataStream>
+#include <QDebug>
+
+namespace
+{
+    QString attachKey(const MessageEnvelope& envelope)
+    {
+        if(envelope.command() != QStringLiteral("send"))
+            return QString();
+
+        QVariantMap payload = envelope.payload().toMap();
+        QString command = payload.value(QStringLiteral("command")).toString();
+        if(!command.endsWith(QStringLiteral(":attach")))
+            return QString();
+
+        return command + "/" + payload.value(QStringLiteral("payload")).toMap().value(QStringLiteral("descriptor")).toString();
+    }
+}
+
+FrameReplayer::FrameReplayer(QObject *parent) : QObject(parent)
+{
+    _timer.setSingleShot(true);
+    connect(&_timer, &QTimer::timeout, this, &FrameReplayer::replayNext);
+}
+
+bool FrameReplayer::load(const QString &path)
+{
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        qWarning()<<Q_FUNC_INFO<<": Unable to open "<<path;
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+
+    quint32 magic, version;
+    stream >> magic >> version;
+    if(magic != FrameRecorder::MAGIC || version != FrameRecorder::VERSION)
+    {
+        qWarning()<<Q_FUNC_INFO<<": "<<path<<" is not a frame recording.";
+        return false;
+    }
+
+    _frames.clear();
+    _fragments.clear();
+    _recordedChannels.clear();
+    _recordedRegistrations.clear();
+    _recordedAttaches.clear();
+
+    while(!stream.atEnd())
+    {
+        quint8 direction;
+        qint64 time;
+        QByteArray data;
+        stream >> direction >> time >> data;
+        if(stream.status() != QDataStream::Ok)
+            break;
+
+        if(direction == FrameRecorder::OUTBOUND)
+        {
+            scan(data, false);
+            continue;
+        }
+
+        Frame frame;
+        frame.time = time;
+        frame.data = data;
+        _frames.append(frame);
+    }
+
+    // the routing target of every inbound frame is resolved up front. Leading
+    // fragments share the target of the last fragment of their frame.
+    _fragments.clear();
+    QHash<quint32, QVector<int>> fragments;
+    for(int i = 0; i < _frames.count(); i++)
+    {
+        QString target = scan(_frames[i].data, true);
+        quint32 id;
+        bool last;
+        QByteArray chunk;
+        if(!MessageCodec::isFragment(_frames[i].data) || !MessageCodec::readFragment(_frames[i].data, &id, &last, &chunk))
+        {
+            _frames[i].target = target;
+            continue;
+        }
+
+        fragments[id].append(i);
+        if(!last)
+            continue;
+
+        for(int index : fragments.take(id))
+        {
+            _frames[index].target = target;
+        }
+    }
+
+    return true;
+}
+
+QString FrameReplayer::scan(const QByteArray &data, bool inbound)
+{
+    QByteArray frame = data;
+    if(MessageCodec::isFragment(frame))
+    {
+        quint32 id;
+        bool last;
+        QByteArray chunk;
+        if(!MessageCodec::readFragment(frame, &id, &last, &chunk))
+            return QString();
+
+        _fragments[id].append(chunk);
+        if(!last)
+            return QString();
+
+        frame = _fragments.take(id);
+    }
+
+    FrameDecoder::Result result = FrameDecoder::decodeFrame(frame);
+    QString target;
+    QListIterator<MessageEnvelope> it(result.envelopes);
+    while(it.hasNext())
+    {
+        const MessageEnvelope& envelope = it.next();
+        const QString command = envelope.command();
+
+        if(!inbound)
+        {
+            if(command == QStringLiteral("connection:register"))
+            {
+                _recordedRegistrations << envelope.uuid();
+                bool ok;
+                int channel = envelope.value(QStringLiteral("channel")).toInt(&ok);
+                if(ok)
+                    _recordedChannels[channel] = envelope.uuid();
+            }
+
+            QString key = attachKey(envelope);
+            if(!key.isEmpty())
+                _recordedAttaches[key] << envelope.uuid();
+            continue;
+        }
+
+        // the handshake is answered by the replayer itself
+        if(command.startsWith(QStringLiteral("connection:")))
+            continue;
+
+        QString uuid = envelope.channel() >= 0 ? _recordedChannels.value(envelope.channel()) : envelope.uuid();
+        // a batch for several virtual connections is injected unmapped
+        if(target.isNull())
+            target = uuid;
+        else if(target != uuid)
+            target = QStringLiteral("");
+    }
+
+    return target;
+}
+
+void FrameReplayer::start(Connection *connection, double speed)
+{
+    stop();
+
+    _connection = connection;
+    _speed = speed;
+    _next = 0;
+    _replayed = 0;
+    _liveRegistrations = 0;
+    _aliases.clear();
+    _pending.clear();
+
+    connect(connection, &Connection::frameWritten, this, &FrameReplayer::frameWritten);
+    connection->setReplayMode(true);
+
+    _clock.start();
+    scheduleNext();
+}
+
+void FrameReplayer::stop()
+{
+    _timer.stop();
+    if(!_connection)
+        return;
+
+    QObject::disconnect(_connection, nullptr, this, nullptr);
+    _connection->setReplayMode(false);
+    _connection = nullptr;
+}
+
+bool FrameReplayer::isRunning() const
+{
+    return _connection && _next < _frames.count();
+}
+
+int FrameReplayer::framesTotal() const
+{
+    return _frames.count();
+}
+
+int FrameReplayer::framesReplayed() const
+{
+    return _replayed;
+}
+
+void FrameReplayer::scheduleNext()
+{
+    if(_next >= _frames.count())
+    {
+        Q_EMIT finished();
+        return;
+    }
+
+    qint64 delay = 0;
+    if(_speed > 0)
+        delay = qMax(Q_INT64_C(0), qint64(_frames.at(_next).time / 1000 / _speed) - _clock.elapsed());
+
+    _timer.start(int(delay));
+}
+
+void FrameReplayer::replayNext()
+{
+    if(!_connection)
+        return;
+
+    const Frame& frame = _frames.at(_next++);
+    if(!frame.target.isEmpty() && !_aliases.contains(frame.target))
+        _pending[frame.target].append(frame);
+    else
+        inject(frame);
+
+    scheduleNext();
+}
+
+void FrameReplayer::inject(const Frame &frame)
+{
+    _replayed++;
+    _connection->injectFrame(frame.data);
+}
+
+void FrameReplayer::frameWritten(const QByteArray &frame)
+{
+    FrameDecoder::Result result = FrameDecoder::decodeFrame(frame);
+    QListIterator<MessageEnvelope> it(result.envelopes);
+    while(it.hasNext())
+    {
+        const MessageEnvelope& envelope = it.next();
+        if(envelope.command() == QStringLiteral("connection:register"))
+        {
+            QString live = envelope.uuid();
+            if(_liveRegistrations < _recordedRegistrations.count())
+            {
+                QString recorded = _recordedRegistrations.at(_liveRegistrations);
+                if(!_aliases.contains(recorded))
+                    alias(recorded, live);
+            }
+            _liveRegistrations++;
+
+            // answer the registration like the server would have done
+            QVariantMap msg;
+            msg["command"] = "connection:registered";
+            msg["uuid"] = live;
+            QByteArray answer = MessageCodec::encode(msg, MessageCodec::FORMAT_JSON);
+            QTimer::singleShot(0, this, [=](){
+                if(_connection)
+                    _connection->injectFrame(answer);
+            });
+            continue;
+        }
+
+        QString key = attachKey(envelope);
+        if(key.isEmpty() || _recordedAttaches.value(key).isEmpty())
+            continue;
+
+        alias(_recordedAttaches[key].takeFirst(), envelope.uuid());
+    }
+}
+
+void FrameReplayer::alias(const QString &recorded, const QString &live)
+{
+    VirtualConnection* connection = _connection->getVirtualConnection(live);
+    if(!connection)
+        return;
+
+    _aliases[recorded] = live;
+    _connection->addAlias(recorded, _recordedChannels.key(recorded, -1), connection);
+
+    QVector<Frame> pending = _pending.take(recorded);
+    for(const Frame& frame : pending)
+    {
+        inject(frame);
+    }
+}
@@ -0,0 +1,89 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * It is part of the QuickHub framework - www.quickhub.org
+ * Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de */
+
+
+#ifndef FRAMEREPLAYER_H
+#define FRAMEREPLAYER_H
+
+#include <QObject>
+#include <QVector>
+#include <QHash>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QTimer>
+
+class Connection;
+
+/*!
+    \class FrameReplayer
+    \brief Plays a recording of FrameRecorder back into a Connection without any socket.
+
+    The connection is put into replay mode, so all virtual connections and models
+    behave like they were connected to a server. The recorded inbound frames are fed into
+    the connection with their original timing, scaled by the speed factor. A speed of 0
+    replays them as fast as possible.
+
+    The virtual connections of the live client have other uuids than the recorded ones.
+    A recorded virtual connection is mapped to the live virtual connection which attaches
+    the same resource. Virtual connections without an attach are mapped in the order
+    of their registration. Frames for a recorded virtual connection which has not been
+    mapped yet are held back until it is, so every model receives its frames in order,
+    regardless of when it is created.
+*/
+
+class FrameReplayer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit    FrameReplayer(QObject *parent = nullptr);
+
+    bool        load(const QString& path);
+    void        start(Connection* connection, double speed = 1.0);
+    void        stop();
+    bool        isRunning() const;
+    int         framesTotal() const;
+    int         framesReplayed() const;
+
+signals:
+    void        finished();
+
+private:
+    struct Frame
+    {
+        qint64      time;
+        QByteArray  data;
+        QString     target;
+    };
+
+    QString     scan(const QByteArray& frame, bool inbound);
+    void        alias(const QString& recorded, const QString& live);
+    void        inject(const Frame& frame);
+    void        scheduleNext();
+
+    QPointer<Connection>            _connection;
+    QVector<Frame>                  _frames;
+    int                             _next = 0;
+    int                             _replayed = 0;
+    double                          _speed = 1.0;
+    QElapsedTimer                   _clock;
+    QTimer                          _timer;
+
+    QHash<quint32, QByteArray>      _fragments;
+    QHash<int, QString>             _recordedChannels;
+    QStringList                     _recordedRegistrations;
+    QHash<QString, QStringList>     _recordedAttaches;
+    QHash<QString, QString>         _aliases;
+    int                             _liveRegistrations = 0;
+    QHash<QString, QVector<Frame>>  _pending;
+
+private slots:
+    void        replayNext();
+    void        frameWritten(const QByteArray& frame);
+};
+
+#endif // FRAMEREPLAYER_H
@@ -0,0 +1,592 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * It is part of the QuickHub framework - www.quickhub.org
+ * Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de */
+
+
+#include "MessageCodec.h"
+#include <QCborMap>
+#include <QCborArray>
+#include <QCborStreamReader>
+#include <QJsonDocument>
+#include <QJsonValue>
+#include <QJsonArray>
+
+namespace
+{
+    void appendCborHeader(QByteArray& out, quint8 majorType, quint64 length)
+    {
+        const char major = char(majorType << 5);
+        if(length < 24)
+        {
+            out.append(char(major | char(length)));
+            return;
+        }
+
+        int bytes;
+        if(length <= 0xff)
+        {
+            out.append(char(major | 24));
+            bytes = 1;
+        }
+        else if(length <= 0xffff)
+        {
+            out.append(char(major | 25));
+            bytes = 2;
+        }
+        else if(length <= 0xffffffffULL)
+        {
+            out.append(char(major | 26));
+            bytes = 4;
+        }
+        else
+        {
+            out.append(char(major | 27));
+            bytes = 8;
+        }
+
+        for(int i = bytes - 1; i >= 0; i--)
+        {
+            out.append(char((length >> (8 * i)) & 0xff));
+        }
+    }
+
+    void appendCborText(QByteArray& out, const QByteArray& utf8)
+    {
+        appendCborHeader(out, 3, quint64(utf8.size()));
+        out.append(utf8);
+    }
+
+    QString readCborString(QCborStreamReader& reader)
+    {
+        if(!reader.isString())
+        {
+            reader.next();
+            return QString();
+        }
+
+        QString result;
+        auto chunk = reader.readString();
+        while(chunk.status == QCborStreamReader::Ok)
+        {
+            result += chunk.data;
+            chunk = reader.readString();
+        }
+        return result;
+    }
+}
+
+QByteArray MessageCodec::encode(const QVariantMap &message, Format format)
+{
+    if(format == FORMAT_CBOR)
+        return QCborValue::fromVariant(message).toCbor();
+
+    return QJsonDocument::fromVariant(message).toJson(QJsonDocument::Compact);
+}
+
+QVariantMap MessageCodec::decode(const QByteArray &frame, bool *ok)
+{
+    if(detectFormat(frame) == FORMAT_CBOR)
+    {
+        QCborParserError error;
+        QCborValue value = QCborValue::fromCbor(frame, &error);
+        if(ok)
+            *ok = error.error == QCborError::NoError && value.isMap();
+
+        return cborToVariant(value).toMap();
+    }
+
+    QJsonParseError error;
+    QVariantMap msg = QJsonDocument::fromJson(frame, &error).toVariant().toMap();
+    if(ok)
+        *ok = error.error == QJsonParseError::NoError;
+
+    return msg;
+}
+
+MessageEnvelope MessageCodec::decodeEnvelope(const QByteArray &frame, bool *ok)
+{
+    MessageEnvelope envelope;
+
+    if(detectFormat(frame) == FORMAT_JSON)
+    {
+        QJsonParseError error;
+        QJsonDocument document = QJsonDocument::fromJson(frame, &error);
+        if(ok)
+            *ok = error.error == QJsonParseError::NoError;
+
+        envelope = envelopeFromJson(document.object());
+        envelope._frameSize = frame.size();
+        return envelope;
+    }
+
+    envelope._backend = MessageEnvelope::BACKEND_CBOR;
+    envelope._cbor = frame;
+    envelope._frameSize = frame.size();
+
+    QCborStreamReader reader(frame);
+    if(!reader.isMap())
+    {
+        if(ok)
+            *ok = false;
+        return envelope;
+    }
+
+    reader.enterContainer();
+    while(reader.lastError() == QCborError::NoError && reader.hasNext())
+    {
+        QString key = readCborString(reader);
+        if(key == QStringLiteral("uuid"))
+        {
+            envelope._uuid = readCborString(reader);
+        }
+        else if(key == QStringLiteral("command"))
+        {
+            envelope._command = readCborString(reader);
+        }
+        else if(key == QStringLiteral("msguid"))
+        {
+            envelope._msguid = readCborString(reader);
+        }
+        else if(key == QStringLiteral("ch") && reader.isUnsignedInteger())
+        {
+            envelope._channel = int(reader.toUnsignedInteger());
+            reader.next();
+        }
+        else if(key == QStringLiteral("seq") && reader.isUnsignedInteger())
+        {
+            envelope._sequence = qint64(reader.toUnsignedInteger());
+            reader.next();
+        }
+        else
+        {
+            // remember where the value lives and skip it without parsing
+            MessageEnvelope::Field field;
+            field.key = key;
+            field.begin = int(reader.currentOffset());
+            reader.next();
+            field.end = int(reader.currentOffset());
+            envelope._fields.append(field);
+        }
+    }
+
+    if(reader.lastError() == QCborError::NoError)
+        reader.leaveContainer();
+
+    if(ok)
+        *ok = reader.lastError() == QCborError::NoError;
+
+    return envelope;
+}
+
+MessageEnvelope MessageCodec::envelopeFromJson(const QJsonObject &object)
+{
+    MessageEnvelope envelope;
+    envelope._backend = MessageEnvelope::BACKEND_JSON;
+    envelope._json = object;
+    envelope._uuid = object.value(QStringLiteral("uuid")).toString();
+    envelope._command = object.value(QStringLiteral("command")).toString();
+    envelope._msguid = object.value(QStringLiteral("msguid")).toString();
+    envelope._channel = object.value(QStringLiteral("ch")).toInt(-1);
+    envelope._sequence = qint64(object.value(QStringLiteral("seq")).toDouble(-1));
+    return envelope;
+}
+
+QByteArray MessageCodec::encodeBatch(const QList<QByteArray> &frames, Format format)
+{
+    int size = 64;
+    for(const QByteArray& frame : frames)
+    {
+        size += frame.size() + 1;
+    }
+
+    QByteArray batch;
+    batch.reserve(size);
+
+    if(format == FORMAT_CBOR)
+    {
+        appendCborHeader(batch, 5, 2);
+        appendCborText(batch, QByteArrayLiteral("command"));
+        appendCborText(batch, QByteArrayLiteral("connection:batch"));
+        appendCborText(batch, QByteArrayLiteral("messages"));
+        appendCborHeader(batch, 4, quint64(frames.count()));
+        for(const QByteArray& frame : frames)
+        {
+            batch.append(frame);
+        }
+        return batch;
+    }
+
+    batch.append("{\"command\":\"connection:batch\",\"messages\":[");
+    for(int i = 0; i < frames.count(); i++)
+    {
+        if(i > 0)
+            batch.append(',');
+        batch.append(frames.at(i));
+    }
+    batch.append("]}");
+    return batch;
+}
+
+QByteArray MessageCodec::compress(const QByteArray &frame, int level)
+{
+    QByteArray compressed(1, '\0');
+    compressed.append(qCompress(frame, level));
+    return compressed;
+}
+
+QByteArray MessageCodec::decompress(const QByteArray &frame, bool *ok)
+{
+    QByteArray data = qUncompress(reinterpret_cast<const uchar*>(frame.constData()) + 1, frame.size() - 1);
+    if(ok)
+        *ok = !data.isEmpty();
+
+    return data;
+}
+
+bool MessageCodec::isCompressed(const QByteArray &frame)
+{
+    return !frame.isEmpty() && frame.at(0) == '\0';
+}
+
+QList<QByteArray> MessageCodec::fragment(const QByteArray &frame, quint32 id, int size)
+{
+    QList<QByteArray> fragments;
+    for(int offset = 0; offset < frame.size(); offset += size)
+    {
+        fragments.append(fragment(frame, id, offset, size));
+    }
+    return fragments;
+}
+
+QByteArray MessageCodec::fragment(const QByteArray &frame, quint32 id, int offset, int size)
+{
+    int length = qMin(size, frame.size() - offset);
+    QByteArray fragment;
+    fragment.reserve(length + 6);
+    fragment.append('\x01');
+    for(int i = 3; i >= 0; i--)
+    {
+        fragment.append(char((id >> (8 * i)) & 0xff));
+    }
+    fragment.append(offset + length >= frame.size() ? '\x01' : '\x00');
+    fragment.append(frame.constData() + offset, length);
+    return fragment;
+}
+
+bool MessageCodec::isFragment(const QByteArray &frame)
+{
+    return !frame.isEmpty() && frame.at(0) == '\x01';
+}
+
+bool MessageCodec::readFragment(const QByteArray &fragment, quint32 *id, bool *last, QByteArray *data)
+{
+    if(fragment.size() < 6 || !isFragment(fragment))
+        return false;
+
+    quint32 value = 0;
+    for(int i = 1; i <= 4; i++)
+    {
+        value = (value << 8) | quint8(fragment.at(i));
+    }
+
+    *id = value;
+    *last = fragment.at(5) != '\x00';
+    *data = fragment.mid(6);
+    return true;
+}
+
+MessageCodec::Format MessageCodec::detectFormat(const QByteArray &frame)
+{
+    if(frame.isEmpty())
+        return FORMAT_JSON;
+
+    switch (frame.at(0))
+    {
+        case '{':
+        case '[':
+        case ' ':
+        case '\t':
+        case '\r':
+        case '\n':
+            return FORMAT_JSON;
+        default:
+            return FORMAT_CBOR;
+    }
+}
+
+QString MessageCodec::formatName(Format format)
+{
+    if(format == FORMAT_CBOR)
+        return QStringLiteral("cbor");
+
+    return QStringLiteral("json");
+}
+
+MessageCodec::Format MessageCodec::formatFromName(const QString &name, Format fallback)
+{
+    if(name == QStringLiteral("cbor"))
+        return FORMAT_CBOR;
+
+    if(name == QStringLiteral("json"))
+        return FORMAT_JSON;
+
+    return fallback;
+}
+
+QVariant MessageCodec::cborToVariant(const QCborValue &value)
+{
+    switch (value.type())
+    {
+        case QCborValue::Map:
+        {
+            QVariantMap map;
+            const QCborMap cborMap = value.toMap();
+            for(auto it = cborMap.constBegin(); it != cborMap.constEnd(); ++it)
+            {
+                QCborValue key = it.key();
+                map.insert(key.isString() ? key.toString() : key.toDiagnosticNotation(), cborToVariant(it.value()));
+            }
+            return map;
+        }
+
+        case QCborValue::Array:
+        {
+            QVariantList list;
+            const QCborArray cborArray = value.toArray();
+            list.reserve(int(cborArray.size()));
+            for(qsizetype i = 0; i < cborArray.size(); i++)
+            {
+                list.append(cborToVariant(cborArray.at(i)));
+            }
+            return list;
+        }
+
+        case QCborValue::String:
+            return value.toString();
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+        // JSON knows only one number type
+        case QCborValue::Integer:
+        case QCborValue::Double:
+            return value.toDouble();
+#else
+        // Qt6 hands out integral JSON numbers as qlonglong
+        case QCborValue::Integer:
+            return value.toInteger();
+
+        case QCborValue::Double:
+        {
+            // a JSON writer drops the fraction of integral doubles
+            const double number = value.toDouble();
+            if(qAbs(number) < 9007199254740992.0 && double(qint64(number)) == number)
+                return qint64(number);
+            return number;
+        }
+#endif
+
+        case QCborValue::True:
+            return true;
+
+        case QCborValue::False:
+            return false;
+
+        // invalid QVariants are written as undefined, JSON turns them into null
+        case QCborValue::Null:
+        case QCborValue::Undefined:
+            return QVariant::fromValue(nullptr);
+
+        default:
+            // tags, byte arrays, urls, ... end up as strings in JSON.
+            return value.toJsonValue().toVariant();
+    }
+}
+
+
+MessageEnvelope::MessageEnvelope()
+{
+}
+
+MessageEnvelope::MessageEnvelope(const QVariantMap &message) :
+    _backend(BACKEND_VARIANT),
+    _uuid(message.value(QStringLiteral("uuid")).toString()),
+    _command(message.value(QStringLiteral("command")).toString()),
+    _msguid(message.value(QStringLiteral("msguid")).toString()),
+    _channel(message.value(QStringLiteral("ch"), -1).toInt()),
+    _sequence(message.value(QStringLiteral("seq"), -1).toLongLong()),
+    _map(message)
+{
+}
+
+QString MessageEnvelope::uuid() const
+{
+    return _uuid;
+}
+
+QString MessageEnvelope::command() const
+{
+    return _command;
+}
+
+QString MessageEnvelope::msguid() const
+{
+    return _msguid;
+}
+
+int MessageEnvelope::channel() const
+{
+    return _channel;
+}
+
+qint64 MessageEnvelope::sequence() const
+{
+    return _sequence;
+}
+
+int MessageEnvelope::frameSize() const
+{
+    return _frameSize;
+}
+
+QVariant MessageEnvelope::payload() const
+{
+    if(!_payloadMaterialized)
+    {
+        _payload = value(QStringLiteral("payload"));
+        _payloadMaterialized = true;
+    }
+
+    return _payload;
+}
+
+QVariant MessageEnvelope::value(const QString &key) const
+{
+    switch (_backend)
+    {
+        case BACKEND_VARIANT:
+            return _map.value(key);
+
+        case BACKEND_JSON:
+        {
+            QJsonValue value = _json.value(key);
+            if(value.isUndefined())
+                return QVariant();
+
+            return value.toVariant();
+        }
+
+        case BACKEND_CBOR:
+        {
+            for(const Field& field : _fields)
+            {
+                if(field.key != key)
+                    continue;
+
+                QByteArray raw = QByteArray::fromRawData(_cbor.constData() + field.begin, field.end - field.begin);
+                return MessageCodec::cborToVariant(QCborValue::fromCbor(raw));
+            }
+
+            // the routing fields have been taken out of _fields by decodeEnvelope()
+            if(key == QStringLiteral("uuid") && !_uuid.isEmpty())
+                return _uuid;
+
+            if(key == QStringLiteral("command") && !_command.isEmpty())
+                return _command;
+
+            if(key == QStringLiteral("msguid") && !_msguid.isEmpty())
+                return _msguid;
+
+            // hand out numbers with the same type the other backends use
+            if(key == QStringLiteral("ch") && _channel >= 0)
+                return MessageCodec::cborToVariant(QCborValue(qint64(_channel)));
+
+            if(key == QStringLiteral("seq") && _sequence >= 0)
+                return MessageCodec::cborToVariant(QCborValue(_sequence));
+
+            return QVariant();
+        }
+    }
+
+    return QVariant();
+}
+
+QVariantMap MessageEnvelope::toMap() const
+{
+    if(_backend == BACKEND_VARIANT)
+        return _map;
+
+    if(_backend == BACKEND_JSON)
+        return _json.toVariantMap();
+
+    QVariantMap map;
+    for(const Field& field : _fields)
+    {
+        map.insert(field.key, value(field.key));
+    }
+
+    const QStringList routingKeys = {QStringLiteral("uuid"), QStringLiteral("command"), QStringLiteral("msguid"),
+                                     QStringLiteral("ch"), QStringLiteral("seq")};
+    for(const QString& key : routingKeys)
+    {
+        QVariant routingValue = value(key);
+        if(routingValue.isValid())
+            map.insert(key, routingValue);
+    }
+
+    return map;
+}
+
+QList<MessageEnvelope> MessageEnvelope::unpackBatch() const
+{
+    QList<MessageEnvelope> envelopes;
+
+    if(_backend == BACKEND_JSON)
+    {
+        const QJsonArray messages = _json.value(QStringLiteral("messages")).toArray();
+        for(int i = 0; i < messages.count(); i++)
+        {
+            envelopes.append(MessageCodec::envelopeFromJson(messages.at(i).toObject()));
+        }
+        return envelopes;
+    }
+
+    if(_backend == BACKEND_VARIANT)
+    {
+        QListIterator<QVariant> it(_map.value(QStringLiteral("messages")).toList());
+        while(it.hasNext())
+        {
+            envelopes.append(MessageEnvelope(it.next().toMap()));
+        }
+        return envelopes;
+    }
+
+    for(const Field& field : _fields)
+    {
+        if(field.key != QStringLiteral("messages"))
+            continue;
+
+        // the nested messages are split by their byte ranges, each of them
+        // is routed on its own and parsed only by its consumer.
+        QByteArray raw = QByteArray::fromRawData(_cbor.constData() + field.begin, field.end - field.begin);
+        QCborStreamReader reader(raw);
+        if(!reader.isArray())
+            break;
+
+        reader.enterContainer();
+        while(reader.lastError() == QCborError::NoError && reader.hasNext())
+        {
+            int begin = int(reader.currentOffset());
+            reader.next();
+            int end = int(reader.currentOffset());
+
+            bool ok;
+            MessageEnvelope envelope = MessageCodec::decodeEnvelope(_cbor.mid(field.begin + begin, end - begin), &ok);
+            if(ok)
+                envelopes.append(envelope);
+        }
+        break;
+    }
+
+    return envelopes;
+}
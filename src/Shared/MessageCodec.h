@@ -0,0 +1,200 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * It is part of the QuickHub framework - www.quickhub.org
+ * Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de */
+
+
+#ifndef MESSAGECODEC_H
+#define MESSAGECODEC_H
+
+#include <QByteArray>
+#include <QVariant>
+#include <QVector>
+#include <QCborValue>
+#include <QJsonObject>
+
+class MessageEnvelope;
+
+/*!
+    \class MessageCodec
+    \brief Encodes and decodes the frames exchanged by Connection.
+
+    QuickHub speaks JSON by default. If both sides agree on it during the connect
+    handshake, frames are exchanged as CBOR instead, which is a lot cheaper to write
+    and to parse. The format of an incoming frame is detected by its first byte, so
+    both formats may be mixed on one socket while the negotiation is in flight.
+*/
+
+class MessageCodec
+{
+public:
+    enum Format
+    {
+        FORMAT_JSON,
+        FORMAT_CBOR
+    };
+
+    /*!
+        \fn QByteArray MessageCodec::encode(const QVariantMap& message, Format format)
+        Serializes the message with the given format.
+    */
+    static QByteArray   encode(const QVariantMap& message, Format format);
+
+    /*!
+        \fn QVariantMap MessageCodec::decode(const QByteArray& frame, bool* ok)
+        Deserializes a frame of either format. The resulting QVariantMap is the same
+        for both formats and follows QJsonValue::toVariant(): null is handed out as
+        std::nullptr_t, numbers as double on Qt5 and integral numbers as qlonglong on Qt6.
+    */
+    static QVariantMap  decode(const QByteArray& frame, bool* ok = nullptr);
+
+    /*!
+        \fn MessageEnvelope MessageCodec::decodeEnvelope(const QByteArray& frame, bool* ok)
+        Reads only the routing fields of a frame. The payload stays untouched until
+        MessageEnvelope::payload() is called by whoever consumes the message.
+    */
+    static MessageEnvelope decodeEnvelope(const QByteArray& frame, bool* ok = nullptr);
+
+    /*!
+        \fn QByteArray MessageCodec::encodeBatch(const QList<QByteArray>& frames, Format format)
+        Wraps already encoded frames into one connection:batch frame without
+        decoding them again. All frames must have been encoded with the given format.
+    */
+    static QByteArray   encodeBatch(const QList<QByteArray>& frames, Format format);
+
+    /*!
+        \fn QByteArray MessageCodec::compress(const QByteArray& frame, int level)
+        Deflates an encoded frame. Compressed frames start with a zero byte, which is
+        neither valid JSON nor a valid CBOR message, so they can be told apart from
+        uncompressed frames of both formats.
+    */
+    static QByteArray   compress(const QByteArray& frame, int level = -1);
+    static QByteArray   decompress(const QByteArray& frame, bool* ok = nullptr);
+    static bool         isCompressed(const QByteArray& frame);
+
+    /*!
+        \fn QList<QByteArray> MessageCodec::fragment(const QByteArray& frame, quint32 id, int size)
+        Splits a frame into fragments of at most size bytes of data. Fragments start with
+        the byte 0x01, followed by the id of the frame and a flag which marks the last one.
+        The overload with an offset returns only the fragment which starts at offset.
+    */
+    static QList<QByteArray> fragment(const QByteArray& frame, quint32 id, int size);
+    static QByteArray   fragment(const QByteArray& frame, quint32 id, int offset, int size);
+    static bool         isFragment(const QByteArray& frame);
+    static bool         readFragment(const QByteArray& fragment, quint32* id, bool* last, QByteArray* data);
+
+    /*!
+        \fn MessageCodec::Format MessageCodec::detectFormat(const QByteArray& frame)
+        Returns the format of the frame. JSON frames always start with an object
+        or whitespace, everything else is treated as CBOR.
+    */
+    static Format       detectFormat(const QByteArray& frame);
+
+    static QString      formatName(Format format);
+    static Format       formatFromName(const QString& name, Format fallback = FORMAT_JSON);
+
+    /*!
+        \fn QVariant MessageCodec::cborToVariant(const QCborValue& value)
+        Converts a CBOR value to the QVariant the JSON parser would have produced
+        for the same data.
+    */
+    static QVariant     cborToVariant(const QCborValue& value);
+
+private:
+    friend class MessageEnvelope;
+    static MessageEnvelope envelopeFromJson(const QJsonObject& object);
+};
+
+
+/*!
+    \class MessageEnvelope
+    \brief A frame of which only the routing fields have been read.
+
+    Connection only needs uuid and command to decide where a frame belongs to.
+    Everything else is kept in its serialized form (the parsed JSON document or
+    the raw CBOR bytes) and converted to a QVariant tree once, when it is asked for.
+*/
+
+class MessageEnvelope
+{
+public:
+                MessageEnvelope();
+    explicit    MessageEnvelope(const QVariantMap& message);
+
+    QString     uuid() const;
+    QString     command() const;
+    QString     msguid() const;
+
+    /*!
+        \fn int MessageEnvelope::channel() const
+        Returns the integer channel id of the frame or -1 if the frame is addressed by uuid.
+    */
+    int         channel() const;
+
+    /*!
+        \fn qint64 MessageEnvelope::sequence() const
+        Returns the sequence number the sender assigned to the frame within its
+        session or -1 if the frame has none.
+    */
+    qint64      sequence() const;
+
+    /*!
+        \fn int MessageEnvelope::frameSize() const
+        Returns the size of the frame the message has been decoded from, 0 if unknown.
+    */
+    int         frameSize() const;
+
+    /*!
+        \fn QVariant MessageEnvelope::payload() const
+        Materializes the payload. The result is cached, so calling this function
+        several times does not parse the payload again.
+    */
+    QVariant    payload() const;
+
+    /*!
+        \fn QVariant MessageEnvelope::value(const QString& key) const
+        Materializes an arbitrary top level field of the frame.
+    */
+    QVariant    value(const QString& key) const;
+    QVariantMap toMap() const;
+
+    /*!
+        \fn QList<MessageEnvelope> MessageEnvelope::unpackBatch() const
+        Returns the envelopes of the messages contained in a connection:batch frame.
+    */
+    QList<MessageEnvelope> unpackBatch() const;
+
+private:
+    friend class MessageCodec;
+
+    enum Backend
+    {
+        BACKEND_VARIANT,
+        BACKEND_JSON,
+        BACKEND_CBOR
+    };
+
+    struct Field
+    {
+        QString key;
+        int     begin;
+        int     end;
+    };
+
+    Backend             _backend = BACKEND_VARIANT;
+    QString             _uuid;
+    QString             _command;
+    QString             _msguid;
+    int                 _channel = -1;
+    qint64              _sequence = -1;
+    int                 _frameSize = 0;
+    QVariantMap         _map;
+    QJsonObject         _json;
+    QByteArray          _cbor;
+    QVector<Field>      _fields;
+    mutable QVariant    _payload;
+    mutable bool        _payloadMaterialized = false;
+};
+
+#endif // MESSAGECODEC_H
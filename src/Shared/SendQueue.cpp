@@ -0,0 +1,169 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * It is part of the QuickHub framework - www.quickhub.org
+ * Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de */
+
+
+#include "SendQueue.h"
+#include "MessageCodec.h"
+
+void SendQueue::enqueue(const QByteArray &frame, Lane lane, const QStringList& keys)
+{
+    if(lane == LANE_INTERACTIVE)
+    {
+        for(const QString& key : keys)
+        {
+            if(_bulkPending.contains(key))
+            {
+                lane = LANE_BULK;
+                break;
+            }
+        }
+    }
+
+    if(lane == LANE_BULK)
+    {
+        for(const QString& key : keys)
+        {
+            _bulkPending[key]++;
+        }
+    }
+
+    Entry entry;
+    entry.frame = frame;
+    entry.keys = keys;
+    _lanes[lane].enqueue(entry);
+    _bytes[lane] += frame.size();
+}
+
+QByteArray SendQueue::take(Lane lowest, int fragmentSize)
+{
+    for(int lane = 0; lane <= lowest; lane++)
+    {
+        if(_lanes[lane].isEmpty())
+            continue;
+
+        Entry& head = _lanes[lane].head();
+        if(head.offset > 0 || (fragmentSize > 0 && head.frame.size() > fragmentSize))
+        {
+            if(head.offset == 0)
+                head.fragmentId = _nextFragmentId++;
+
+            int size = fragmentSize > 0 ? fragmentSize : head.frame.size() - head.offset;
+            QByteArray fragment = MessageCodec::fragment(head.frame, head.fragmentId, head.offset, size);
+            int length = qMin(size, head.frame.size() - head.offset);
+            head.offset += length;
+            _bytes[lane] -= length;
+            _fragments++;
+
+            // the rest of the frame stays at the head of its lane
+            if(head.offset < head.frame.size())
+                return fragment;
+
+            release(lane, _lanes[lane].dequeue());
+            return fragment;
+        }
+
+        Entry entry = _lanes[lane].dequeue();
+        _bytes[lane] -= entry.frame.size();
+        release(lane, entry);
+        return entry.frame;
+    }
+
+    return QByteArray();
+}
+
+void SendQueue::release(int lane, const Entry &entry)
+{
+    if(lane != LANE_BULK)
+        return;
+
+    for(const QString& key : entry.keys)
+    {
+        if(--_bulkPending[key] <= 0)
+            _bulkPending.remove(key);
+    }
+}
+
+void SendQueue::restartFragments()
+{
+    for(int lane = 0; lane < LANE_COUNT; lane++)
+    {
+        if(_lanes[lane].isEmpty() || _lanes[lane].head().offset == 0)
+            continue;
+
+        _bytes[lane] += _lanes[lane].head().offset;
+        _lanes[lane].head().offset = 0;
+    }
+}
+
+int SendQueue::remove(const QSet<QString> &keys)
+{
+    int removed = 0;
+    for(int lane = 0; lane < LANE_COUNT; lane++)
+    {
+        QMutableListIterator<Entry> it(_lanes[lane]);
+        while(it.hasNext())
+        {
+            const Entry& entry = it.next();
+            if(entry.keys.isEmpty() || entry.offset > 0)
+                continue;
+
+            bool stale = true;
+            for(const QString& key : entry.keys)
+            {
+                if(!keys.contains(key))
+                {
+                    stale = false;
+                    break;
+                }
+            }
+
+            if(!stale)
+                continue;
+
+            _bytes[lane] -= entry.frame.size();
+            release(lane, entry);
+            it.remove();
+            removed++;
+        }
+    }
+    return removed;
+}
+
+bool SendQueue::isEmpty(Lane lowest) const
+{
+    for(int lane = 0; lane <= lowest; lane++)
+    {
+        if(!_lanes[lane].isEmpty())
+            return false;
+    }
+
+    return true;
+}
+
+qint64 SendQueue::bytes() const
+{
+    return _bytes[LANE_CONTROL] + _bytes[LANE_INTERACTIVE] + _bytes[LANE_BULK];
+}
+
+qint64 SendQueue::bytes(Lane lane) const
+{
+    return _bytes[lane];
+}
+
+qint64 SendQueue::fragments() const
+{
+    return _fragments;
+}
+
+void SendQueue::clear()
+{
+    for(int lane = 0; lane < LANE_COUNT; lane++)
+    {
+        _lanes[lane].clear();
+        _bytes[lane] = 0;
+    }
+    _bulkPending.clear();
+}
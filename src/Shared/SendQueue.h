@@ -0,0 +1,92 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * It is part of the QuickHub framework - www.quickhub.org
+ * Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de */
+
+
+#ifndef SENDQUEUE_H
+#define SENDQUEUE_H
+
+#include <QByteArray>
+#include <QQueue>
+#include <QHash>
+#include <QStringList>
+#include <QSet>
+
+/*!
+    \class SendQueue
+    \brief Holds the frames Connection has not yet handed to the socket.
+
+    Frames are sorted into priority lanes. take() always returns the oldest frame of
+    the most urgent lane which is not empty, so control frames overtake queued
+    interactive commands and both overtake bulk data. The order within a lane is kept.
+
+    Frames may name the virtual connections they belong to. An interactive frame of a
+    virtual connection which still has bulk data queued is appended to the bulk lane,
+    so that messages of one virtual connection never overtake each other.
+
+    Frames are queued as a whole and only fragmented when they are taken. The rest of a
+    fragmented frame stays at the head of its lane until its last fragment has been taken.
+*/
+
+class SendQueue
+{
+public:
+    enum Lane
+    {
+        LANE_CONTROL = 0,
+        LANE_INTERACTIVE = 1,
+        LANE_BULK = 2
+    };
+
+    void        enqueue(const QByteArray& frame, Lane lane, const QStringList& keys = QStringList());
+
+    /*!
+        \fn QByteArray SendQueue::take(Lane lowest, int fragmentSize)
+        Returns the next frame. If fragmentSize is greater than 0, frames larger than
+        fragmentSize bytes are handed out as fragments (see MessageCodec::fragment()).
+        A frame which has been started as fragments is always finished as fragments.
+    */
+    QByteArray  take(Lane lowest = LANE_BULK, int fragmentSize = 0);
+
+    /*!
+        \fn void SendQueue::restartFragments()
+        Frames which have only been sent in part are sent again from their beginning and
+        under a new fragment id. Used after the connection has been lost, because the other
+        side drops the fragments it has received so far.
+    */
+    void        restartFragments();
+
+    /*!
+        \fn int SendQueue::remove(const QSet<QString>& keys)
+        Drops all frames which only belong to the given keys and returns their number.
+        Frames which have been sent in part are kept.
+    */
+    int         remove(const QSet<QString>& keys);
+    bool        isEmpty(Lane lowest = LANE_BULK) const;
+    qint64      bytes() const;
+    qint64      bytes(Lane lane) const;
+    qint64      fragments() const;
+    void        clear();
+
+private:
+    struct Entry
+    {
+        QByteArray  frame;
+        QStringList keys;
+        int         offset = 0;
+        quint32     fragmentId = 0;
+    };
+
+    void        release(int lane, const Entry& entry);
+
+    static const int LANE_COUNT = 3;
+    QQueue<Entry>       _lanes[LANE_COUNT];
+    qint64              _bytes[LANE_COUNT] = {0, 0, 0};
+    QHash<QString, int> _bulkPending;
+    quint32             _nextFragmentId = 0;
+    qint64              _fragments = 0;
+};
+
+#endif // SENDQUEUE_H
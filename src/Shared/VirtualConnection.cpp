@@ -7,6 +7,22 @@
 
 #include "VirtualConnection.h"
 
+namespace
+{
+    int remoteChannel(const MessageEnvelope& message)
+    {
+        bool ok;
+        int channel = message.value("channel").toInt(&ok);
+        return ok ? channel : -1;
+    }
+
+    int subchannelTag(const MessageEnvelope& message)
+    {
+        bool ok;
+        int tag = message.value("tag").toInt(&ok);
+        return ok ? tag : -1;
+    }
+}
 
 VirtualConnection::VirtualConnection(Connection* connection) : QObject(connection),
     _state(DISCONNECTED),
@@ -14,28 +30,74 @@ VirtualConnection::VirtualConnection(Connection* connection) : QObject(connectio
     _connected(false)
 {
     _uuid = QUuid::createUuid().toString();
-    _connection->addVirtualConnection(this);
+    _channel = _connection->addVirtualConnection(this);
     connect(connection, &Connection::connected, this, &VirtualConnection::connectionConnected);
     connect(connection, &Connection::disconnected, this, &VirtualConnection::connectionDisconnected);
     connect(connection, &QObject::destroyed, this, &VirtualConnection::connectionDestroyed);
+    connect(connection, &Connection::congestionChanged, this, &VirtualConnection::congestionChanged);
     if(_connection->isConnected())
         open();
 }
 
 VirtualConnection::~VirtualConnection()
 {
+    if(_parent)
+    {
+        close();
+
+        // the tag may belong to a new subchannel after the peer has closed this one
+        if(_parent->_subchannels.value(_tag) == this)
+            _parent->_subchannels.remove(_tag);
+        return;
+    }
+
+    // closing this connection closes its subchannels on the other side as well,
+    // including the ones the peer has closed already, which are no longer in _subchannels
+    const QList<VirtualConnection*> subchannels = findChildren<VirtualConnection*>(QString(), Qt::FindDirectChildrenOnly);
+    _subchannels.clear();
+    for(VirtualConnection* subchannel : subchannels)
+    {
+        subchannel->_parent = nullptr;
+        delete subchannel;
+    }
+
     close();
 }
 
 VirtualConnection::VirtualConnection(QString uuid, Connection *connection): QObject(connection),
+    _state(DISCONNECTED),
     _connection(connection),
     _uuid(uuid),
     _connected(false)
 {
-    _connection->addVirtualConnection(this);
+    _channel = _connection->addVirtualConnection(this);
     connect(connection, &Connection::connected, this, &VirtualConnection::connectionConnected);
     connect(connection, &Connection::disconnected, this, &VirtualConnection::connectionDisconnected);
     connect(connection, &QObject::destroyed, this, &VirtualConnection::connectionDestroyed);
+    connect(connection, &Connection::congestionChanged, this, &VirtualConnection::congestionChanged);
+}
+
+VirtualConnection::VirtualConnection(VirtualConnection *parent, int tag) : QObject(parent),
+    _state(DISCONNECTED),
+    _connection(nullptr),
+    _uuid(parent->_uuid),
+    _connected(false),
+    _channel(parent->_channel),
+    _parent(parent),
+    _tag(tag)
+{
+    _parent->_subchannels.insert(_tag, this);
+    connect(_parent, &VirtualConnection::connected, this, &VirtualConnection::parentConnected);
+    connect(_parent, &VirtualConnection::disconnected, this, &VirtualConnection::connectionDisconnected);
+    connect(_parent, &VirtualConnection::resumeFailed, this, &VirtualConnection::resumeFailed);
+    connect(_parent, &VirtualConnection::congestionChanged, this, &VirtualConnection::congestionChanged);
+
+    // there is nothing to register, a subchannel can be used right away
+    if(_parent->_state == CONNECTED)
+    {
+        _connected = true;
+        _state = CONNECTED;
+    }
 }
 
 QString VirtualConnection::getUUID()
@@ -43,14 +105,91 @@ QString VirtualConnection::getUUID()
     return _uuid;
 }
 
+int VirtualConnection::getChannel() const
+{
+    return _channel;
+}
+
+int VirtualConnection::getRemoteChannel() const
+{
+    return _remoteChannel;
+}
+
+VirtualConnection *VirtualConnection::openSubchannel()
+{
+    return new VirtualConnection(this, _nextTag++);
+}
+
+int VirtualConnection::getTag() const
+{
+    return _tag;
+}
+
+VirtualConnection *VirtualConnection::getParentConnection() const
+{
+    return _parent;
+}
+
+VirtualConnection *VirtualConnection::getSubchannel(int tag) const
+{
+    return _subchannels.value(tag, nullptr);
+}
+
+void VirtualConnection::setAcceptSubchannels(bool accept)
+{
+    _acceptSubchannels = accept;
+}
+
+qint64 VirtualConnection::getLastSequence() const
+{
+    return _lastSequence;
+}
+
+int VirtualConnection::getLastFrameSize() const
+{
+    return _lastFrameSize;
+}
+
+void VirtualConnection::resumeSession(bool resumed)
+{
+    if(resumed)
+        return;
+
+    _remoteChannel = -1;
+    _lastSequence = -1;
+    _state = DISCONNECTED;
+    _connected = false;
+    Q_EMIT resumeFailed();
+    Q_EMIT disconnected();
+    open();
+}
+
 void VirtualConnection::deployMessage(const QVariantMap &message)
 {
-    QString command = message["command"].toString();
+    deployMessage(MessageEnvelope(message));
+}
+
+void VirtualConnection::deployMessage(const MessageEnvelope &message)
+{
+    if(_parent || subchannelTag(message) >= 0)
+    {
+        deploySubchannelMessage(message);
+        return;
+    }
+
+    QString command = message.command();
 
     QVariantMap msg;
     if(command == "send")
     {
-        Q_EMIT messageReceived(message["payload"]);
+        // a channel id can belong to a connection which has been closed in the meantime
+        if(_state != CONNECTED)
+            return;
+
+        if(message.sequence() >= 0)
+            _lastSequence = message.sequence();
+        _lastFrameSize = message.frameSize();
+        Q_EMIT messageReceived(message.payload());
     }
 
     if(command == "connection:register")
@@ -60,6 +199,12 @@ void VirtualConnection::deployMessage(const QVariantMap &message)
         if(!_connection)
             return;
 
+        // peers which announce a channel id get ours in return and
+        // both sides address frames by channel from now on.
+        _remoteChannel = remoteChannel(message);
+        if(_remoteChannel >= 0)
+            msg["channel"] = _channel;
+
         _connection->sendVariant(msg);
         _connected = true;
         _state = CONNECTED;
@@ -69,6 +214,7 @@ void VirtualConnection::deployMessage(const QVariantMap &message)
 
     if(command == "connection:registered")
     {
+        _remoteChannel = remoteChannel(message);
         _connected = true;
         _state = CONNECTED;
         Q_EMIT connected();
@@ -79,8 +225,11 @@ void VirtualConnection::deployMessage(const QVariantMap &message)
     {
         msg["command"] ="connection:closed";
         msg["uuid"] = _uuid;
+        if(_remoteChannel >= 0)
+            msg["ch"] = _remoteChannel;
         _connection->sendVariant(msg);
         _connected = false;
+        _remoteChannel = -1;
         _state = DISCONNECTED;
         Q_EMIT disconnected();
         return;
@@ -88,6 +237,7 @@ void VirtualConnection::deployMessage(const QVariantMap &message)
 
     if(command == "connection:closed")
     {
+        _remoteChannel = -1;
         _connected = false;
         _state = DISCONNECTED;
         Q_EMIT disconnected();
@@ -95,6 +245,90 @@ void VirtualConnection::deployMessage(const QVariantMap &message)
     }
 }
 
+void VirtualConnection::deploySubchannelMessage(const MessageEnvelope &message)
+{
+    const QString command = message.command();
+    if(!_parent)
+    {
+        if(command == "send" && _state != CONNECTED)
+            return;
+
+        const int tag = subchannelTag(message);
+        VirtualConnection* subchannel = _subchannels.value(tag, nullptr);
+        if(!subchannel && _acceptSubchannels && command == "send" && _state == CONNECTED)
+        {
+            subchannel = new VirtualConnection(this, tag);
+            Q_EMIT newSubchannel(subchannel);
+        }
+
+        // the sequence belongs to the registered connection, it is what a session resumes
+        if(command == "send" && message.sequence() >= 0)
+            _lastSequence = message.sequence();
+
+        if(subchannel)
+            subchannel->deploySubchannelMessage(message);
+        return;
+    }
+
+    if(command == "send")
+    {
+        if(_state != CONNECTED)
+            return;
+
+        _lastFrameSize = message.frameSize();
+        Q_EMIT messageReceived(message.payload());
+        return;
+    }
+
+    if(command == "connection:close")
+    {
+        // the peer will not use the tag again, a later frame with it opens a new subchannel
+        _closed = true;
+        _parent->_subchannels.remove(_tag);
+        _connected = false;
+        _state = DISCONNECTED;
+        Q_EMIT disconnected();
+    }
+}
+
+void VirtualConnection::sendTagged(const QVariant &data, int tag)
+{
+    if(!_connection | (_state != CONNECTED))
+        return;
+
+    QVariantMap msg;
+    msg["payload"] = data;
+    if(_remoteChannel >= 0)
+        msg["ch"] = _remoteChannel;
+    else
+        msg["uuid"] = _uuid;
+    msg["tag"] = tag;
+    msg["command"] = "send";
+    _connection->sendVariant(msg);
+}
+
+void VirtualConnection::closeSubchannel(int tag)
+{
+    if(!_connection | (_state != CONNECTED))
+        return;
+
+    QVariantMap msg;
+    msg["command"] = "connection:close";
+    msg["uuid"] = _uuid;
+    if(_remoteChannel >= 0)
+        msg["ch"] = _remoteChannel;
+    msg["tag"] = tag;
+    _connection->sendVariant(msg);
+}
+
+bool VirtualConnection::isCongested() const
+{
+    if(_parent)
+        return _parent->isCongested();
+
+    return _connection && _connection->isCongested();
+}
+
 VirtualConnection::ConnectionState VirtualConnection::getConnectionState()
 {
     return _state;
@@ -102,6 +336,20 @@ VirtualConnection::ConnectionState VirtualConnection::getConnectionState()
 
 void VirtualConnection::open()
 {
+    if(_parent)
+    {
+        // a subchannel closed by the peer has lost its tag
+        if(_parent->_subchannels.value(_tag) != this)
+            return;
+
+        _closed = false;
+        if(_parent->_state == CONNECTED)
+            parentConnected();
+        else
+            _parent->open();
+        return;
+    }
+
     if(!_connection | (_state == CONNECTING) | (_state == CONNECTED))
         return;
 
@@ -109,28 +357,56 @@ void VirtualConnection::open()
     QVariantMap msg;
     msg["command"] ="connection:register";
     msg["uuid"] = _uuid;
+    msg["channel"] = _channel;
    _connection->sendVariant(msg);
 }
 
 void VirtualConnection::close()
 {
+    if(_parent)
+    {
+        _closed = true;
+        if(_state == DISCONNECTED)
+            return;
+
+        _parent->closeSubchannel(_tag);
+        _connected = false;
+        _state = DISCONNECTED;
+        return;
+    }
+
     if(!_connection | (_state == DISCONNECTED))
         return;
 
     QVariantMap msg;
     msg["command"] ="connection:close";
     msg["uuid"] = _uuid;
+
+    // same routing key as the frames sent before, so it is queued behind them
+    if(_remoteChannel >= 0)
+        msg["ch"] = _remoteChannel;
     _connection->sendVariant(msg);
+    _connection->closeChannel(_uuid, _channel);
 }
 
 void VirtualConnection::sendVariant(const QVariant& data)
 {
+    if(_parent)
+    {
+        if(_state == CONNECTED)
+            _parent->sendTagged(data, _tag);
+        return;
+    }
+
     if(!_connection | (_state != CONNECTED))
         return;
 
     QVariantMap msg;
     msg["payload"] = data;
-    msg["uuid"] = _uuid;
+    if(_remoteChannel >= 0)
+        msg["ch"] = _remoteChannel;
+    else
+        msg["uuid"] = _uuid;
     msg["command"] = "send";
     _connection->sendVariant(msg);
 }
@@ -142,11 +418,23 @@ void VirtualConnection::connectionConnected()
 
 void VirtualConnection::connectionDisconnected()
 {
+    _remoteChannel = -1;
+    _lastSequence = -1;
     _state = DISCONNECTED;
     _connected = false;
     Q_EMIT disconnected();
 }
 
+void VirtualConnection::parentConnected()
+{
+    if(_closed || (_state == CONNECTED))
+        return;
+
+    _connected = true;
+    _state = CONNECTED;
+    Q_EMIT connected();
+}
+
 void VirtualConnection::connectionDestroyed()
 {
     _connection = nullptr;
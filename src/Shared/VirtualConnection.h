@@ -10,6 +10,7 @@
 
 #include <QObject>
 #include <QUuid>
+#include <QHash>
 
 #include "Connection.h"
 
@@ -31,10 +32,52 @@ public:
                     ~VirtualConnection();
     explicit        VirtualConnection(QString uuid, Connection* connection = nullptr);
     QString         getUUID();
+    int             getChannel() const;
+    int             getRemoteChannel() const;
+
+    /*!
+        \fn VirtualConnection* VirtualConnection::openSubchannel()
+        Returns a new subchannel of this virtual connection. Its frames are sent over this
+        virtual connection with a tag, so it does not register on its own. A subchannel is
+        connected while this virtual connection is connected, until either side closes it,
+        and is deleted with it.
+    */
+    VirtualConnection* openSubchannel();
+
+    /*!
+        \fn int VirtualConnection::getTag() const
+        Returns the tag of a subchannel or -1 for a registered virtual connection.
+    */
+    int             getTag() const;
+    VirtualConnection* getParentConnection() const;
+    VirtualConnection* getSubchannel(int tag) const;
+
+    /*!
+        \fn void VirtualConnection::setAcceptSubchannels(bool accept)
+        If enabled, the first frame with an unknown tag creates a subchannel and
+        newSubchannel() is emitted. This is used on the receiving side.
+    */
+    void            setAcceptSubchannels(bool accept);
+
+    /*!
+        \fn qint64 VirtualConnection::getLastSequence() const
+        Returns the sequence number of the last message received within the current session.
+    */
+    qint64          getLastSequence() const;
+    int             getLastFrameSize() const;
+
+    /*!
+        \fn void VirtualConnection::resumeSession(bool resumed)
+        Called by Connection after a suspended session has been resumed. If the server has not
+        kept the state of this virtual connection, it is reset and registered again.
+    */
+    void            resumeSession(bool resumed);
 
     // make connection as friend and do private
+    void            deployMessage(const MessageEnvelope &message);
     void            deployMessage(const QVariantMap &message);
     ConnectionState getConnectionState();
+    bool            isCongested() const;
 
 public slots:
    void open();
@@ -45,17 +88,42 @@ signals:
     void connected();
     void disconnected();
     void messageReceived(const QVariant& message);
+    void congestionChanged(bool congested);
+    void newSubchannel(VirtualConnection* subchannel);
+
+    /*!
+        \fn void VirtualConnection::resumeFailed()
+        Emitted before the virtual connection is registered again because the server
+        was not able to resume it. Everything that was attached needs to be attached again.
+    */
+    void resumeFailed();
 
 private:
+    explicit        VirtualConnection(VirtualConnection* parent, int tag);
+    void            deploySubchannelMessage(const MessageEnvelope &message);
+    void            sendTagged(const QVariant &data, int tag);
+    void            closeSubchannel(int tag);
+
     ConnectionState     _state;
     Connection*         _connection;
     QString             _uuid;
     bool                _connected;
+    int                 _channel = -1;
+    int                 _remoteChannel = -1;
+    qint64              _lastSequence = -1;
+    int                 _lastFrameSize = 0;
+    VirtualConnection*  _parent = nullptr;
+    int                 _tag = -1;
+    int                 _nextTag = 0;
+    bool                _acceptSubchannels = false;
+    bool                _closed = false;
+    QHash<int, VirtualConnection*> _subchannels;
 
 private slots:
     void connectionConnected();
     void connectionDisconnected();
     void connectionDestroyed();
+    void parentConnected();
 
 };
 
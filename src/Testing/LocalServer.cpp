@@ -0,0 +1,977 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * It is part of the QuickHub framework - www.quickhub.org
+ * Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de */
+
+
+#include "LocalServer.h"
+#include "../Shared/Connection.h"
+#include "../Shared/VirtualConnection.h"
+#include <QWebSocketServer>
+#include <QWebSocket>
+#include <QDateTime>
+#include <QUuid>
+#include <QDebug>
+
+LocalServer::LocalServer(QObject *parent) : QObject(parent),
+    _random(_seed)
+{
+    connect(&_updateTimer, &QTimer::timeout, this, &LocalServer::sendUpdates);
+}
+
+LocalServer::~LocalServer()
+{
+    close();
+    qDeleteAll(_resources);
+}
+
+bool LocalServer::listen(quint16 port)
+{
+    close();
+
+    _server = new QWebSocketServer(QStringLiteral("QuickHub LocalServer"), QWebSocketServer::NonSecureMode, this);
+    connect(_server, &QWebSocketServer::newConnection, this, &LocalServer::newConnection);
+    if(!_server->listen(QHostAddress::LocalHost, port))
+    {
+        qWarning()<<Q_FUNC_INFO<<": "<<_server->errorString();
+        delete _server;
+        _server = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+void LocalServer::close()
+{
+    _updateTimer.stop();
+    _attachments.clear();
+    for(Resource* resource : qAsConst(_resources))
+    {
+        resource->subscribers.clear();
+    }
+
+    // disconnects the virtual connections before the socket is gone
+    QList<Connection*> connections = _connections;
+    _connections.clear();
+    for(Connection* connection : connections)
+    {
+        connection->setSocket(nullptr);
+        delete connection;
+    }
+
+    if(!_server)
+        return;
+
+    _server->close();
+    delete _server;
+    _server = nullptr;
+}
+
+bool LocalServer::isListening() const
+{
+    return _server && _server->isListening();
+}
+
+quint16 LocalServer::port() const
+{
+    return _server ? _server->serverPort() : 0;
+}
+
+QString LocalServer::url() const
+{
+    return QStringLiteral("ws://127.0.0.1:%1").arg(port());
+}
+
+void LocalServer::setListSize(int rows)
+{
+    _listSize = qMax(0, rows);
+}
+
+int LocalServer::listSize() const
+{
+    return _listSize;
+}
+
+void LocalServer::setPropertyCount(int properties)
+{
+    _propertyCount = qMax(0, properties);
+}
+
+int LocalServer::propertyCount() const
+{
+    return _propertyCount;
+}
+
+void LocalServer::setFieldCount(int fields)
+{
+    _fieldCount = qMax(0, fields);
+}
+
+int LocalServer::fieldCount() const
+{
+    return _fieldCount;
+}
+
+void LocalServer::setTextLength(int length)
+{
+    _textLength = qMax(0, length);
+}
+
+int LocalServer::textLength() const
+{
+    return _textLength;
+}
+
+void LocalServer::setUpdateRate(int updates)
+{
+    _updateRate = qMax(0, updates);
+    if(_updateRate == 0)
+    {
+        _updateTimer.stop();
+        return;
+    }
+
+    _updateTimer.setInterval(qMax(10, 1000 / _updateRate));
+    _updateClock.start();
+    _updateBase = _updatesSent;
+    _updateTimer.start();
+}
+
+int LocalServer::updateRate() const
+{
+    return _updateRate;
+}
+
+void LocalServer::setLatency(int latency)
+{
+    _latency = qMax(0, latency);
+}
+
+int LocalServer::latency() const
+{
+    return _latency;
+}
+
+void LocalServer::setLazyLists(bool lazy)
+{
+    _lazyLists = lazy;
+}
+
+bool LocalServer::lazyLists() const
+{
+    return _lazyLists;
+}
+
+void LocalServer::setSeed(quint32 seed)
+{
+    _seed = seed;
+    _random.seed(seed);
+}
+
+QVariantMap LocalServer::getStatistics() const
+{
+    QVariantMap statistics;
+    statistics["connections"] = _connections.count();
+    statistics["attachments"] = _attachments.count();
+    statistics["resources"] = _resources.count();
+    statistics["messagesSent"] = _messagesSent;
+    statistics["messagesReceived"] = _messagesReceived;
+    statistics["updatesSent"] = _updatesSent;
+    return statistics;
+}
+
+void LocalServer::newConnection()
+{
+    while(_server && _server->hasPendingConnections())
+    {
+        Connection* connection = new Connection(_server->nextPendingConnection(), this);
+        _connections.append(connection);
+        connect(connection, &Connection::newVirtualConnection, this, &LocalServer::newVirtualConnection);
+        connect(connection, &Connection::disconnected, this, [=](){
+            if(!_connections.removeOne(connection))
+                return;
+
+            connection->deleteLater();
+            Q_EMIT clientDisconnected();
+        });
+        Q_EMIT clientConnected();
+    }
+}
+
+void LocalServer::newVirtualConnection(VirtualConnection *connection)
+{
+    // a subchannel is served like a virtual connection of its own
+    connection->setAcceptSubchannels(connection->getTag() < 0);
+    connect(connection, &VirtualConnection::newSubchannel, this, &LocalServer::newVirtualConnection);
+    connect(connection, &VirtualConnection::messageReceived, this, [=](const QVariant& message){
+        handleMessage(connection, message.toMap());
+    });
+
+    // the client never registers a closed virtual connection again
+    connect(connection, &VirtualConnection::disconnected, this, [=](){
+        detach(connection, false);
+        connection->deleteLater();
+    });
+    connect(connection, &QObject::destroyed, this, &LocalServer::virtualConnectionDestroyed);
+}
+
+void LocalServer::virtualConnectionDestroyed()
+{
+    // only used as key, the object is already gone
+    detach(static_cast<VirtualConnection*>(sender()), false);
+}
+
+void LocalServer::handleMessage(VirtualConnection *connection, const QVariantMap &msg)
+{
+    _messagesReceived++;
+    const QString command = msg.value(QStringLiteral("command")).toString();
+
+    if(command == QStringLiteral("ACK"))
+        return;
+
+    if(command == QStringLiteral("user:login"))
+    {
+        handleLogin(connection, msg);
+        return;
+    }
+
+    if(command == QStringLiteral("user:logout"))
+    {
+        QVariantMap answer;
+        answer["command"] = "logout:success";
+        send(connection, answer);
+        return;
+    }
+
+    if(command.startsWith(QStringLiteral("call:")))
+    {
+        handleCall(connection, command, msg);
+        return;
+    }
+
+    if(command == QStringLiteral("attach:many"))
+    {
+        handleAttachMany(connection, msg);
+        return;
+    }
+
+    const QString type = command.section(':', 0, 0);
+    const QString action = command.section(':', 1);
+    if(action == QStringLiteral("attach"))
+    {
+        attach(connection, type, msg.value(QStringLiteral("payload")).toMap().value(QStringLiteral("descriptor")).toString());
+        return;
+    }
+
+    if(action == QStringLiteral("detach"))
+    {
+        detach(connection);
+        return;
+    }
+
+    Resource* resource = _attachments.value(connection, nullptr);
+    if(!resource || resource->type != type)
+        return;
+
+    const QVariantMap parameters = msg.value(QStringLiteral("parameters")).toMap();
+    if(type == QStringLiteral("synclist"))
+        handleSyncList(connection, resource, command, parameters);
+    else if(type == QStringLiteral("object"))
+        handleObject(connection, resource, command, parameters);
+    else if(type == QStringLiteral("list"))
+        handleList(connection, resource, command, parameters);
+    else if(type == QStringLiteral("device"))
+        handleDevice(connection, resource, command, parameters);
+}
+
+void LocalServer::handleAttachMany(VirtualConnection *connection, const QVariantMap &msg)
+{
+    // every request is handled like a message of its subchannel, the replies are collected
+    QHash<VirtualConnection*, QVariantList> replies;
+    _replies = &replies;
+
+    QVariantList results;
+    const QVariantList resources = msg.value(QStringLiteral("payload")).toMap().value(QStringLiteral("resources")).toList();
+    for(const QVariant& entry : resources)
+    {
+        const QVariantMap request = entry.toMap();
+        const int tag = request.value(QStringLiteral("tag"), -1).toInt();
+        if(tag < 0)
+            continue;
+
+        QVariantMap frame;
+        frame["command"] = "send";
+        frame["tag"] = tag;
+        frame["payload"] = request;
+        connection->deployMessage(frame);
+
+        VirtualConnection* subchannel = connection->getSubchannel(tag);
+        QVariantMap result;
+        result["tag"] = tag;
+        result["messages"] = replies.take(subchannel);
+        results << result;
+    }
+
+    _replies = nullptr;
+
+    QVariantMap payload;
+    payload["results"] = results;
+
+    QVariantMap answer;
+    answer["command"] = "attach:many:done";
+    answer["payload"] = payload;
+    send(connection, answer);
+}
+
+void LocalServer::handleLogin(VirtualConnection *connection, const QVariantMap &msg)
+{
+    const QString userID = msg.value(QStringLiteral("payload")).toMap().value(QStringLiteral("userID")).toString();
+
+    QVariantMap answer;
+    if(userID.isEmpty())
+    {
+        answer["command"] = "user:login:failed";
+        answer["errorstring"] = "No user name";
+        answer["errrorcode"] = 1;
+        send(connection, answer);
+        return;
+    }
+
+    QVariantMap user;
+    user["userID"] = userID;
+    user["name"] = userID;
+
+    QVariantMap payload;
+    payload["token"] = QUuid::createUuid().toString();
+    payload["user"] = user;
+
+    answer["command"] = "user:login:success";
+    answer["payload"] = payload;
+    send(connection, answer);
+}
+
+void LocalServer::handleCall(VirtualConnection *connection, const QString &command, const QVariantMap &msg)
+{
+    Q_UNUSED(command)
+    const QVariantMap payload = msg.value(QStringLiteral("payload")).toMap();
+
+    QVariantMap answer;
+    answer["uid"] = payload.value(QStringLiteral("uid"));
+    answer["data"] = payload.value(QStringLiteral("arg"));
+    send(connection, answer);
+}
+
+void LocalServer::handleSyncList(VirtualConnection *connection, Resource *resource, const QString &command, const QVariantMap &parameters)
+{
+    if(command == QStringLiteral("synclist:dump") || command == QStringLiteral("synclist:filter"))
+    {
+        QVariantMap answer;
+        answer["data"] = resource->rows;
+        answer["metadata"] = resource->metadata;
+
+        QVariantMap msg;
+        msg["command"] = "synclist:dump";
+        msg["parameters"] = answer;
+        send(connection, msg);
+        return;
+    }
+
+    if(command == QStringLiteral("synclist:get"))
+    {
+        int from = qMax(0, parameters.value(QStringLiteral("from")).toInt());
+        int count = parameters.value(QStringLiteral("count")).toInt();
+
+        QVariantMap answer;
+        answer["data"] = resource->rows.mid(from, count);
+
+        QVariantMap msg;
+        msg["command"] = "synclist:get";
+        msg["parameters"] = answer;
+        send(connection, msg);
+        return;
+    }
+
+    // optimistic clients match the replies by the operation id
+    QVariantMap reply;
+    if(parameters.contains(QStringLiteral("opid")))
+        reply["opid"] = parameters.value(QStringLiteral("opid"));
+
+    if(command == QStringLiteral("synclist:batch"))
+    {
+        reply["batchid"] = parameters.value(QStringLiteral("batchid"));
+
+        // all operations are applied or none
+        const QVariantList rows = resource->rows;
+        const QVariantMap metadata = resource->metadata;
+        QVariantList operations;
+        for(const QVariant& operation : parameters.value(QStringLiteral("operations")).toList())
+        {
+            const QVariantMap msg = operation.toMap();
+            const QString operationCommand = msg.value(QStringLiteral("command")).toString();
+            const QVariantMap operationParameters = msg.value(QStringLiteral("parameters")).toMap();
+            QVariantMap answer;
+            if(operationParameters.contains(QStringLiteral("opid")))
+                answer["opid"] = operationParameters.value(QStringLiteral("opid"));
+
+            if(!applySyncListChange(resource, operationCommand, operationParameters, answer))
+            {
+                resource->rows = rows;
+                resource->metadata = metadata;
+
+                QVariantMap failed;
+                failed["command"] = "synclist:batch:failed";
+                failed["errorstring"] = "Invalid operation " + operationCommand;
+                failed["parameters"] = reply;
+                send(connection, failed);
+                return;
+            }
+
+            QVariantMap result;
+            result["command"] = operationCommand;
+            result["parameters"] = answer;
+            operations << result;
+        }
+
+        reply["operations"] = operations;
+        publish(resource, command, reply, connection);
+        return;
+    }
+
+    QVariantMap answer = reply;
+    if(!applySyncListChange(resource, command, parameters, answer))
+    {
+        QVariantMap msg;
+        msg["command"] = command + ":failed";
+        msg["errorstring"] = "Unknown item";
+        msg["parameters"] = reply;
+        send(connection, msg);
+        return;
+    }
+
+    publish(resource, command, answer, connection);
+}
+
+bool LocalServer::applySyncListChange(Resource *resource, const QString &command, const QVariantMap &parameters, QVariantMap &answer)
+{
+    const QVariant data = parameters.value(QStringLiteral("data"));
+
+    if(command == QStringLiteral("synclist:append"))
+    {
+        QVariantMap item = syncListItem(QUuid::createUuid().toString(), data);
+        resource->rows.append(item);
+        answer["data"] = item;
+        return true;
+    }
+
+    if(command == QStringLiteral("synclist:appendlist"))
+    {
+        QVariantList items;
+        for(const QVariant& row : data.toList())
+        {
+            items << syncListItem(QUuid::createUuid().toString(), row);
+        }
+        resource->rows.append(items);
+        answer["data"] = items;
+        return true;
+    }
+
+    if(command == QStringLiteral("synclist:insertat"))
+    {
+        int index = qBound(0, parameters.value(QStringLiteral("index")).toInt(), resource->rows.count());
+        QVariantMap item = syncListItem(QUuid::createUuid().toString(), data);
+        resource->rows.insert(index, item);
+        answer["index"] = index;
+        answer["data"] = item;
+        return true;
+    }
+
+    if(command == QStringLiteral("synclist:clear") || command == QStringLiteral("synclist:delete"))
+    {
+        resource->rows.clear();
+        if(command == QStringLiteral("synclist:delete"))
+            resource->metadata.clear();
+
+        return true;
+    }
+
+    if(command == QStringLiteral("synclist:metadata:set"))
+    {
+        resource->metadata = parameters.value(QStringLiteral("metadata")).toMap();
+        answer["metadata"] = resource->metadata;
+        return true;
+    }
+
+    const QString uuid = parameters.value(QStringLiteral("uuid")).toString();
+    int index = indexOf(resource, uuid, parameters.value(QStringLiteral("index")).toInt());
+    if(index < 0)
+        return false;
+
+    if(command == QStringLiteral("synclist:set"))
+    {
+        QVariantMap item = syncListItem(uuid, data);
+        resource->rows.replace(index, item);
+        answer["index"] = index;
+        answer["uuid"] = uuid;
+        answer["data"] = item;
+        return true;
+    }
+
+    if(command == QStringLiteral("synclist:remove"))
+    {
+        resource->rows.removeAt(index);
+        answer["index"] = index;
+        answer["uuid"] = uuid;
+        return true;
+    }
+
+    if(command == QStringLiteral("synclist:property:set"))
+    {
+        const QString property = parameters.value(QStringLiteral("property")).toString();
+        const qint64 timestamp = QDateTime::currentMSecsSinceEpoch();
+        QVariantMap item = resource->rows.at(index).toMap();
+        QVariantMap row = item.value(QStringLiteral("data")).toMap();
+        row[property] = data;
+        item["data"] = row;
+        item["lastupdate"] = timestamp;
+        resource->rows.replace(index, item);
+        answer["index"] = index;
+        answer["uuid"] = uuid;
+        answer["property"] = property;
+        answer["data"] = data;
+        answer["lastupdate"] = timestamp;
+        return true;
+    }
+
+    return false;
+}
+
+void LocalServer::handleObject(VirtualConnection *connection, Resource *resource, const QString &command, const QVariantMap &parameters)
+{
+    if(command == QStringLiteral("object:filter"))
+    {
+        sendDump(connection, resource);
+        return;
+    }
+
+    if(command != QStringLiteral("object:property:set"))
+        return;
+
+    const QString property = parameters.value(QStringLiteral("property")).toString();
+    resource->properties[property] = parameters.value(QStringLiteral("data"));
+    publish(resource, command, parameters);
+
+    QVariantMap answer;
+    answer["property"] = property;
+
+    QVariantMap msg;
+    msg["command"] = "object:property:set:success";
+    msg["parameters"] = answer;
+    send(connection, msg);
+}
+
+void LocalServer::handleList(VirtualConnection *connection, Resource *resource, const QString &command, const QVariantMap &parameters)
+{
+    Q_UNUSED(connection)
+    const int index = parameters.value(QStringLiteral("index")).toInt();
+    const QVariant data = parameters.value(QStringLiteral("data"));
+
+    if(command == QStringLiteral("list:insertat"))
+    {
+        if(index < 0 || index > resource->rows.count())
+            return;
+
+        resource->rows.insert(index, data);
+        publish(resource, command, parameters);
+        return;
+    }
+
+    if(index < 0 || index >= resource->rows.count())
+        return;
+
+    if(command == QStringLiteral("list:property:set"))
+    {
+        QVariantMap row = resource->rows.at(index).toMap();
+        row[parameters.value(QStringLiteral("property")).toString()] = data;
+        resource->rows.replace(index, row);
+        publish(resource, command, parameters);
+        return;
+    }
+
+    if(command == QStringLiteral("list:set"))
+    {
+        resource->rows.replace(index, data);
+        publish(resource, command, parameters);
+        return;
+    }
+
+    if(command == QStringLiteral("list:remove"))
+    {
+        resource->rows.removeAt(index);
+        publish(resource, command, parameters);
+    }
+}
+
+void LocalServer::handleDevice(VirtualConnection *connection, Resource *resource, const QString &command, const QVariantMap &parameters)
+{
+    Q_UNUSED(connection)
+
+    if(command == QStringLiteral("device:setproperty"))
+    {
+        // the simulated device applies every requested value right away
+        const QString property = parameters.value(QStringLiteral("property")).toString();
+        const QVariant value = parameters.value(QStringLiteral("value"));
+        resource->properties[property] = value;
+
+        QVariantMap change;
+        change["real"] = value;
+        change["set"] = value;
+        change["dirty"] = false;
+        change["timestamp"] = QDateTime::currentMSecsSinceEpoch();
+
+        QVariantMap answer;
+        answer[property] = change;
+        publish(resource, QStringLiteral("device:prop:set"), answer);
+        return;
+    }
+
+    if(command == QStringLiteral("device:description"))
+    {
+        resource->metadata["desc"] = parameters.value(QStringLiteral("desc"));
+        publish(resource, command, parameters);
+        return;
+    }
+
+    if(command == QStringLiteral("device:meta:set"))
+        publish(resource, command, parameters);
+}
+
+void LocalServer::attach(VirtualConnection *connection, const QString &type, const QString &descriptor)
+{
+    detach(connection, false);
+
+    QVariantMap msg;
+    if(descriptor.isEmpty() || (type != QStringLiteral("synclist") && type != QStringLiteral("object")
+            && type != QStringLiteral("list") && type != QStringLiteral("device")))
+    {
+        msg["command"] = type + ":attach:failed";
+        msg["errorstring"] = "Unknown resource";
+        send(connection, msg);
+        return;
+    }
+
+    Resource* attached = resource(type, descriptor);
+    attached->subscribers.append(connection);
+    _attachments.insert(connection, attached);
+
+    msg["command"] = type + ":attach:success";
+    send(connection, msg);
+    sendDump(connection, attached);
+}
+
+void LocalServer::detach(VirtualConnection *connection, bool answer)
+{
+    Resource* resource = _attachments.take(connection);
+    if(!resource)
+        return;
+
+    resource->subscribers.removeAll(connection);
+    if(!answer)
+        return;
+
+    QVariantMap msg;
+    msg["command"] = resource->type + ":detach:success";
+    send(connection, msg);
+}
+
+void LocalServer::sendDump(VirtualConnection *connection, Resource *resource)
+{
+    QVariantMap parameters;
+    QVariantMap msg;
+    msg["command"] = resource->type + ":dump";
+
+    if(resource->type == QStringLiteral("synclist"))
+    {
+        parameters["metadata"] = resource->metadata;
+        if(_lazyLists)
+        {
+            parameters["count"] = resource->rows.count();
+            msg["command"] = "synclist:init";
+        }
+        else
+        {
+            parameters["data"] = resource->rows;
+        }
+    }
+    else if(resource->type == QStringLiteral("list"))
+    {
+        parameters["data"] = resource->rows;
+    }
+    else if(resource->type == QStringLiteral("object"))
+    {
+        QVariantMap data;
+        QMapIterator<QString, QVariant> it(resource->properties);
+        while(it.hasNext())
+        {
+            it.next();
+            QVariantMap property;
+            property["data"] = it.value();
+            data[it.key()] = property;
+        }
+
+        parameters["data"] = data;
+        parameters["metadata"] = resource->metadata;
+    }
+    else if(resource->type == QStringLiteral("device"))
+    {
+        QVariantList properties;
+        QMapIterator<QString, QVariant> it(resource->properties);
+        while(it.hasNext())
+        {
+            it.next();
+            QVariantMap property;
+            property["name"] = it.key();
+            property["val"] = it.value();
+            property["setVal"] = it.value();
+            property["dirty"] = false;
+            property["timestamp"] = QDateTime::currentMSecsSinceEpoch();
+            properties << property;
+        }
+
+        parameters["props"] = properties;
+        parameters["funcs"] = QVariantList();
+        parameters["on"] = true;
+        parameters["desc"] = resource->metadata.value(QStringLiteral("desc"));
+        parameters["uuid"] = resource->metadata.value(QStringLiteral("uuid"));
+        parameters["suid"] = resource->metadata.value(QStringLiteral("suid"));
+        parameters["type"] = "LocalDevice";
+        parameters["tmp"] = false;
+    }
+
+    msg["parameters"] = parameters;
+    send(connection, msg);
+}
+
+LocalServer::Resource *LocalServer::resource(const QString &type, const QString &descriptor)
+{
+    const QString key = type + "/" + descriptor;
+    Resource* resource = _resources.value(key, nullptr);
+    if(resource)
+        return resource;
+
+    resource = new Resource;
+    resource->type = type;
+    resource->descriptor = descriptor;
+    _resources.insert(key, resource);
+
+    // the content only depends on the seed, the descriptor and the sizes
+    QRandomGenerator random(_seed ^ qHash(key));
+    if(type == QStringLiteral("synclist") || type == QStringLiteral("list"))
+    {
+        resource->rows.reserve(_listSize);
+        for(int i = 0; i < _listSize; i++)
+        {
+            QVariantMap row = generateRow(random, i);
+            if(type == QStringLiteral("list"))
+                resource->rows << row;
+            else
+                resource->rows << syncListItem(QUuid::createUuidV5(QUuid(), key + "/" + QString::number(i)).toString(), row);
+        }
+        return resource;
+    }
+
+    for(int i = 0; i < _propertyCount; i++)
+    {
+        QString name = QStringLiteral("property%1").arg(i);
+        if(i % 2)
+            resource->properties[name] = generateText(random);
+        else
+            resource->properties[name] = random.generateDouble() * 100;
+    }
+
+    if(type == QStringLiteral("device"))
+    {
+        const QString uuid = QUuid::createUuidV5(QUuid(), key).toString();
+        resource->metadata["uuid"] = uuid;
+        resource->metadata["suid"] = uuid.mid(1, 8);
+        resource->metadata["desc"] = descriptor;
+    }
+
+    return resource;
+}
+
+QVariantMap LocalServer::generateRow(QRandomGenerator &random, int index) const
+{
+    QVariantMap row;
+    row["id"] = index;
+    row["name"] = QStringLiteral("Item %1").arg(index);
+    row["value"] = random.generateDouble() * 100;
+    row["flag"] = random.bounded(2) == 1;
+    row["text"] = generateText(random);
+    for(int i = 0; i < _fieldCount; i++)
+    {
+        row[QStringLiteral("field%1").arg(i)] = int(random.bounded(1000));
+    }
+    return row;
+}
+
+QString LocalServer::generateText(QRandomGenerator &random) const
+{
+    QString text;
+    text.reserve(_textLength);
+    for(int i = 0; i < _textLength; i++)
+    {
+        text.append(QChar('a' + int(random.bounded(26))));
+    }
+    return text;
+}
+
+QVariantMap LocalServer::syncListItem(const QString &uuid, const QVariant &data) const
+{
+    QVariantMap item;
+    item["uuid"] = uuid;
+    item["userid"] = "localserver";
+    item["lastupdate"] = QDateTime::currentMSecsSinceEpoch();
+    item["data"] = data;
+    return item;
+}
+
+int LocalServer::indexOf(Resource *resource, const QString &uuid, int index) const
+{
+    if(uuid.isEmpty())
+        return index >= 0 && index < resource->rows.count() ? index : -1;
+
+    if(index >= 0 && index < resource->rows.count() && resource->rows.at(index).toMap().value(QStringLiteral("uuid")).toString() == uuid)
+        return index;
+
+    for(int i = 0; i < resource->rows.count(); i++)
+    {
+        if(resource->rows.at(i).toMap().value(QStringLiteral("uuid")).toString() == uuid)
+            return i;
+    }
+
+    return -1;
+}
+
+void LocalServer::publish(Resource *resource, const QString &command, const QVariantMap &parameters, VirtualConnection *sender)
+{
+    QVariantMap msg;
+    msg["command"] = command;
+    msg["parameters"] = parameters;
+
+    for(VirtualConnection* subscriber : qAsConst(resource->subscribers))
+    {
+        // the client which asked for the change gets a reply
+        if(sender)
+            msg["reply"] = subscriber == sender;
+
+        send(subscriber, msg);
+    }
+}
+
+void LocalServer::send(VirtualConnection *connection, const QVariantMap &msg)
+{
+    if(_replies)
+    {
+        (*_replies)[connection] << msg;
+        return;
+    }
+
+    _messagesSent++;
+    if(_latency <= 0)
+    {
+        connection->sendVariant(msg);
+        return;
+    }
+
+    // timers with the same interval fire in the order they were started
+    QTimer::singleShot(_latency, connection, [=](){
+        connection->sendVariant(msg);
+    });
+}
+
+void LocalServer::sendUpdates()
+{
+    QList<Resource*> attached;
+    for(Resource* resource : qAsConst(_resources))
+    {
+        if(!resource->subscribers.isEmpty())
+            attached << resource;
+    }
+
+    // nothing is owed while no one listens
+    if(attached.isEmpty())
+    {
+        _updateClock.restart();
+        _updateBase = _updatesSent;
+        return;
+    }
+
+    // at most one second worth of updates is sent at once after a stall
+    qint64 due = qint64(_updateRate) * _updateClock.elapsed() / 1000 - (_updatesSent - _updateBase);
+    due = qMin(due, qint64(_updateRate));
+    for(qint64 i = 0; i < due; i++)
+    {
+        update(attached.at(int(_random.bounded(attached.count()))));
+        _updatesSent++;
+    }
+}
+
+void LocalServer::update(Resource *resource)
+{
+    const double value = _random.generateDouble() * 100;
+    const qint64 timestamp = QDateTime::currentMSecsSinceEpoch();
+    QVariantMap parameters;
+
+    if(resource->type == QStringLiteral("synclist") || resource->type == QStringLiteral("list"))
+    {
+        if(resource->rows.isEmpty())
+            return;
+
+        int index = int(_random.bounded(resource->rows.count()));
+        QVariantMap item = resource->rows.at(index).toMap();
+        parameters["index"] = index;
+        parameters["property"] = "value";
+        parameters["data"] = value;
+
+        if(resource->type == QStringLiteral("list"))
+        {
+            item["value"] = value;
+            resource->rows.replace(index, item);
+            publish(resource, QStringLiteral("list:property:set"), parameters);
+            return;
+        }
+
+        QVariantMap row = item.value(QStringLiteral("data")).toMap();
+        row["value"] = value;
+        item["data"] = row;
+        item["lastupdate"] = timestamp;
+        resource->rows.replace(index, item);
+        parameters["uuid"] = item.value(QStringLiteral("uuid"));
+        parameters["lastupdate"] = timestamp;
+        publish(resource, QStringLiteral("synclist:property:set"), parameters);
+        return;
+    }
+
+    if(_propertyCount == 0)
+        return;
+
+    // even properties are the numeric ones
+    const QString property = QStringLiteral("property%1").arg(2 * int(_random.bounded((_propertyCount + 1) / 2)));
+    resource->properties[property] = value;
+
+    if(resource->type == QStringLiteral("object"))
+    {
+        parameters["property"] = property;
+        parameters["data"] = value;
+        publish(resource, QStringLiteral("object:property:set"), parameters);
+        return;
+    }
+
+    QVariantMap change;
+    change["real"] = value;
+    change["timestamp"] = timestamp;
+    parameters[property] = change;
+    publish(resource, QStringLiteral("device:prop:set"), parameters);
+}
@@ -0,0 +1,176 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * It is part of the QuickHub framework - www.quickhub.org
+ * Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de */
+
+
+#ifndef LOCALSERVER_H
+#define LOCALSERVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QVariant>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+
+class QWebSocketServer;
+class Connection;
+class VirtualConnection;
+
+/*!
+    \class LocalServer
+    \brief An in-process stand-in for a QuickHub server.
+
+    LocalServer accepts websocket connections on the loopback interface and speaks the
+    subset of the protocol this module uses: the connection handshake, user:login and the
+    synclist, object, list and device resources as well as service calls. synclist:batch
+    applies all of its operations or none. Subchannels of a multiplexed virtual connection
+    are served like virtual connections of their own, attach:many attaches several of them
+    with one request. It uses the same Connection and VirtualConnection classes as the
+    client, so codec negotiation, batching, compression and fragmentation behave like they
+    do against a real server.
+
+    Resources are created on their first attach and filled with generated rows. The data
+    only depends on the seed, the descriptor and the configured sizes, so two runs with the
+    same configuration see exactly the same traffic. While resources are attached, the
+    server changes random properties at the configured update rate. Every message the
+    server sends is delayed by the configured latency.
+
+    Service calls are answered with their arguments.
+*/
+
+class LocalServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit    LocalServer(QObject *parent = nullptr);
+                ~LocalServer();
+
+    /*!
+        \fn bool LocalServer::listen(quint16 port)
+        Starts listening on the loopback interface. A port of 0 picks a free one,
+        url() returns the address to connect to.
+    */
+    bool        listen(quint16 port = 0);
+    void        close();
+    bool        isListening() const;
+    quint16     port() const;
+    QString     url() const;
+
+    /*!
+        \fn void LocalServer::setListSize(int rows)
+        Number of rows of generated synclist and list resources.
+    */
+    void        setListSize(int rows);
+    int         listSize() const;
+    void        setPropertyCount(int properties);
+    int         propertyCount() const;
+
+    /*!
+        \fn void LocalServer::setFieldCount(int fields)
+        Number of fields per generated row in addition to id, name, value and flag.
+    */
+    void        setFieldCount(int fields);
+    int         fieldCount() const;
+    void        setTextLength(int length);
+    int         textLength() const;
+
+    /*!
+        \fn void LocalServer::setUpdateRate(int updates)
+        Number of property changes per second the server spreads over all attached resources.
+        0 disables the updates.
+    */
+    void        setUpdateRate(int updates);
+    int         updateRate() const;
+
+    /*!
+        \fn void LocalServer::setLatency(int latency)
+        Delays every message the server sends by latency milliseconds.
+    */
+    void        setLatency(int latency);
+    int         latency() const;
+
+    /*!
+        \fn void LocalServer::setLazyLists(bool lazy)
+        If enabled, synclists announce their size with synclist:init and the client fetches
+        the rows, otherwise the whole list is sent with synclist:dump right after the attach.
+    */
+    void        setLazyLists(bool lazy);
+    bool        lazyLists() const;
+    void        setSeed(quint32 seed);
+
+    /*!
+        \fn QVariantMap LocalServer::getStatistics() const
+        Returns the number of connections and of messages and updates sent and received.
+    */
+    QVariantMap getStatistics() const;
+
+signals:
+    void        clientConnected();
+    void        clientDisconnected();
+
+private:
+    struct Resource
+    {
+        QString         type;
+        QString         descriptor;
+        QVariantList    rows;
+        QVariantMap     properties;
+        QVariantMap     metadata;
+        QList<VirtualConnection*> subscribers;
+    };
+
+    void        handleMessage(VirtualConnection* connection, const QVariantMap& msg);
+    void        handleLogin(VirtualConnection* connection, const QVariantMap& msg);
+    void        handleAttachMany(VirtualConnection* connection, const QVariantMap& msg);
+    void        handleCall(VirtualConnection* connection, const QString& command, const QVariantMap& msg);
+    void        handleSyncList(VirtualConnection* connection, Resource* resource, const QString& command, const QVariantMap& parameters);
+    bool        applySyncListChange(Resource* resource, const QString& command, const QVariantMap& parameters, QVariantMap& answer);
+    void        handleObject(VirtualConnection* connection, Resource* resource, const QString& command, const QVariantMap& parameters);
+    void        handleList(VirtualConnection* connection, Resource* resource, const QString& command, const QVariantMap& parameters);
+    void        handleDevice(VirtualConnection* connection, Resource* resource, const QString& command, const QVariantMap& parameters);
+
+    void        attach(VirtualConnection* connection, const QString& type, const QString& descriptor);
+    void        detach(VirtualConnection* connection, bool answer = true);
+    void        sendDump(VirtualConnection* connection, Resource* resource);
+    Resource*   resource(const QString& type, const QString& descriptor);
+    QVariantMap generateRow(QRandomGenerator& random, int index) const;
+    QVariantMap syncListItem(const QString& uuid, const QVariant& data) const;
+    QString     generateText(QRandomGenerator& random) const;
+    int         indexOf(Resource* resource, const QString& uuid, int index) const;
+    void        publish(Resource* resource, const QString& command, const QVariantMap& parameters, VirtualConnection* sender = nullptr);
+    void        send(VirtualConnection* connection, const QVariantMap& msg);
+    void        update(Resource* resource);
+
+    QWebSocketServer*                   _server = nullptr;
+    QList<Connection*>                  _connections;
+    QHash<QString, Resource*>           _resources;
+    QHash<VirtualConnection*, Resource*> _attachments;
+    QHash<VirtualConnection*, QVariantList>* _replies = nullptr;
+    QTimer                              _updateTimer;
+    QElapsedTimer                       _updateClock;
+    quint32                             _seed = 1;
+    QRandomGenerator                    _random;
+    int                                 _listSize = 1000;
+    int                                 _propertyCount = 20;
+    int                                 _fieldCount = 4;
+    int                                 _textLength = 16;
+    int                                 _updateRate = 0;
+    int                                 _latency = 0;
+    bool                                _lazyLists = false;
+    qint64                              _updatesSent = 0;
+    qint64                              _updateBase = 0;
+    qint64                              _messagesSent = 0;
+    qint64                              _messagesReceived = 0;
+
+private slots:
+    void        newConnection();
+    void        newVirtualConnection(VirtualConnection* connection);
+    void        virtualConnectionDestroyed();
+    void        sendUpdates();
+};
+
+#endif // LOCALSERVER_H
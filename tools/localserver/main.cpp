@@ -0,0 +1,60 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ * It is part of the QuickHub framework - www.quickhub.org
+ * Copyright (C) 2021 by Friedemann Metzger - mail@friedemann-metzger.de */
+
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QJsonDocument>
+#include <QTimer>
+#include <QDebug>
+#include "LocalServer.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("qhlocalserver");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("In-process QuickHub server stand-in for load and latency tests.");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"port", "Port to listen on, 0 picks a free one.", "port", "0"},
+        {"rows", "Rows of generated synclist and list resources.", "rows", "1000"},
+        {"properties", "Properties of generated object and device resources.", "properties", "20"},
+        {"fields", "Additional fields per generated row.", "fields", "4"},
+        {"text", "Length of generated text values.", "length", "16"},
+        {"rate", "Property updates per second over all attached resources.", "updates", "0"},
+        {"latency", "Delay of every message sent in milliseconds.", "ms", "0"},
+        {"seed", "Seed of the generated data.", "seed", "1"},
+        {"lazy", "Announce synclists with synclist:init instead of a dump."},
+        {"stats", "Print statistics every given milliseconds, 0 disables them.", "ms", "0"}
+    });
+    parser.process(app);
+
+    LocalServer server;
+    server.setSeed(parser.value("seed").toUInt());
+    server.setListSize(parser.value("rows").toInt());
+    server.setPropertyCount(parser.value("properties").toInt());
+    server.setFieldCount(parser.value("fields").toInt());
+    server.setTextLength(parser.value("text").toInt());
+    server.setLatency(parser.value("latency").toInt());
+    server.setLazyLists(parser.isSet("lazy"));
+
+    if(!server.listen(quint16(parser.value("port").toUInt())))
+        return 1;
+
+    server.setUpdateRate(parser.value("rate").toInt());
+    qInfo().noquote()<<"Listening on"<<server.url();
+
+    QTimer stats;
+    QObject::connect(&stats, &QTimer::timeout, [&](){
+        qInfo().noquote()<<QJsonDocument::fromVariant(server.getStatistics()).toJson(QJsonDocument::Compact);
+    });
+    if(parser.value("stats").toInt() > 0)
+        stats.start(parser.value("stats").toInt());
+
+    return app.exec();
+}